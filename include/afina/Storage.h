@@ -1,7 +1,11 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 
@@ -27,8 +31,9 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param deadline expiration time of the association, see Expire
      */
-    virtual bool Put(const std::string &key, const std::string &value) = 0;
+    virtual bool Put(const std::string &key, const std::string &value, int64_t deadline = 0) = 0;
 
     /**
      * Stores association between given key/value pair if key isn't present in
@@ -40,8 +45,9 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param deadline expiration time of the association, see Expire
      */
-    virtual bool PutIfAbsent(const std::string &key, const std::string &value) = 0;
+    virtual bool PutIfAbsent(const std::string &key, const std::string &value, int64_t deadline = 0) = 0;
 
     /**
      * Updates existing association between given key/value pair
@@ -53,8 +59,48 @@ public:
      *
      * @param key to be associated with value
      * @param value to be assigned for the key
+     * @param deadline expiration time of the association, see Expire
      */
-    virtual bool Set(const std::string &key, const std::string &value) = 0;
+    virtual bool Set(const std::string &key, const std::string &value, int64_t deadline = 0) = 0;
+
+    /**
+     * Adds value to the end of the existing association, expiration time stays the same. Value
+     * is changed in one step, so concurrent appends to the same key are never lost
+     *
+     * Method returns false if key isn't present, result is too large or storage doesn't
+     * support that
+     *
+     * @param key to append value to
+     * @param value to be added
+     */
+    virtual bool Append(const std::string &key, const std::string &value) { return false; }
+
+    /**
+     * Adds value to the beginning of the existing association, see Append
+     *
+     * @param key to prepend value to
+     * @param value to be added
+     */
+    virtual bool Prepend(const std::string &key, const std::string &value) { return false; }
+
+    /**
+     * Changes value of the association in one step, so concurrent read-modify-write of the same
+     * key is never lost. Update gets current value and whether key is present, missing key comes
+     * with empty value. It changes value in place and returns false to leave storage untouched.
+     * Existing association keeps its expiration time, new one lives forever
+     *
+     * Update is called at most once, under the storage lock, so it must be fast and must not
+     * touch the storage
+     *
+     * Method returns true if value is stored, false if update refused, result is too large or
+     * storage doesn't support that
+     *
+     * @param key to change value of
+     * @param update function to change value with
+     */
+    virtual bool Modify(const std::string &key, const std::function<bool(std::string &value, bool found)> &update) {
+        return false;
+    }
 
     /**
      * Removes association for the given key
@@ -84,6 +130,63 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    /**
+     * Sets expiration time of the existing association. Once deadline passes association is
+     * considered to be deleted. Put, PutIfAbsent and Set replace expiration time with the
+     * given one, so value and its deadline are stored at once
+     *
+     * Method returns false if key isn't present or storage doesn't support expiration
+     *
+     * @param key to set expiration time for
+     * @param deadline unix time in seconds, 0 means association never expires
+     */
+    virtual bool Expire(const std::string &key, int64_t deadline) { return false; }
+
+    /**
+     * Retrive expiration time of the association, see Expire. Method returns false if key
+     * isn't present, deadline is left untouched then
+     *
+     * @param key to retrive expiration time for
+     * @param deadline output parameter, 0 if association never expires
+     */
+    virtual bool GetExpire(const std::string &key, int64_t &deadline) { return false; }
+
+    /**
+     * Removes all associations existing at the given moment. Storage might drop them lazily,
+     * so memory isn't necessary freed right away, but none of them is visible since then
+     *
+     * @param at unix time in seconds, 0 means right now
+     */
+    virtual void Flush(int64_t at) {}
+
+    /**
+     * Incrementally iterates over keys present in storage. Each call appends up to count keys
+     * found after the position encoded in the cursor and updates cursor to point just after
+     * the last returned key. Iteration starts from the empty cursor and it is complete once
+     * empty cursor gets returned back. Storage could stop early to not block others for long,
+     * so even empty page doesn't mean iteration is over.
+     *
+     * Cursor is an opaque string without spaces. Keys which are present in storage for the
+     * whole iteration are returned exactly once, keys added or removed meanwhile might or might
+     * not be returned.
+     *
+     * Method returns false if cursor is malformed or storage doesn't support iteration
+     *
+     * @param cursor position to continue iteration from, updated on return
+     * @param count maximum number of keys to return, must be positive
+     * @param keys output parameter to append found keys to
+     */
+    virtual bool Scan(std::string &cursor, std::size_t count, std::vector<std::string> &keys) { return false; }
+
+    /**
+     * Appends storage statistics to the given list as name/value pairs. Names follow the
+     * "stats" command of memcached protocol where it is possible. Method is called rarely
+     * and might be expensive, but it must not block storage for a long time
+     *
+     * @param stats output parameter to append statistics to
+     */
+    virtual void Stats(std::vector<std::pair<std::string, std::string>> &stats) {}
 };
 
 } // namespace Afina
@@ -5,15 +5,23 @@
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <deque>
 #include <string>
 #include <thread>
+#include <vector>
+
+#include <afina/metrics/Registry.h>
 
 namespace Afina {
 namespace Concurrency {
 
 /**
  * # Thread pool
+ * Runs tasks on the fixed number of threads in the order they were added. Task is supposed to
+ * handle its own errors, exception escaping it is dropped so that pool thread survives.
+ *
+ * Pool reports "<name>_threads", "<name>_queue" and "<name>_tasks" (completed ones) metrics,
+ * pools with the same name share them.
  */
 class Executor {
     enum class State {
@@ -28,6 +36,10 @@ class Executor {
         kStopped
     };
 
+public:
+    /**
+     * Starts size threads, throws std::runtime_error unless there is at least one
+     */
     Executor(std::string name, int size);
     ~Executor();
 
@@ -57,6 +69,7 @@ class Executor {
 
         // Enqueue new task
         tasks.push_back(exec);
+        queue_size->inc();
         empty_condition.notify_one();
         return true;
     }
@@ -97,6 +110,13 @@ private:
      * Flag to stop bg threads
      */
     State state;
+
+    /**
+     * Metrics of the pool
+     */
+    std::shared_ptr<Metrics::Gauge> pool_threads;
+    std::shared_ptr<Metrics::Gauge> queue_size;
+    std::shared_ptr<Metrics::Counter> tasks_done;
 };
 
 } // namespace Concurrency
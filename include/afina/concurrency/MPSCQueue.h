@@ -0,0 +1,96 @@
+#ifndef AFINA_CONCURRENCY_MPSC_QUEUE_H
+#define AFINA_CONCURRENCY_MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Bounded lock-free queue
+ * Any number of threads could push into the queue, but only one is allowed to pop out of it.
+ * Each cell carries a sequence number telling whose turn it is: producer claims the cell by
+ * moving the tail with CAS and then publishes data with the sequence, so consumer never sees
+ * half written cell. Push fails rather than waits if the queue is full.
+ *
+ * Capacity must be a power of two.
+ */
+template <typename T> class MPSCQueue {
+public:
+    explicit MPSCQueue(std::size_t capacity) : _buffer(new Cell[capacity]), _mask(capacity - 1), _tail(0), _head(0) {
+        if (capacity == 0 || (capacity & _mask) != 0) {
+            throw std::runtime_error("Queue capacity must be a power of two");
+        }
+        for (std::size_t i = 0; i < capacity; i++) {
+            _buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPSCQueue(const MPSCQueue &) = delete;
+    MPSCQueue &operator=(const MPSCQueue &) = delete;
+
+    /**
+     * Adds value to the end of the queue, returns false if there is no room for it.
+     * Safe to call from any thread
+     */
+    bool push(const T &value) {
+        std::size_t pos = _tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = _buffer[pos & _mask];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                // Cell is free, but another producer could take it first
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // Consumer hasn't taken value out of the cell yet
+                return false;
+            } else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Takes value from the front of the queue, returns false if it is empty.
+     * Must be called by the single consumer thread only
+     */
+    bool pop(T &value) {
+        Cell &cell = _buffer[_head & _mask];
+        if (cell.sequence.load(std::memory_order_acquire) != _head + 1) {
+            return false;
+        }
+
+        value = std::move(cell.data);
+        cell.sequence.store(_head + _mask + 1, std::memory_order_release);
+        _head++;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> _buffer;
+    const std::size_t _mask;
+
+    // Producers and consumer touch different ends, so they are kept on different cache lines
+    alignas(64) std::atomic<std::size_t> _tail;
+    alignas(64) std::size_t _head;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_MPSC_QUEUE_H
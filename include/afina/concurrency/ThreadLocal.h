@@ -1,10 +1,102 @@
 #ifndef AFINA_CONCURRENCY_THREAD_LOCAL_H
 #define AFINA_CONCURRENCY_THREAD_LOCAL_H
 
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+
+#include <pthread.h>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class ThreadLocal {};
+/**
+ * # Object with a private copy of T for each thread
+ * Unlike thread_local keyword it could be a non-static class member, so that each
+ * instance of the owner gets its own set of per-thread values.
+ *
+ * Value gets default constructed on the first access from a thread and destroyed
+ * once that thread exits or once ThreadLocal is destroyed, whichever comes first.
+ * ThreadLocal must not be destroyed while other threads are still using it.
+ */
+template <typename T> class ThreadLocal {
+public:
+    ThreadLocal() {
+        if (pthread_key_create(&_key, &ThreadLocal::on_thread_exit) != 0) {
+            throw std::runtime_error("Failed to create thread local key");
+        }
+    }
+
+    ~ThreadLocal() {
+        pthread_key_delete(_key);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (slot *s : _slots) {
+            delete s;
+        }
+    }
+
+    /**
+     * Returns value owned by the calling thread
+     */
+    T &get() {
+        slot *s = static_cast<slot *>(pthread_getspecific(_key));
+        if (s != nullptr) {
+            return s->value;
+        }
+
+        s = new slot(this);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _slots.insert(s);
+        }
+        if (pthread_setspecific(_key, s) != 0) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _slots.erase(s);
+            delete s;
+            throw std::runtime_error("Failed to set thread local value");
+        }
+        return s->value;
+    }
+
+    /**
+     * Calls given function for values of all threads. Values are still in use by their
+     * threads, so function must only touch parts of T that are safe to read concurrently
+     */
+    template <typename F> void for_each(F func) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (slot *s : _slots) {
+            func(s->value);
+        }
+    }
+
+private:
+    ThreadLocal(const ThreadLocal &) = delete;
+    ThreadLocal &operator=(const ThreadLocal &) = delete;
+
+    struct slot {
+        explicit slot(ThreadLocal *o) : owner(o), value() {}
+
+        ThreadLocal *owner;
+        T value;
+    };
+
+    static void on_thread_exit(void *p) {
+        slot *s = static_cast<slot *>(p);
+        std::lock_guard<std::mutex> lock(s->owner->_mutex);
+        s->owner->_slots.erase(s);
+        delete s;
+    }
+
+    // Key to find value of the current thread
+    pthread_key_t _key;
+
+    // Protects list of values below
+    std::mutex _mutex;
+
+    // Values of all threads ever called get(), used to cleanup and aggregate
+    std::unordered_set<slot *> _slots;
+};
 
 } // namespace Concurrency
 } // namespace Afina
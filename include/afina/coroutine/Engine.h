@@ -15,6 +15,10 @@ namespace Coroutine {
 /**
  * # Entry point of coroutine library
  * Allows to run coroutine and schedule its execution. Not threadsafe
+ *
+ * Routines share the stack of the thread: on every switch stack of the current routine is copied
+ * aside and the next one is copied back in place. So routines must not pass each other pointers
+ * to objects living on their stacks, such objects belong to the heap or to the caller of start
  */
 class Engine final {
 public:
@@ -42,6 +46,9 @@ private:
         // To include routine in the different lists, such as "alive", "blocked", e.t.c
         struct context *prev = nullptr;
         struct context *next = nullptr;
+
+        // Which of the lists routine is in
+        bool blocked = false;
     } context;
 
     /**
@@ -89,7 +96,8 @@ protected:
 
 public:
     Engine(unblocker_func unblocker = null_unblocker)
-        : StackBottom(0), cur_routine(nullptr), alive(nullptr), _unblocker(unblocker) {}
+        : StackBottom(0), cur_routine(nullptr), alive(nullptr), blocked(nullptr), idle_ctx(nullptr),
+          _unblocker(unblocker) {}
     Engine(Engine &&) = delete;
     Engine(const Engine &) = delete;
 
@@ -145,7 +153,8 @@ public:
 
         idle_ctx = new context();
         if (setjmp(idle_ctx->Environment) > 0) {
-            if (alive == nullptr) {
+            // Nothing to wait for once all routines are done
+            if (alive == nullptr && blocked != nullptr) {
                 _unblocker(*this);
             }
 
@@ -203,7 +212,7 @@ public:
             // current coroutine finished, and the pointer is not relevant now
             cur_routine = nullptr;
             pc->prev = pc->next = nullptr;
-            delete std::get<0>(pc->Stack);
+            delete[] std::get<0>(pc->Stack);
             delete pc;
 
             // We cannot return here, as this function "returned" once already, so here we must select some other
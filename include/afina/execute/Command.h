@@ -1,6 +1,7 @@
 #ifndef AFINA_EXECUTE_COMMAND_H
 #define AFINA_EXECUTE_COMMAND_H
 
+#include <cstdint>
 #include <string>
 
 namespace Afina {
@@ -10,8 +11,9 @@ class Storage;
 namespace Execute {
 
 /**
- *
- *
+ * # Command of the text protocol
+ * Execute writes response into the output without the last \r\n, networking layer adds it.
+ * Command might leave output empty, then nothing is sent back to the client at all
  */
 class Command {
 public:
@@ -21,6 +23,13 @@ public:
     virtual void Execute(Storage &storage, const std::string &args, std::string &out) = 0;
 };
 
+/**
+ * Converts memcached exptime into the storage deadline, see Storage::Expire. Zero means item
+ * never expires, values up to 30 days are offsets from now and the larger ones are unix time.
+ * Negative exptime makes item expired right away
+ */
+int64_t Deadline(int32_t exptime);
+
 } // namespace Execute
 } // namespace Afina
 
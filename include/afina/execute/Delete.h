@@ -1,6 +1,9 @@
 #ifndef AFINA_EXECUTE_DELETE_H
 #define AFINA_EXECUTE_DELETE_H
 
+#include <cstddef>
+#include <string>
+
 #include "Command.h"
 
 namespace Afina {
@@ -11,16 +14,28 @@ namespace Execute {
  * Delete existing key from the cache. If key not found then command does
  * nothing
  *
+ * delete <key> [noreply]\r\n
+ *
  * Command must write result to the output, which could be:
  * - "DELETED" to indicate success
  * - "NOT_FOUND" to indicate that the item with this key was not found
  */
 class Delete : public Command {
 public:
-    Delete();
-    ~Delete();
+    Delete(const std::string &key) : _key(key) {}
+    ~Delete() {}
+
+    inline const std::string &key() const { return _key; }
+
+    /**
+     * Reuse command for another request, memory of the key is reused if it is large enough
+     */
+    inline void Assign(const char *key, std::size_t size) { _key.assign(key, size); }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string _key;
 };
 
 } // namespace Execute
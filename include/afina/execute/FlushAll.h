@@ -0,0 +1,38 @@
+#ifndef AFINA_EXECUTE_FLUSH_ALL_H
+#define AFINA_EXECUTE_FLUSH_ALL_H
+
+#include <cstdint>
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Remove all items
+ * Invalidates all items existing at the moment or after the given delay. Storage reclaims
+ * their memory lazily, so command takes the same time no matter how many items are there
+ *
+ * flush_all [delay] [noreply]\r\n
+ *
+ * Command must write result to the output, which is always "OK"
+ */
+class FlushAll : public Command {
+public:
+    FlushAll(uint32_t delay) : _delay(delay) {}
+    ~FlushAll() {}
+
+    inline uint32_t delay() const { return _delay; }
+    inline void Assign(uint32_t delay) { _delay = delay; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    uint32_t _delay;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_FLUSH_ALL_H
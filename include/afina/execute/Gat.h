@@ -0,0 +1,41 @@
+#ifndef AFINA_EXECUTE_GAT_H
+#define AFINA_EXECUTE_GAT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Get.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Retrive values and update their expiration time
+ * Works just like get, but each found item gets new exptime first, so clients could keep
+ * hot items alive without sending them again
+ *
+ * gat <exptime> <key>*\r\n
+ * gats <exptime> <key>*\r\n
+ *
+ * Response is the same as for get and gets respectively
+ */
+class Gat : public Get {
+public:
+    Gat(const std::vector<std::string> &keys, int32_t expire, bool cas = false) : Get(keys, cas), _expire(expire) {}
+    ~Gat() {}
+
+    inline int32_t expire() const { return _expire; }
+    inline void SetExpire(int32_t expire) { _expire = expire; }
+
+protected:
+    bool Fetch(Storage &storage, const std::string &key, std::string &value) override;
+
+private:
+    int32_t _expire;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_GAT_H
@@ -1,6 +1,7 @@
 #ifndef AFINA_EXECUTE_GET_H
 #define AFINA_EXECUTE_GET_H
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -31,18 +32,63 @@ namespace Execute {
  * hold items with such keys (because they were never stored, or stored
  * but deleted to make space for more items, or expired, or explicitly
  * deleted by a client).
+ *
+ * "gets" is the same command, but each item line carries CAS unique as well. CAS isn't
+ * supported by the storage, so it is always 0
  */
 class Get : public Command {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    /**
+     * # Destination of the found items
+     * Values could be large, so instead of being copied into the command output they are handed
+     * over to the connection one by one and could be sent right from there
+     */
+    class Output {
+    public:
+        virtual ~Output() {}
+
+        /**
+         * Queues item line followed by the value and \r\n. Value could be taken away by swap, so
+         * its content is unspecified after the call
+         */
+        virtual void Item(const std::string &header, std::string &value) = 0;
+    };
+
+    Get(const std::vector<std::string> &keys, bool cas = false) : _keys(keys), _cas(cas) {}
     ~Get() {}
 
     inline const std::vector<std::string> &keys() const { return _keys; }
+    inline bool cas() const { return _cas; }
+
+    /**
+     * Reuse command for another request. Command keeps count keys, each one has to be assigned
+     * using key(i) so that memory of the strings gets reused
+     */
+    inline void Resize(std::size_t count) { _keys.resize(count); }
+    inline std::string &key(std::size_t i) { return _keys[i]; }
+    inline void SetCas(bool cas) { _cas = cas; }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
-private:
+    /**
+     * Same as above, but found items go to the given output and only the final END is written
+     * to out
+     */
+    void Execute(Storage &storage, const std::string &args, std::string &out, Output &items);
+
+protected:
+    // Reads value of the key, returns false if item should be skipped
+    virtual bool Fetch(Storage &storage, const std::string &key, std::string &value);
+
+    // Formats item line without the data block
+    void Header(std::string &out, const std::string &key, std::size_t size) const;
+
     std::vector<std::string> _keys;
+    bool _cas;
+
+    // Memory of both is reused between requests
+    std::string _header;
+    std::string _value;
 };
 
 } // namespace Execute
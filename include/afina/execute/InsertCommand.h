@@ -1,6 +1,7 @@
 #ifndef AFINA_EXECUTE_INSERT_COMMAND_H
 #define AFINA_EXECUTE_INSERT_COMMAND_H
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
@@ -22,10 +23,19 @@ public:
     inline const uint32_t flags() const { return _flags; }
     inline const int32_t expire() const { return _expire; }
 
+    /**
+     * Reuse command for another request, memory of the key is reused if it is large enough
+     */
+    inline void Assign(const char *key, std::size_t size, uint32_t flags, int32_t expire) {
+        _key.assign(key, size);
+        _flags = flags;
+        _expire = expire;
+    }
+
 protected:
-    const std::string _key;
-    const uint32_t _flags;
-    const int32_t _expire;
+    std::string _key;
+    uint32_t _flags;
+    int32_t _expire;
 };
 
 } // namespace Execute
@@ -0,0 +1,92 @@
+#ifndef AFINA_EXECUTE_META_COMMAND_H
+#define AFINA_EXECUTE_META_COMMAND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Flags of a meta command
+ * Each flag is a single letter, optionally followed by argument. Flags without arguments
+ * are kept as a bit mask, the ones with arguments are kept in separate fields
+ */
+struct MetaFlags {
+    MetaFlags() { Clear(); }
+
+    inline void Clear() {
+        mask = 0;
+        opaque.clear();
+        client_flags = 0;
+        ttl = 0;
+        mode = 'S';
+    }
+
+    inline static uint64_t bit(char flag) {
+        if (flag >= 'a' && flag <= 'z') {
+            return uint64_t(1) << (flag - 'a');
+        } else if (flag >= 'A' && flag <= 'Z') {
+            return uint64_t(1) << (flag - 'A' + 26);
+        }
+        return 0;
+    }
+
+    inline bool has(char flag) const { return (mask & bit(flag)) != 0; }
+    inline void set(char flag) { mask |= bit(flag); }
+
+    // Flags seen in the command, with or without argument
+    uint64_t mask;
+
+    // O: opaque token returned back as is
+    std::string opaque;
+
+    // F: client flags to store
+    uint32_t client_flags;
+
+    // T: time to live in seconds
+    int32_t ttl;
+
+    // M: set mode, one of E(add), A(append), P(prepend), R(replace), S(set)
+    char mode;
+};
+
+/**
+ * # Basic class for all meta commands
+ * Meta commands share key and flags. Response line consists of a two letters code followed
+ * by return flags requested by the client. In quiet mode (q flag) the common response is
+ * omitted, so command leaves output empty and nothing is sent back
+ */
+class MetaCommand : public Command {
+public:
+    MetaCommand(const std::string &key, const MetaFlags &flags) : _key(key), _flags(flags) {}
+    ~MetaCommand() {}
+
+    inline const std::string &key() const { return _key; }
+    inline const MetaFlags &flags() const { return _flags; }
+
+    /**
+     * Reuse command for another request, memory of the key is reused if it is large enough
+     */
+    inline void Assign(const char *key, std::size_t size, const MetaFlags &flags) {
+        _key.assign(key, size);
+        _flags = flags;
+    }
+
+protected:
+    /**
+     * Appends return flags which don't depend on the command: k and O
+     */
+    void AppendFlags(std::string &out) const;
+
+    std::string _key;
+    MetaFlags _flags;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_COMMAND_H
@@ -0,0 +1,35 @@
+#ifndef AFINA_EXECUTE_META_DELETE_H
+#define AFINA_EXECUTE_META_DELETE_H
+
+#include <string>
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Remove the key
+ * md <key> <flags>*\r\n
+ *
+ * Supported flags:
+ * - k: return key
+ * - O<token>: return opaque token
+ * - q: don't answer, whether key was removed or not
+ *
+ * Command must write result to the output, which could be:
+ * - "HD <flags>*" if key was removed
+ * - "NF <flags>*" if there was no such key
+ */
+class MetaDelete : public MetaCommand {
+public:
+    MetaDelete(const std::string &key, const MetaFlags &flags) : MetaCommand(key, flags) {}
+    ~MetaDelete() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_DELETE_H
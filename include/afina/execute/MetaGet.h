@@ -0,0 +1,42 @@
+#ifndef AFINA_EXECUTE_META_GET_H
+#define AFINA_EXECUTE_META_GET_H
+
+#include <string>
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Retrieve value and its metadata
+ * mg <key> <flags>*\r\n
+ *
+ * Supported flags:
+ * - v: return value
+ * - s: return value size
+ * - k: return key
+ * - O<token>: return opaque token
+ * - f: return client flags
+ * - c: return CAS value
+ * - t: return remaining TTL, -1 if item never expires
+ * - T<ttl>: update TTL of the item
+ * - q: don't answer on miss
+ *
+ * Command must write result to the output, which could be:
+ * - "VA <size> <flags>*\r\n<data>" if value was asked for
+ * - "HD <flags>*" on hit without value
+ * - "EN" on miss
+ */
+class MetaGet : public MetaCommand {
+public:
+    MetaGet(const std::string &key, const MetaFlags &flags) : MetaCommand(key, flags) {}
+    ~MetaGet() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_GET_H
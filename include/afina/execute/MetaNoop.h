@@ -0,0 +1,29 @@
+#ifndef AFINA_EXECUTE_META_NOOP_H
+#define AFINA_EXECUTE_META_NOOP_H
+
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Do nothing
+ * mn\r\n
+ *
+ * Always answers "MN". Clients put it after a batch of quiet meta commands, once it is
+ * answered all the commands before are done
+ */
+class MetaNoop : public Command {
+public:
+    MetaNoop() {}
+    ~MetaNoop() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_NOOP_H
@@ -0,0 +1,39 @@
+#ifndef AFINA_EXECUTE_META_SET_H
+#define AFINA_EXECUTE_META_SET_H
+
+#include <string>
+
+#include "MetaCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Store value for the key
+ * ms <key> <datalen> <flags>*\r\n
+ * <data block>\r\n
+ *
+ * Supported flags:
+ * - M<mode>: E to add, A to append, P to prepend, R to replace, S to set (default)
+ * - F<flags>: client flags
+ * - T<ttl>: time to live
+ * - k: return key
+ * - O<token>: return opaque token
+ * - q: don't answer on success
+ *
+ * Command must write result to the output, which could be:
+ * - "HD <flags>*" if value was stored
+ * - "NS <flags>*" if value wasn't stored because the mode condition wasn't met
+ */
+class MetaSet : public MetaCommand {
+public:
+    MetaSet(const std::string &key, const MetaFlags &flags) : MetaCommand(key, flags) {}
+    ~MetaSet() {}
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_META_SET_H
@@ -0,0 +1,61 @@
+#ifndef AFINA_EXECUTE_SCAN_H
+#define AFINA_EXECUTE_SCAN_H
+
+#include <cstddef>
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Iterate over keys in the cache
+ * Returns next page of keys starting from the given cursor. Cursor "0" starts
+ * new iteration, every response carries cursor to continue from, once "0" gets
+ * returned iteration is complete. Each call locks only small part of the storage
+ * so the whole cache could be walked without stopping other clients.
+ *
+ * scan <cursor> [<count>]\r\n
+ *
+ * Response looks like this:
+ * KEY <key>\r\n
+ * KEY ....
+ * CURSOR <next cursor>\r\n
+ * END
+ *
+ * In case of malformed cursor "CLIENT_ERROR bad cursor" returned
+ */
+class Scan : public Command {
+public:
+    // Page size used if client doesn't ask for a specific one
+    static constexpr std::size_t kDefaultCount = 100;
+
+    // Upper bound for the page size, keeps each step short
+    static constexpr std::size_t kMaxCount = 10000;
+
+    Scan(const std::string &cursor, std::size_t count) : _cursor(cursor), _count(count) {}
+    ~Scan() {}
+
+    inline const std::string &cursor() const { return _cursor; }
+    inline std::size_t count() const { return _count; }
+
+    /**
+     * Reuse command for another request, memory of the cursor is reused if it is large enough
+     */
+    inline void Assign(const char *cursor, std::size_t size, std::size_t count) {
+        _cursor.assign(cursor, size);
+        _count = count;
+    }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string _cursor;
+    std::size_t _count;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_SCAN_H
@@ -1,18 +1,50 @@
 #ifndef AFINA_EXECUTE_STATS_H
 #define AFINA_EXECUTE_STATS_H
 
+#include <cstddef>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "Command.h"
 
 namespace Afina {
 namespace Execute {
 
+/**
+ * # Server statistics
+ * Renders process statistics, server wide metrics (see Metrics::Registry) and storage
+ * statistics in memcached format
+ *
+ * stats [items|slabs]\r\n
+ *
+ * Each statistic is sent as "STAT <name> <value>\r\n", list is terminated by "END". Storage
+ * keeps values outside of any slab allocator, so "items" and "slabs" describe it as a single
+ * slab class.
+ */
 class Stats : public Command {
 public:
-    Stats() {}
+    Stats(const std::string &group = std::string()) : _group(group) {}
     ~Stats() {}
+
+    inline const std::string &group() const { return _group; }
+
+    /**
+     * Reuse command for another request, empty group means general statistics
+     */
+    inline void Assign(const char *group, std::size_t size) { _group.assign(group, size); }
+
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+    /**
+     * Appends statistics of the group as name/value pairs: empty group for the general ones,
+     * "items" or "slabs". Returns false if group is unknown
+     */
+    static bool Collect(Storage &storage, const std::string &group,
+                        std::vector<std::pair<std::string, std::string>> &stats);
+
+private:
+    std::string _group;
 };
 
 } // namespace Execute
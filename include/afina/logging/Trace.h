@@ -0,0 +1,87 @@
+#ifndef AFINA_LOGGING_TRACE_H
+#define AFINA_LOGGING_TRACE_H
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include <spdlog/logger.h>
+
+#include <afina/logging/Config.h>
+
+/**
+ * Trace points more verbose than this level are compiled out, see Logger::Level. By default only
+ * INFO and above are kept, so request tracing costs nothing at all
+ */
+#ifndef AFINA_TRACE_LEVEL
+#define AFINA_TRACE_LEVEL 3
+#endif
+
+/**
+ * Writes trace message if the request is sampled. Arguments are evaluated for sampled requests
+ * only, whole statement is removed by the compiler if lvl is above AFINA_TRACE_LEVEL
+ */
+#define AFINA_TRACE(trace, lvl, ...)                                                                                   \
+    do {                                                                                                               \
+        if (AFINA_TRACE_LEVEL >= Afina::Logging::Logger::lvl && (trace).Sample()) {                                    \
+            (trace).Log(Afina::Logging::Logger::lvl, __VA_ARGS__);                                                     \
+        }                                                                                                              \
+    } while (0)
+
+namespace Afina {
+namespace Logging {
+
+/**
+ * # Sampled tracing of the requests
+ * Writing every request into the log takes a lock and formats a message per command, which caps
+ * the throughput way below what server could do. Instead only every rate-th request passing the
+ * trace point is written. Counter isn't shared, so each connection keeps its own trace.
+ */
+class Trace {
+public:
+    // Tracing is off
+    Trace() : _rate(0), _counter(0) {}
+
+    Trace(std::shared_ptr<spdlog::logger> logger, uint32_t rate)
+        : _logger(std::move(logger)), _rate(_logger ? rate : 0), _counter(0) {}
+
+    // True if the current request should be traced
+    inline bool Sample() {
+        if (_rate == 0 || ++_counter < _rate) {
+            return false;
+        }
+        _counter = 0;
+        return true;
+    }
+
+    template <typename... Args> void Log(Logger::Level level, const char *fmt, const Args &... args) {
+        _logger->log(convert(level), fmt, args...);
+    }
+
+private:
+    static spdlog::level::level_enum convert(Logger::Level level) {
+        switch (level) {
+        case Logger::Level::TRACE:
+            return spdlog::level::trace;
+        case Logger::Level::DEBUG:
+            return spdlog::level::debug;
+        case Logger::Level::INFO:
+            return spdlog::level::info;
+        case Logger::Level::WARNING:
+            return spdlog::level::warn;
+        case Logger::Level::ERROR:
+            return spdlog::level::err;
+        default:
+            return spdlog::level::critical;
+        }
+    }
+
+    std::shared_ptr<spdlog::logger> _logger;
+    uint32_t _rate;
+    uint32_t _counter;
+};
+
+} // namespace Logging
+} // namespace Afina
+
+#endif // AFINA_LOGGING_TRACE_H
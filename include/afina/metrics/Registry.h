@@ -0,0 +1,149 @@
+#ifndef AFINA_METRICS_REGISTRY_H
+#define AFINA_METRICS_REGISTRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Metrics {
+
+/**
+ * # Monotonic counter with many writers
+ * Counter is split into stripes, each thread adds to its own one, so threads updating the same
+ * counter don't fight for the cache line. Reader sums all stripes up, value it gets is
+ * consistent only for each stripe separately, which is fine for statistics.
+ */
+class Counter {
+public:
+    static constexpr std::size_t kStripes = 16;
+
+    Counter() {
+        for (auto &stripe : _stripes) {
+            stripe.value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    inline void add(uint64_t delta) { _stripes[stripe()].value.fetch_add(delta, std::memory_order_relaxed); }
+    inline void inc() { add(1); }
+
+    uint64_t get() const {
+        uint64_t sum = 0;
+        for (auto &stripe : _stripes) {
+            sum += stripe.value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+private:
+    // Threads take stripes round robin once in their lifetime
+    static inline std::size_t stripe() {
+        static std::atomic<std::size_t> next(0);
+        static thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % kStripes;
+        return index;
+    }
+
+    struct Stripe {
+        std::atomic<uint64_t> value;
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    Stripe _stripes[kStripes];
+};
+
+/**
+ * # Current value of something
+ * Gauges are changed when things come and go (connections, tasks), which is rare enough for a
+ * single atomic
+ */
+class Gauge {
+public:
+    Gauge() : _value(0) {}
+
+    inline void add(int64_t delta) { _value.fetch_add(delta, std::memory_order_relaxed); }
+    inline void inc() { add(1); }
+    inline void dec() { add(-1); }
+    inline void set(int64_t value) { _value.store(value, std::memory_order_relaxed); }
+    inline int64_t get() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> _value;
+};
+
+/**
+ * # Server wide metrics
+ * Components register counters and gauges by name once and keep them, so updating a metric
+ * never touches the registry. Values which are cheaper to compute on demand are provided by
+ * collectors called at render time. Registry lock is taken only to register something or to
+ * render the metrics, hot path doesn't take it.
+ *
+ * Metrics are rendered by group: the general one has empty name, memcached "stats <group>"
+ * asks for the others. Counters and gauges belong to the general group.
+ */
+class Registry {
+public:
+    using Values = std::vector<std::pair<std::string, std::string>>;
+    using Collector = std::function<void(Values &)>;
+
+    /**
+     * Registry of the process, lives until process exits
+     */
+    static Registry &Instance();
+
+    /**
+     * Returns counter with the given name, it is created on the first call. Components asking
+     * for the same name share the counter
+     */
+    std::shared_ptr<Counter> GetCounter(const std::string &name);
+
+    /**
+     * Returns gauge with the given name, see GetCounter
+     */
+    std::shared_ptr<Gauge> GetGauge(const std::string &name);
+
+    /**
+     * Adds collector of the group, owner is used to remove it later
+     */
+    void AddCollector(const std::string &group, const void *owner, Collector collector);
+
+    /**
+     * Removes all collectors of the owner
+     */
+    void RemoveCollectors(const void *owner);
+
+    /**
+     * Appends metrics of the group as name/value pairs in order of registration
+     */
+    void Render(const std::string &group, Values &values) const;
+
+private:
+    struct Metric {
+        std::string name;
+        std::shared_ptr<Counter> counter;
+        std::shared_ptr<Gauge> gauge;
+    };
+
+    struct Source {
+        std::string group;
+        const void *owner;
+        Collector collector;
+    };
+
+    // Finds metric by name, nullptr if there is no such metric
+    Metric *find(const std::string &name);
+
+    mutable std::mutex _mutex;
+    std::vector<Metric> _metrics;
+    std::vector<Source> _collectors;
+};
+
+} // namespace Metrics
+} // namespace Afina
+
+#endif // AFINA_METRICS_REGISTRY_H
@@ -1,16 +1,23 @@
 #ifndef AFINA_NETWORK_SERVER_H
 #define AFINA_NETWORK_SERVER_H
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
+#include <afina/logging/Service.h>
+#include <afina/logging/Trace.h>
+
 namespace Afina {
 class Storage;
-namespace Logging {
-class Service;
-}
 namespace Network {
 
+/**
+ * Wire protocol clients of the listener speak. Memcached text and binary protocols are told
+ * apart by the first byte, so both of them are served on the same listener
+ */
+enum class ProtocolType { Memcached, Resp };
+
 /**
  * # Network processors coordinator
  * Configure resources for the network processors and coordinates all work
@@ -21,6 +28,17 @@ public:
         : pStorage(ps), pLogging(pl) {}
     virtual ~Server() {}
 
+    /**
+     * Selects protocol of the listener, must be called before Start
+     */
+    void SetProtocol(ProtocolType type) { protocol = type; }
+
+    /**
+     * Traces every rate-th request of each connection into the "trace" logger, 0 turns tracing
+     * off. Must be called before Start
+     */
+    void SetTraceRate(uint32_t rate) { trace_rate = rate; }
+
     /**
      * Starts network service. After method returns process should
      * listen on the given interface/port pair to process  incomming
@@ -55,6 +73,23 @@ protected:
      * Logging service to be used in order to report application progress
      */
     std::shared_ptr<Afina::Logging::Service> pLogging;
+
+    /**
+     * Protocol every new connection is served with
+     */
+    ProtocolType protocol = ProtocolType::Memcached;
+
+    /**
+     * Every trace_rate-th request of the connection is traced
+     */
+    uint32_t trace_rate = 0;
+
+    /**
+     * Request trace for the new connection
+     */
+    Logging::Trace NewTrace() const {
+        return trace_rate == 0 ? Logging::Trace() : Logging::Trace(pLogging->select("trace"), trace_rate);
+    }
 };
 
 } // namespace Network
@@ -1,5 +1,82 @@
 #include <afina/concurrency/Executor.h>
 
+#include <stdexcept>
+#include <utility>
+
 namespace Afina {
-namespace Concurrency {}
+namespace Concurrency {
+
+void perform(Executor *executor);
+
+// See Executor.h
+Executor::Executor(std::string name, int size)
+    : state(State::kRun), pool_threads(Metrics::Registry::Instance().GetGauge(name + "_threads")),
+      queue_size(Metrics::Registry::Instance().GetGauge(name + "_queue")),
+      tasks_done(Metrics::Registry::Instance().GetCounter(name + "_tasks")) {
+    // Tasks accepted by the pool without threads would never run
+    if (size <= 0) {
+        throw std::runtime_error("Executor requires at least one thread");
+    }
+    pool_threads->add(size);
+    threads.reserve(size);
+    for (int i = 0; i < size; i++) {
+        threads.emplace_back(perform, this);
+    }
+}
+
+// See Executor.h
+Executor::~Executor() { Stop(true); }
+
+// See Executor.h
+void Executor::Stop(bool await) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (state == State::kRun) {
+            state = State::kStopping;
+        }
+        empty_condition.notify_all();
+    }
+
+    if (await) {
+        for (auto &thread : threads) {
+            if (thread.joinable()) {
+                thread.join();
+                pool_threads->dec();
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        state = State::kStopped;
+    }
+}
+
+// See Executor.h
+void perform(Executor *executor) {
+    std::function<void()> task;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(executor->mutex);
+            while (executor->tasks.empty() && executor->state == Executor::State::kRun) {
+                executor->empty_condition.wait(lock);
+            }
+
+            // Queue is drained only once pool is stopping
+            if (executor->tasks.empty()) {
+                return;
+            }
+            task = std::move(executor->tasks.front());
+            executor->tasks.pop_front();
+        }
+        executor->queue_size->dec();
+
+        try {
+            task();
+        } catch (...) {
+            // Task has to report its errors by itself
+        }
+        executor->tasks_done->inc();
+    }
+}
+
+} // namespace Concurrency
 } // namespace Afina
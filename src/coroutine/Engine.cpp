@@ -7,13 +7,148 @@
 namespace Afina {
 namespace Coroutine {
 
-void Engine::Store(context &ctx) {}
+// Stack of the frame copying coroutine stack back must be at least that far from it
+static constexpr std::ptrdiff_t kRestoreGap = 4096;
 
-void Engine::Restore(context &ctx) {}
+// See Engine.h
+void Engine::Store(context &ctx) {
+    // Stack grows down, so everything from here up to the bottom belongs to the current routine
+    char StackEndsHere;
+    ctx.Low = &StackEndsHere;
+    ctx.Hight = StackBottom;
 
-void Engine::yield() {}
+    uint32_t size = ctx.Hight - ctx.Low;
+    char *&buffer = std::get<0>(ctx.Stack);
+    uint32_t &capacity = std::get<1>(ctx.Stack);
+    if (capacity < size) {
+        delete[] buffer;
+        buffer = new char[size];
+        capacity = size;
+    }
+    memcpy(buffer, ctx.Low, size);
+}
 
-void Engine::sched(void *routine_) {}
+// See Engine.h
+void Engine::Restore(context &ctx) {
+    // Copying stack back would overwrite the frame doing it, so go deeper first. Padding is used
+    // after the call, so compiler can't turn recursion into a loop
+    char StackEndsHere;
+    if (&StackEndsHere + kRestoreGap > ctx.Low) {
+        volatile char padding[kRestoreGap / 4];
+        padding[0] = 0;
+        Restore(ctx);
+        padding[0]++;
+    }
+
+    memcpy(ctx.Low, std::get<0>(ctx.Stack), ctx.Hight - ctx.Low);
+    longjmp(ctx.Environment, 1);
+}
+
+// See Engine.h
+void Engine::yield() {
+    // Routines take turns, the one after the current goes next
+    context *next = alive;
+    if (cur_routine != nullptr && !cur_routine->blocked && cur_routine->next != nullptr) {
+        next = cur_routine->next;
+    }
+    if (next == cur_routine) {
+        next = nullptr;
+    }
+
+    if (next != nullptr) {
+        sched(next);
+        return;
+    }
+
+    // Nobody else could run. Blocked routine waits in the engine for someone to unblock it
+    if (cur_routine != nullptr && cur_routine->blocked) {
+        if (setjmp(cur_routine->Environment) > 0) {
+            return;
+        }
+        Store(*cur_routine);
+        cur_routine = nullptr;
+        Restore(*idle_ctx);
+    }
+}
+
+// See Engine.h
+void Engine::sched(void *routine_) {
+    context *routine = static_cast<context *>(routine_);
+    if (routine == nullptr) {
+        yield();
+        return;
+    } else if (routine == cur_routine || routine->blocked) {
+        return;
+    }
+
+    // Current routine goes on from here once it is scheduled back. Engine itself has no context
+    // to save, it always starts over from the idle one
+    if (cur_routine != nullptr) {
+        if (setjmp(cur_routine->Environment) > 0) {
+            return;
+        }
+        Store(*cur_routine);
+    }
+
+    cur_routine = routine;
+    Restore(*routine);
+}
+
+// See Engine.h
+void Engine::block(void *coro) {
+    context *routine = coro == nullptr ? cur_routine : static_cast<context *>(coro);
+    if (routine == nullptr || routine->blocked) {
+        return;
+    }
+
+    // Move from alive to blocked
+    if (routine->prev != nullptr) {
+        routine->prev->next = routine->next;
+    } else {
+        alive = routine->next;
+    }
+    if (routine->next != nullptr) {
+        routine->next->prev = routine->prev;
+    }
+
+    routine->prev = nullptr;
+    routine->next = blocked;
+    if (blocked != nullptr) {
+        blocked->prev = routine;
+    }
+    blocked = routine;
+    routine->blocked = true;
+
+    if (routine == cur_routine) {
+        yield();
+    }
+}
+
+// See Engine.h
+void Engine::unblock(void *coro) {
+    context *routine = static_cast<context *>(coro);
+    if (routine == nullptr || !routine->blocked) {
+        return;
+    }
+
+    // Move from blocked to alive
+    if (routine->prev != nullptr) {
+        routine->prev->next = routine->next;
+    } else {
+        blocked = routine->next;
+    }
+    if (routine->next != nullptr) {
+        routine->next->prev = routine->prev;
+    }
+
+    routine->prev = nullptr;
+    routine->next = alive;
+    if (alive != nullptr) {
+        alive->prev = routine;
+    }
+    alive = routine;
+    routine->blocked = false;
+}
 
 } // namespace Coroutine
 } // namespace Afina
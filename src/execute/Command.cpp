@@ -1 +1,24 @@
 #include <afina/execute/Command.h>
+
+#include <ctime>
+
+namespace Afina {
+namespace Execute {
+
+// Larger exptime is considered to be absolute unix time
+static constexpr int32_t kMaxRelativeExptime = 60 * 60 * 24 * 30;
+
+// See Command.h
+int64_t Deadline(int32_t exptime) {
+    if (exptime == 0) {
+        return 0;
+    } else if (exptime < 0) {
+        return 1; // long gone
+    } else if (exptime > kMaxRelativeExptime) {
+        return exptime;
+    }
+    return static_cast<int64_t>(std::time(nullptr)) + exptime;
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,15 @@
+#include <afina/Storage.h>
+#include <afina/execute/FlushAll.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "flush_all" invalidates all existing items, with delay it happens once
+// the given time comes. Delay has the same format as exptime
+void FlushAll::Execute(Storage &storage, const std::string &args, std::string &out) {
+    storage.Flush(_delay == 0 ? 0 : Deadline(_delay));
+    out.assign("OK");
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,14 @@
+#include <afina/Storage.h>
+#include <afina/execute/Gat.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "gat" is get and touch in one go, missing keys are skipped
+bool Gat::Fetch(Storage &storage, const std::string &key, std::string &value) {
+    // Value is fetched first, item touched with negative exptime is still returned once
+    return storage.Get(key, value) && storage.Expire(key, Deadline(_expire));
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -1,10 +1,6 @@
 #include <afina/Storage.h>
 #include <afina/execute/Get.h>
 
-#include <iostream>
-#include <iterator>
-#include <sstream>
-
 namespace Afina {
 namespace Execute {
 
@@ -22,22 +18,39 @@ to indicate the end of response.
 */
 
 void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::stringstream keyStream;
-    copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
-    std::cout << "Get(" << keyStream.str() << ")" << std::endl;
-
-    std::stringstream outStream;
+    // Response is built right in the output, so its memory gets reused between commands
+    out.clear();
+    for (auto &key : _keys) {
+        if (!Fetch(storage, key, _value))
+            continue;
+        Header(out, key, _value.size());
+        out.append(_value).append("\r\n");
+    }
+    out.append("END"); // networking layer should add the last \r\n
+}
 
-    std::string value;
+// See Get.h
+void Get::Execute(Storage &storage, const std::string &args, std::string &out, Output &items) {
     for (auto &key : _keys) {
-        if (!storage.Get(key, value))
+        if (!Fetch(storage, key, _value))
             continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+        _header.clear();
+        Header(_header, key, _value.size());
+        items.Item(_header, _value);
     }
-    outStream << "END"; // networking layer should add the last \r\n
+    out.assign("END");
+}
 
-    out = outStream.str();
+// See Get.h
+bool Get::Fetch(Storage &storage, const std::string &key, std::string &value) { return storage.Get(key, value); }
+
+// See Get.h
+void Get::Header(std::string &out, const std::string &key, std::size_t size) const {
+    out.append("VALUE ").append(key).append(" 0 ").append(std::to_string(size));
+    if (_cas) {
+        out.append(" 0");
+    }
+    out.append("\r\n");
 }
 
 } // namespace Execute
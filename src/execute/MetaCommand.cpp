@@ -0,0 +1,17 @@
+#include <afina/execute/MetaCommand.h>
+
+namespace Afina {
+namespace Execute {
+
+// See MetaCommand.h
+void MetaCommand::AppendFlags(std::string &out) const {
+    if (_flags.has('k')) {
+        out.append(" k").append(_key);
+    }
+    if (_flags.has('O')) {
+        out.append(" O").append(_flags.opaque);
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
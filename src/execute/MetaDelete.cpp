@@ -0,0 +1,20 @@
+#include <afina/Storage.h>
+#include <afina/execute/MetaDelete.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached meta protocol: "md" removes the item, quiet mode answers neither HD nor NF
+void MetaDelete::Execute(Storage &storage, const std::string &args, std::string &out) {
+    bool deleted = storage.Delete(_key);
+
+    out.clear();
+    if (_flags.has('q')) {
+        return;
+    }
+    out.assign(deleted ? "HD" : "NF");
+    AppendFlags(out);
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,63 @@
+#include <afina/Storage.h>
+#include <afina/execute/MetaGet.h>
+
+#include <algorithm>
+#include <ctime>
+
+namespace Afina {
+namespace Execute {
+
+// memcached meta protocol: "mg" returns whatever parts of the item client asked for
+void MetaGet::Execute(Storage &storage, const std::string &args, std::string &out) {
+    out.clear();
+
+    std::string value;
+    if (!storage.Get(_key, value)) {
+        if (!_flags.has('q')) {
+            out.assign("EN");
+        }
+        return;
+    }
+
+    int64_t deadline = 0;
+    if (_flags.has('T')) {
+        deadline = Deadline(_flags.ttl);
+        storage.Expire(_key, deadline);
+    } else if (_flags.has('t')) {
+        storage.GetExpire(_key, deadline);
+    }
+
+    bool with_value = _flags.has('v');
+    if (with_value) {
+        out.append("VA ").append(std::to_string(value.size()));
+    } else {
+        out.append("HD");
+    }
+
+    // Neither client flags nor CAS are stored
+    if (_flags.has('c')) {
+        out.append(" c0");
+    }
+    if (_flags.has('f')) {
+        out.append(" f0");
+    }
+    if (_flags.has('s')) {
+        out.append(" s").append(std::to_string(value.size()));
+    }
+    if (_flags.has('t')) {
+        if (deadline == 0) {
+            out.append(" t-1");
+        } else {
+            int64_t now = static_cast<int64_t>(std::time(nullptr));
+            out.append(" t").append(std::to_string(std::max<int64_t>(deadline - now, 0)));
+        }
+    }
+    AppendFlags(out);
+
+    if (with_value) {
+        out.append("\r\n").append(value); // networking layer should add the last \r\n
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
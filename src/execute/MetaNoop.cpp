@@ -0,0 +1,10 @@
+#include <afina/execute/MetaNoop.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached meta protocol: "mn" is answered right away, used to terminate pipelines
+void MetaNoop::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("MN"); }
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,43 @@
+#include <afina/Storage.h>
+#include <afina/execute/MetaSet.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached meta protocol: "ms" stores data, mode tells which of set/add/replace/append/prepend
+void MetaSet::Execute(Storage &storage, const std::string &args, std::string &out) {
+    bool stored = false;
+    int64_t deadline = _flags.has('T') ? Deadline(_flags.ttl) : 0;
+    switch (_flags.mode) {
+    case 'E':
+        stored = storage.PutIfAbsent(_key, args, deadline);
+        break;
+
+    case 'R':
+        stored = storage.Set(_key, args, deadline);
+        break;
+
+    case 'A':
+    case 'P':
+        // Item keeps its expiration time unless new one is given
+        stored = _flags.mode == 'A' ? storage.Append(_key, args) : storage.Prepend(_key, args);
+        if (stored && _flags.has('T')) {
+            storage.Expire(_key, deadline);
+        }
+        break;
+
+    default:
+        stored = storage.Put(_key, args, deadline);
+        break;
+    }
+
+    out.clear();
+    if (stored && _flags.has('q')) {
+        return;
+    }
+    out.assign(stored ? "HD" : "NS");
+    AppendFlags(out);
+}
+
+} // namespace Execute
+} // namespace Afina
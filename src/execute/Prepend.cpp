@@ -0,0 +1,14 @@
+#include <afina/Storage.h>
+#include <afina/execute/Prepend.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "prepend" means "add this data to an existing key before existing data".
+// Flags and exptime are ignored, item keeps its own expiration time
+void Prepend::Execute(Storage &storage, const std::string &args, std::string &out) {
+    out.assign(storage.Prepend(_key, args) ? "STORED" : "NOT_STORED");
+}
+
+} // namespace Execute
+} // namespace Afina
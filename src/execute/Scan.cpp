@@ -0,0 +1,32 @@
+#include <afina/Storage.h>
+#include <afina/execute/Scan.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace Afina {
+namespace Execute {
+
+constexpr std::size_t Scan::kDefaultCount;
+constexpr std::size_t Scan::kMaxCount;
+
+void Scan::Execute(Storage &storage, const std::string &args, std::string &out) {
+    // "0" is the public name for the empty storage cursor
+    std::string cursor = (_cursor == "0") ? "" : _cursor;
+
+    std::vector<std::string> keys;
+    if (!storage.Scan(cursor, std::min(_count, kMaxCount), keys)) {
+        out.assign("CLIENT_ERROR bad cursor");
+        return;
+    }
+
+    out.clear();
+    for (auto &key : keys) {
+        out.append("KEY ").append(key).append("\r\n");
+    }
+    out.append("CURSOR ").append(cursor.empty() ? "0" : cursor).append("\r\n");
+    out.append("END"); // networking layer should add the last \r\n
+}
+
+} // namespace Execute
+} // namespace Afina
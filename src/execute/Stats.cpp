@@ -1,14 +1,115 @@
 #include <afina/Storage.h>
 #include <afina/execute/Stats.h>
+#include <afina/metrics/Registry.h>
 
-#include <iostream>
-#include <iterator>
-#include <sstream>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/resource.h>
+#include <unistd.h>
 
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+// Static initialization happens right at the process start
+static const time_t process_started = time(nullptr);
+
+static std::string seconds(const struct timeval &tv) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%ld.%06ld", static_cast<long>(tv.tv_sec), static_cast<long>(tv.tv_usec));
+    return buffer;
+}
+
+// Each thread of the process is a directory in there
+static std::size_t count_threads() {
+    DIR *dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return 0;
+    }
+
+    std::size_t threads = 0;
+    while (struct dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            threads++;
+        }
+    }
+    closedir(dir);
+    return threads;
+}
+
+// Value of the storage statistic, zero if storage doesn't report it
+static std::string find(const std::vector<std::pair<std::string, std::string>> &stats, const char *name) {
+    for (auto &stat : stats) {
+        if (stat.first == name) {
+            return stat.second;
+        }
+    }
+    return "0";
+}
+
+// memcached protocol: each statistic is sent as "STAT <name> <value>\r\n", list is terminated
+// by "END\r\n"
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    Collect(storage, _group, stats);
+
+    out.clear();
+    for (auto &stat : stats) {
+        out.append("STAT ").append(stat.first).append(" ").append(stat.second).append("\r\n");
+    }
+    out.append("END"); // networking layer should add the last \r\n
+}
+
+// See Stats.h
+bool Stats::Collect(Storage &storage, const std::string &group,
+                    std::vector<std::pair<std::string, std::string>> &stats) {
+    auto &registry = Metrics::Registry::Instance();
+    if (group.empty()) {
+        time_t now = time(nullptr);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        stats.emplace_back("pid", std::to_string(getpid()));
+        stats.emplace_back("uptime", std::to_string(now - process_started));
+        stats.emplace_back("time", std::to_string(now));
+        stats.emplace_back("pointer_size", std::to_string(8 * sizeof(void *)));
+        stats.emplace_back("rusage_user", seconds(usage.ru_utime));
+        stats.emplace_back("rusage_system", seconds(usage.ru_stime));
+        stats.emplace_back("threads", std::to_string(count_threads()));
+        registry.Render(group, stats);
+        storage.Stats(stats);
+        return true;
+    } else if (group != "items" && group != "slabs") {
+        return false;
+    }
+
+    std::vector<std::pair<std::string, std::string>> storage_stats;
+    storage.Stats(storage_stats);
+    std::string items = find(storage_stats, "curr_items");
+    std::string bytes = find(storage_stats, "bytes");
+
+    // Just like memcached, classes without items aren't reported
+    if (items != "0") {
+        if (group == "items") {
+            stats.emplace_back("items:1:number", items);
+            stats.emplace_back("items:1:evicted", find(storage_stats, "evictions"));
+            stats.emplace_back("items:1:reclaimed", find(storage_stats, "expirations"));
+        } else {
+            stats.emplace_back("1:used_chunks", items);
+            stats.emplace_back("1:mem_requested", bytes);
+        }
+    }
+    if (group == "slabs") {
+        stats.emplace_back("active_slabs", items != "0" ? "1" : "0");
+        stats.emplace_back("total_malloced", bytes);
+    }
+    registry.Render(group, stats);
+    return true;
+}
 
 } // namespace Execute
 } // namespace Afina
@@ -12,17 +12,22 @@
 #include <afina/Storage.h>
 #include <afina/Version.h>
 #include <afina/logging/Service.h>
+#include <afina/logging/Trace.h>
+#include <afina/metrics/Registry.h>
 #include <afina/network/Server.h>
 
 #include "logging/ServiceImpl.h"
 #include "network/mt_blocking/ServerImpl.h"
+#include "network/mt_coroutine/ServerImpl.h"
 #include "network/mt_nonblocking/ServerImpl.h"
 #include "network/st_blocking/ServerImpl.h"
 #include "network/st_coroutine/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
+#include "network/uring/ServerImpl.h"
 
 #include "storage/SimpleLRU.h"
 #include "storage/StripedLRU.h"
+#include "storage/TieredLRU.h"
 #include "storage/ThreadSafeSimpleLRU.h"
 
 using namespace Afina;
@@ -44,6 +49,18 @@ public:
         logger.level = Logging::Logger::Level::WARNING;
         logger.appenders.push_back("console");
         logger.format = "[%H:%M:%S %z] [thread %t] [%n] [%l] %v";
+
+        // Sampled requests are written regardless of the root level
+        uint32_t trace_rate = 0;
+        if (options.count("trace_rate") > 0) {
+            trace_rate = options["trace_rate"].as<uint32_t>();
+        }
+        if (trace_rate > 0) {
+            Logging::Logger &trace = logConfig->loggers["trace"];
+            trace.level = Logging::Logger::Level::DEBUG;
+            trace.appenders.push_back("console");
+            trace.format = logger.format;
+        }
         logService.reset(new Logging::ServiceImpl(logConfig));
 
         // Step 1: configure storage
@@ -58,6 +75,12 @@ public:
             storage = std::make_shared<Afina::Backend::ThreadSafeSimpleLRU>();
         } else if (storage_type == "mt_slru") {
             storage = Afina::Backend::StripedLRU::BuildStripedLRU(1024*1024*1024, 4);
+        } else if (storage_type == "mt_tiered") {
+            std::string tier_dir = "/tmp";
+            if (options.count("tier_dir") > 0) {
+                tier_dir = options["tier_dir"].as<std::string>();
+            }
+            storage = std::make_shared<Afina::Backend::TieredLRU>(1024UL * 1024 * 1024, tier_dir, 10UL * 1024 * 1024 * 1024);
         }
         else {
             throw std::runtime_error("Unknown storage type");
@@ -69,18 +92,40 @@ public:
             network_type = options["network"].as<std::string>();
         }
 
-        if (network_type == "st_block") {
-            server = std::make_shared<Afina::Network::STblocking::ServerImpl>(storage, logService);
-        } else if (network_type == "mt_block") {
-            server = std::make_shared<Afina::Network::MTblocking::ServerImpl>(storage, logService);
-        } else if (network_type == "st_nonblock") {
-            server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService);
-        } else if (network_type == "mt_nonblock") {
-            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService);
-        } else if (network_type == "st_coroutine") {
-            server = std::make_shared<Afina::Network::STcoroutine::ServerImpl>(storage, logService);
-        } else {
-            throw std::runtime_error("Unknown network type");
+        port = 8080;
+        if (options.count("port") > 0) {
+            port = options["port"].as<uint16_t>();
+        }
+
+        acceptors = 0;
+        if (options.count("acceptors") > 0) {
+            acceptors = options["acceptors"].as<uint32_t>();
+        }
+
+        workers = 2;
+        if (options.count("workers") > 0) {
+            workers = options["workers"].as<uint32_t>();
+        }
+
+        std::string protocol = "memcached";
+        if (options.count("protocol") > 0) {
+            protocol = options["protocol"].as<std::string>();
+        }
+
+        server = BuildServer(network_type);
+        server->SetTraceRate(trace_rate);
+        if (protocol == "resp") {
+            server->SetProtocol(Network::ProtocolType::Resp);
+        } else if (protocol != "memcached") {
+            throw std::runtime_error("Unknown protocol");
+        }
+
+        // Optional second listener for redis clients, served by the same kind of network
+        if (options.count("resp_port") > 0) {
+            resp_port = options["resp_port"].as<uint16_t>();
+            resp_server = BuildServer(network_type);
+            resp_server->SetProtocol(Network::ProtocolType::Resp);
+            resp_server->SetTraceRate(trace_rate);
         }
     }
 
@@ -90,13 +135,23 @@ public:
         auto log = logService->select("root");
         log->warn("Start afina server {}", Afina::get_version());
 
+        if (logConfig->loggers.count("trace") > 0 && AFINA_TRACE_LEVEL < Logging::Logger::Level::DEBUG) {
+            log->warn("Request tracing is compiled out, rebuild with AFINA_TRACE_LEVEL=4");
+        }
+
+        Metrics::Registry::Instance().AddCollector(
+            "", this, [](Metrics::Registry::Values &values) { values.emplace_back("version", Afina::get_version()); });
+
         log->warn("Start storage");
         storage->Start();
 
-        // TODO: configure network service
-        const uint16_t port = 8080;
         log->warn("Start network on {}", port);
-        server->Start(port, 2, 2);
+        server->Start(port, acceptors, workers);
+
+        if (resp_server) {
+            log->warn("Start redis network on {}", resp_port);
+            resp_server->Start(resp_port, acceptors, workers);
+        }
     }
 
     // Stop services in correct order
@@ -104,18 +159,50 @@ public:
         auto log = logService->select("root");
         log->warn("Stop application");
         server->Stop();
+        if (resp_server) {
+            resp_server->Stop();
+        }
         server->Join();
+        if (resp_server) {
+            resp_server->Join();
+        }
 
         storage->Stop();
+        Metrics::Registry::Instance().RemoveCollectors(this);
         logService->Stop();
     }
 
 private:
+    std::shared_ptr<Network::Server> BuildServer(const std::string &network_type) {
+        if (network_type == "st_block") {
+            return std::make_shared<Afina::Network::STblocking::ServerImpl>(storage, logService);
+        } else if (network_type == "mt_block") {
+            return std::make_shared<Afina::Network::MTblocking::ServerImpl>(storage, logService);
+        } else if (network_type == "st_nonblock") {
+            return std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService);
+        } else if (network_type == "mt_nonblock") {
+            return std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService);
+        } else if (network_type == "st_coroutine") {
+            return std::make_shared<Afina::Network::STcoroutine::ServerImpl>(storage, logService);
+        } else if (network_type == "mt_coroutine") {
+            return std::make_shared<Afina::Network::MTcoroutine::ServerImpl>(storage, logService);
+        } else if (network_type == "uring") {
+            return std::make_shared<Afina::Network::Uring::ServerImpl>(storage, logService);
+        }
+        throw std::runtime_error("Unknown network type");
+    }
+
     std::shared_ptr<Logging::Config> logConfig;
     std::shared_ptr<Logging::Service> logService;
 
     std::shared_ptr<Afina::Storage> storage;
     std::shared_ptr<Network::Server> server;
+    uint16_t port;
+    uint32_t acceptors;
+    uint32_t workers;
+
+    std::shared_ptr<Network::Server> resp_server;
+    uint16_t resp_port;
 };
 
 // Signal set that to notify application about time to stop
@@ -136,6 +223,17 @@ int main(int argc, char **argv) {
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("p,port", "Port to listen on, 8080 by default", cxxopts::value<uint16_t>());
+        options.add_options()("protocol", "Protocol of the port: memcached (default) or resp",
+                              cxxopts::value<std::string>());
+        options.add_options()("resp_port", "Additional port speaking redis protocol", cxxopts::value<uint16_t>());
+        options.add_options()("tier_dir", "Directory for cold values of mt_tiered storage", cxxopts::value<std::string>());
+        options.add_options()("acceptors", "Number of threads accepting connections, 0 (default) lets workers do it",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("workers", "Number of threads serving connections, 2 by default",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("trace_rate", "Trace every Nth request of each connection, 0 (default) is off",
+                              cxxopts::value<uint32_t>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
@@ -0,0 +1,86 @@
+#include <afina/metrics/Registry.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Afina {
+namespace Metrics {
+
+constexpr std::size_t Counter::kStripes;
+
+// See Registry.h
+Registry &Registry::Instance() {
+    // Never destroyed, so static objects of other modules could use it in their destructors
+    static Registry *instance = new Registry();
+    return *instance;
+}
+
+// See Registry.h
+std::shared_ptr<Counter> Registry::GetCounter(const std::string &name) {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    Metric *metric = find(name);
+    if (metric == nullptr) {
+        _metrics.push_back(Metric{name, std::make_shared<Counter>(), nullptr});
+        metric = &_metrics.back();
+    } else if (!metric->counter) {
+        throw std::runtime_error("Metric " + name + " isn't a counter");
+    }
+    return metric->counter;
+}
+
+// See Registry.h
+std::shared_ptr<Gauge> Registry::GetGauge(const std::string &name) {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    Metric *metric = find(name);
+    if (metric == nullptr) {
+        _metrics.push_back(Metric{name, nullptr, std::make_shared<Gauge>()});
+        metric = &_metrics.back();
+    } else if (!metric->gauge) {
+        throw std::runtime_error("Metric " + name + " isn't a gauge");
+    }
+    return metric->gauge;
+}
+
+// See Registry.h
+void Registry::AddCollector(const std::string &group, const void *owner, Collector collector) {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    _collectors.push_back(Source{group, owner, std::move(collector)});
+}
+
+// See Registry.h
+void Registry::RemoveCollectors(const void *owner) {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    _collectors.erase(std::remove_if(_collectors.begin(), _collectors.end(),
+                                     [owner](const Source &source) { return source.owner == owner; }),
+                      _collectors.end());
+}
+
+// See Registry.h
+void Registry::Render(const std::string &group, Values &values) const {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    if (group.empty()) {
+        for (auto &metric : _metrics) {
+            values.emplace_back(metric.name, metric.counter ? std::to_string(metric.counter->get())
+                                                            : std::to_string(metric.gauge->get()));
+        }
+    }
+
+    for (auto &source : _collectors) {
+        if (source.group == group) {
+            source.collector(values);
+        }
+    }
+}
+
+// See Registry.h
+Registry::Metric *Registry::find(const std::string &name) {
+    for (auto &metric : _metrics) {
+        if (metric.name == name) {
+            return &metric;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace Metrics
+} // namespace Afina
@@ -0,0 +1,64 @@
+#ifndef AFINA_NETWORK_MT_COROUTINE_SERVER_H
+#define AFINA_NETWORK_MT_COROUTINE_SERVER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <afina/network/Server.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace STcoroutine {
+// Forward declaration, see st_coroutine/Worker.h
+class Worker;
+} // namespace STcoroutine
+
+namespace MTcoroutine {
+
+/**
+ * # Network resource manager implementation
+ * Coroutine based server running engine per worker thread. Workers are the same st_coroutine
+ * server runs, see st_coroutine/Worker.h, there are just many of them. Each worker has its own
+ * listening socket bound to the same port with SO_REUSEPORT, so kernel spreads new connections
+ * between workers. There are no acceptor threads, accepting is done by a coroutine of the worker
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+protected:
+    // Opens non blocking socket listening on the port, bound with SO_REUSEPORT so that every
+    // worker could have one
+    int Listen(uint16_t port);
+
+private:
+    // logger to use
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Curstom event "device" used to wakeup workers
+    int _event_fd;
+
+    // threads serving connections
+    std::vector<std::unique_ptr<STcoroutine::Worker>> _workers;
+};
+
+} // namespace MTcoroutine
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_MT_COROUTINE_SERVER_H
@@ -1,22 +1,42 @@
 #ifndef AFINA_NETWORK_MT_NONBLOCKING_CONNECTION_H
 #define AFINA_NETWORK_MT_NONBLOCKING_CONNECTION_H
 
+#include <cstdint>
 #include <cstring>
+#include <memory>
+#include <utility>
 
 #include <sys/epoll.h>
 
+#include "protocol/Session.h"
+
+namespace spdlog {
+class logger;
+}
+
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+/**
+ * # Client connection
+ * Connection is registered in epoll edge-triggered, so each event is served until socket
+ * would block. Everything available in the socket is read and executed at once, responses of
+ * the batch are sent with a single writev. Whatever socket doesn't accept waits for EPOLLOUT,
+ * reading is paused while there is too much of it and goes on once output is sent. Session
+ * stops at slow commands, server runs them with DoResume on the thread pool while connection is out of epoll
+ */
 class Connection {
 public:
-    Connection(int s) : _socket(s) {
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl,
+               Network::ProtocolType protocol, Logging::Trace trace)
+        : _socket(s), _armed(0), _session(ps, protocol, std::move(trace)), _logger(pl), _alive(true), _eof(false),
+          _readable(false) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
         _event.data.ptr = this;
     }
 
-    inline bool isAlive() const { return true; }
+    inline bool isAlive() const { return _alive; }
 
     void Start();
 
@@ -25,13 +45,37 @@ protected:
     void OnClose();
     void DoRead();
     void DoWrite();
+    void DoResume();
+
+    // Sends output left as far as socket accepts it without blocking, worker is stopping
+    void DoFlush();
 
 private:
+    // Reads and runs commands as long as output is sent, then arms connection for what it waits for
+    void Serve();
+
     friend class Worker;
     friend class ServerImpl;
 
+    // Output size at which connection stops to read new commands
+    static constexpr std::size_t kMaxOutput = 1024 * 1024;
+
     int _socket;
     struct epoll_event _event;
+
+    // Events connection is registered in epoll for, 0 if it isn't there
+    uint32_t _armed;
+
+    Protocol::Session _session;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    bool _alive;
+
+    // Client has nothing more to say, connection is closed once output is sent
+    bool _eof;
+
+    // Socket might have data which isn't read yet, EPOLLIN isn't reported for it again
+    bool _readable;
 };
 
 } // namespace MTnonblock
@@ -1,10 +1,14 @@
 #include "ServerImpl.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cerrno>
 #include <cstring>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 
 #include <arpa/inet.h>
 #include <netdb.h>
@@ -19,6 +23,7 @@
 #include <spdlog/logger.h>
 
 #include <afina/Storage.h>
+#include <afina/concurrency/Executor.h>
 #include <afina/logging/Service.h>
 
 #include "Connection.h"
@@ -29,11 +34,18 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+constexpr std::size_t ServerImpl::kAcceptBatch;
+
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl)
+    : Server(ps, pl), _event_fd(-1), _next_worker(0) {}
 
 // See Server.h
-ServerImpl::~ServerImpl() {}
+ServerImpl::~ServerImpl() {
+    if (_event_fd != -1) {
+        close(_event_fd);
+    }
+}
 
 // See Server.h
 void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
@@ -47,63 +59,28 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // Create server socket
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
-    }
-
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
-    }
-
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
-    }
-
-    make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
-    }
-
-    // Start IO workers
-    _data_epoll_fd = epoll_create1(0);
-    if (_data_epoll_fd == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    if (n_workers == 0) {
+        throw std::runtime_error("At least one worker is required");
     }
 
     _event_fd = eventfd(0, EFD_NONBLOCK);
     if (_event_fd == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
     }
 
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    event.data.ptr = nullptr;
-    if (epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
-        throw std::runtime_error("Failed to add eventfd descriptor to epoll");
-    }
+    _executor.reset(new Afina::Concurrency::Executor("offload", n_workers));
 
+    // Start IO workers, each with its own listening socket unless there are acceptors
     _workers.reserve(n_workers);
     for (int i = 0; i < n_workers; i++) {
-        _workers.emplace_back(pStorage, pLogging);
-        _workers.back().Start(_data_epoll_fd);
+        _workers.emplace_back(pStorage, pLogging, protocol, NewTrace());
+        _workers.back().Start(n_acceptors == 0 ? Listen(port) : -1, _event_fd, _executor.get());
     }
 
     // Start acceptors
     _acceptors.reserve(n_acceptors);
     for (int i = 0; i < n_acceptors; i++) {
-        _acceptors.emplace_back(&ServerImpl::OnRun, this);
+        _acceptors.emplace_back(&ServerImpl::OnRun, this, Listen(port));
     }
 }
 
@@ -115,7 +92,7 @@ void ServerImpl::Stop() {
         w.Stop();
     }
 
-    // Wakeup threads that are sleep on epoll_wait
+    // Wakeup threads that are sleep on epoll_wait, event is never read so all of them see it
     if (eventfd_write(_event_fd, 1)) {
         throw std::runtime_error("Failed to wakeup workers");
     }
@@ -130,10 +107,13 @@ void ServerImpl::Join() {
     for (auto &w : _workers) {
         w.Join();
     }
+
+    // Commands taken by the pool are completed
+    _executor->Stop(true);
 }
 
 // See ServerImpl.h
-void ServerImpl::OnRun() {
+void ServerImpl::OnRun(int server_socket) {
     _logger->info("Start acceptor");
     int acceptor_epoll = epoll_create1(0);
     if (acceptor_epoll == -1) {
@@ -141,9 +121,9 @@ void ServerImpl::OnRun() {
     }
 
     struct epoll_event event;
-    event.events = EPOLLIN | EPOLLEXCLUSIVE;
-    event.data.fd = _server_socket;
-    if (epoll_ctl(acceptor_epoll, EPOLL_CTL_ADD, _server_socket, &event)) {
+    event.events = EPOLLIN;
+    event.data.fd = server_socket;
+    if (epoll_ctl(acceptor_epoll, EPOLL_CTL_ADD, server_socket, &event)) {
         throw std::runtime_error("Failed to add file descriptor to epoll");
     }
 
@@ -155,66 +135,116 @@ void ServerImpl::OnRun() {
     }
 
     bool run = true;
-    std::array<struct epoll_event, 64> mod_list;
+    std::array<struct epoll_event, 2> mod_list;
+    std::vector<Worker *> woken;
     while (run) {
         int nmod = epoll_wait(acceptor_epoll, &mod_list[0], mod_list.size(), -1);
         _logger->debug("Acceptor wokeup: {} events", nmod);
 
         for (int i = 0; i < nmod; i++) {
-            struct epoll_event &current_event = mod_list[i];
-            if (current_event.data.fd == _event_fd) {
+            if (mod_list[i].data.fd == _event_fd) {
                 _logger->debug("Break acceptor due to stop signal");
                 run = false;
                 continue;
             }
 
-            for (;;) {
-                struct sockaddr in_addr;
-                socklen_t in_len;
-
-                // No need to make these sockets non blocking since accept4() takes care of it.
-                in_len = sizeof in_addr;
-                int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
-                if (infd == -1) {
-                    if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
-                        break; // We have processed all incoming connections.
-                    } else {
-                        _logger->error("Failed to accept socket");
+            // Each worker is woken up once per batch, however many connections it gets
+            for (bool drained = false; !drained;) {
+                std::size_t accepted = 0;
+                for (; accepted < kAcceptBatch; accepted++) {
+                    int infd = accept4(server_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (infd == -1) {
+                        if (errno == EINTR || errno == ECONNABORTED) {
+                            continue;
+                        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                            _logger->error("Failed to accept socket: {}", strerror(errno));
+                        }
+                        drained = true;
                         break;
                     }
-                }
-
-                // Print host and service info.
-                char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-                int retval = getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf,
-                                         NI_NUMERICHOST | NI_NUMERICSERV);
-                if (retval == 0) {
-                    _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
-                }
 
-                // Register the new FD to be monitored by epoll.
-                Connection *pc = new Connection(infd);
-                if (pc == nullptr) {
-                    throw std::runtime_error("Failed to allocate connection");
+                    Worker *worker = Dispatch(infd);
+                    if (worker == nullptr) {
+                        _logger->error("Workers are overloaded, drop connection on descriptor {}", infd);
+                        close(infd);
+                        continue;
+                    }
+                    if (std::find(woken.begin(), woken.end(), worker) == woken.end()) {
+                        woken.push_back(worker);
+                    }
                 }
 
-                // Register connection in worker's epoll
-                pc->Start();
-                if (pc->isAlive()) {
-                    pc->_event.events |= EPOLLONESHOT;
-                    int epoll_ctl_retval;
-                    if ((epoll_ctl_retval = epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event))) {
-                        _logger->debug("epoll_ctl failed during connection register in workers'epoll: error {}", epoll_ctl_retval);
-                        pc->OnError();
-                        delete pc;
-                    }
+                for (auto worker : woken) {
+                    worker->Wakeup();
                 }
+                woken.clear();
             }
         }
     }
+
+    close(acceptor_epoll);
+    close(server_socket);
     _logger->warn("Acceptor stopped");
 }
 
+// See ServerImpl.h
+Worker *ServerImpl::Dispatch(int socket) {
+    std::size_t start = _next_worker.fetch_add(1, std::memory_order_relaxed);
+    Worker *best = nullptr;
+    for (std::size_t i = 0; i < _workers.size(); i++) {
+        Worker &worker = _workers[(start + i) % _workers.size()];
+        if (best == nullptr || worker.Load() < best->Load()) {
+            best = &worker;
+        }
+    }
+    if (best->Push(socket)) {
+        return best;
+    }
+
+    // Inbox of the least loaded worker is full, so it is stuck, anyone else would do
+    for (std::size_t i = 0; i < _workers.size(); i++) {
+        Worker &worker = _workers[(start + i) % _workers.size()];
+        if (&worker != best && worker.Push(socket)) {
+            return &worker;
+        }
+    }
+    return nullptr;
+}
+
+// See ServerImpl.h
+int ServerImpl::Listen(uint16_t port) {
+    // Create server socket
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;         // IPv4
+    server_addr.sin_port = htons(port);       // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+    int server_socket = socket(PF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (server_socket == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    int opts = 1;
+    if (setsockopt(server_socket, SOL_SOCKET, SO_KEEPALIVE, &opts, sizeof(opts)) == -1 ||
+        setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &opts, sizeof(opts)) == -1) {
+        close(server_socket);
+        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+    }
+
+    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(server_socket);
+        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+    }
+
+    make_socket_non_blocking(server_socket);
+    if (listen(server_socket, SOMAXCONN) == -1) {
+        close(server_socket);
+        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+    }
+    return server_socket;
+}
+
 } // namespace MTnonblock
 } // namespace Network
 } // namespace Afina
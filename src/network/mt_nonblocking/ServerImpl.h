@@ -1,6 +1,10 @@
 #ifndef AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 #define AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -11,6 +15,9 @@ class logger;
 }
 
 namespace Afina {
+namespace Concurrency {
+class Executor;
+}
 namespace Network {
 namespace MTnonblock {
 
@@ -19,10 +26,16 @@ class Worker;
 
 /**
  * # Network resource manager implementation
- * Epoll based server
+ * Epoll based server. Without acceptors each worker accepts and serves connections on its own,
+ * see Worker.h. Otherwise acceptor threads take new connections in batches and hand each of
+ * them to the worker serving the least number of connections, so that storm of reconnects
+ * doesn't delay requests of the existing clients
  */
 class ServerImpl : public Server {
 public:
+    // Max number of connections acceptor takes before handing them over
+    static constexpr std::size_t kAcceptBatch = 64;
+
     ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
     ~ServerImpl();
 
@@ -36,33 +49,35 @@ public:
     void Join() override;
 
 protected:
-    void OnRun();
-    void OnNewConnection();
+    // Acceptor thread, owns the given server socket
+    void OnRun(int server_socket);
+
+    // Hands new connection to the least loaded worker, returns the one took it or nullptr
+    // if inboxes of all workers are full
+    Worker *Dispatch(int socket);
+
+    // Opens non blocking socket listening on the port, bound with SO_REUSEPORT so that every
+    // worker could have one
+    int Listen(uint16_t port);
 
 private:
     // logger to use
     std::shared_ptr<spdlog::logger> _logger;
 
-    // Port to listen for new connections, permits access only from
-    // inside of accept_thread
-    // Read-only
-    uint16_t listen_port;
-
-    // Socket to accept new connection on, shared between acceptors
-    int _server_socket;
+    // Curstom event "device" used to wakeup workers and acceptors
+    int _event_fd;
 
-    // Threads that accepts new connections, each has private epoll instance
-    // but share global server socket
+    // Threads that accepts new connections, each has private epoll instance and server socket
     std::vector<std::thread> _acceptors;
 
-    // EPOLL instance shared between workers
-    int _data_epoll_fd;
-
-    // Curstom event "device" used to wakeup workers
-    int _event_fd;
+    // Worker to start looking for the least loaded one from, spreads connections among equals
+    std::atomic<uint32_t> _next_worker;
 
     // threads serving read/write requests
     std::vector<Worker> _workers;
+
+    // Pool for commands too slow to be run by workers
+    std::unique_ptr<Afina::Concurrency::Executor> _executor;
 };
 
 } // namespace MTnonblock
@@ -1,16 +1,23 @@
 #include "Worker.h"
 
 #include <cassert>
+#include <cerrno>
+#include <cstring>
 #include <functional>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 
 #include <netdb.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <spdlog/logger.h>
 
+#include <afina/concurrency/Executor.h>
 #include <afina/logging/Service.h>
 
 #include "Connection.h"
@@ -20,15 +27,28 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+constexpr std::size_t Worker::kInboxSize;
+
 // See Worker.h
-Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1) {
-    // TODO: implementation here
-}
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+               Network::ProtocolType protocol, Logging::Trace trace)
+    : _pStorage(ps), _pLogging(pl), _protocol(protocol), _trace(std::move(trace)), isRunning(false), _epoll_fd(-1),
+      _server_socket(-1), _inbox_fd(-1), _connections(0), _executor(nullptr), _resuming(0) {}
 
 // See Worker.h
 Worker::~Worker() {
-    // TODO: implementation here
+    if (_epoll_fd != -1) {
+        close(_epoll_fd);
+    }
+    if (_inbox_fd != -1) {
+        close(_inbox_fd);
+    }
+
+    // Sockets pushed after worker had stopped are never served
+    int socket;
+    while (_inbox && _inbox->pop(socket)) {
+        close(socket);
+    }
 }
 
 // See Worker.h
@@ -39,23 +59,86 @@ Worker &Worker::operator=(Worker &&other) {
     _pStorage = std::move(other._pStorage);
     _pLogging = std::move(other._pLogging);
     _logger = std::move(other._logger);
+    _protocol = other._protocol;
+    _trace = std::move(other._trace);
     _thread = std::move(other._thread);
     _epoll_fd = other._epoll_fd;
+    _server_socket = other._server_socket;
+    _inbox = std::move(other._inbox);
+    _inbox_fd = other._inbox_fd;
+    _connections.store(other._connections.load());
+    _executor = other._executor;
+    _live = std::move(other._live);
+    _resuming = other._resuming;
 
     other._epoll_fd = -1;
+    other._server_socket = -1;
+    other._inbox_fd = -1;
+    other._executor = nullptr;
     return *this;
 }
 
 // See Worker.h
-void Worker::Start(int epoll_fd) {
+void Worker::Start(int server_socket, int event_fd, Afina::Concurrency::Executor *executor) {
     if (isRunning.exchange(true) == false) {
         assert(_epoll_fd == -1);
-        _epoll_fd = epoll_fd;
+        _server_socket = server_socket;
+        _executor = executor;
         _logger = _pLogging->select("network.worker");
+
+        _epoll_fd = epoll_create1(0);
+        if (_epoll_fd == -1) {
+            throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+        }
+
+        _inbox.reset(new Afina::Concurrency::MPSCQueue<int>(kInboxSize));
+        _inbox_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_inbox_fd == -1) {
+            throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+        }
+
+        // Server socket and inbox are told apart by their own addresses, event_fd by nullptr
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = &_server_socket;
+        if (_server_socket != -1 && epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _server_socket, &event)) {
+            throw std::runtime_error("Failed to add server socket to epoll");
+        }
+
+        event.events = EPOLLIN;
+        event.data.ptr = &_inbox_fd;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _inbox_fd, &event)) {
+            throw std::runtime_error("Failed to add inbox descriptor to epoll");
+        }
+
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, event_fd, &event)) {
+            throw std::runtime_error("Failed to add eventfd descriptor to epoll");
+        }
+
         _thread = std::thread(&Worker::OnRun, this);
     }
 }
 
+// See Worker.h
+bool Worker::Push(int socket) {
+    // Counted right away, so that the next socket goes to someone else
+    _connections.fetch_add(1, std::memory_order_relaxed);
+    if (!_inbox->push(socket)) {
+        _connections.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+// See Worker.h
+void Worker::Wakeup() {
+    if (eventfd_write(_inbox_fd, 1)) {
+        _logger->error("Failed to wakeup worker: {}", strerror(errno));
+    }
+}
+
 // See Worker.h
 void Worker::Stop() { isRunning = false; }
 
@@ -63,6 +146,14 @@ void Worker::Stop() { isRunning = false; }
 void Worker::Join() {
     assert(_thread.joinable());
     _thread.join();
+
+    // Sockets pushed after worker had stopped are never served, server has no acceptors
+    // running by now, so nothing comes after them
+    int socket;
+    while (_inbox->pop(socket)) {
+        close(socket);
+        _connections.fetch_sub(1, std::memory_order_relaxed);
+    }
 }
 
 // See Worker.h
@@ -71,9 +162,6 @@ void Worker::OnRun() {
     _logger->trace("OnRun");
 
     // Process connection events
-    //
-    // Do not forget to use EPOLLEXCLUSIVE flag when register socket
-    // for events to avoid thundering herd type behavior.
     int timeout = -1;
     std::array<struct epoll_event, 64> mod_list;
     while (isRunning) {
@@ -88,6 +176,12 @@ void Worker::OnRun() {
             // on changes in OUTHER loop
             if (current_event.data.ptr == nullptr) {
                 continue;
+            } else if (current_event.data.ptr == &_server_socket) {
+                OnAccept();
+                continue;
+            } else if (current_event.data.ptr == &_inbox_fd) {
+                OnInbox();
+                continue;
             }
 
             // Some connection gets new data
@@ -110,29 +204,155 @@ void Worker::OnRun() {
                 }
             }
 
-            // Rearm connection
-            if (pconn->isAlive()) {
-                pconn->_event.events |= EPOLLONESHOT;
-                int epoll_ctl_retval;
-                if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event))) {
-                    _logger->debug("epoll_ctl failed during connection rearm: error {}", epoll_ctl_retval);
-                    pconn->OnError();
-                    delete pconn;
-                }
-            }
-            // Or delete closed one
-            else {
+            // Slow command goes to the pool, connection is out of epoll until it is done, so
+            // worker doesn't touch it meanwhile
+            if (pconn->isAlive() && pconn->_session.Deferred()) {
                 if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
-                    std::cerr << "Failed to delete connection!" << std::endl;
+                    _logger->error("Failed to delete connection from epoll: {}", strerror(errno));
+                }
+                pconn->_armed = 0;
+
+                std::unique_lock<std::mutex> lock(_mutex);
+                _resuming++;
+                lock.unlock();
+                if (_executor->Execute(&Worker::OnResume, this, pconn)) {
+                    continue;
                 }
-                delete pconn;
+
+                lock.lock();
+                _resuming--;
+                lock.unlock();
+                pconn->DoResume();
             }
+            Rearm(pconn);
+        }
+    }
+
+    // No more connections are accepted by this worker
+    if (_server_socket != -1) {
+        close(_server_socket);
+        _server_socket = -1;
+    }
+
+    // Connections on the pool come back before anything is closed, nobody touches them afterwards
+    std::unordered_set<Connection *> live;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_resuming > 0) {
+            _resumed.wait(lock);
         }
-        // TODO: Select timeout...
+        live = _live;
+    }
+
+    for (auto pconn : live) {
+        pconn->DoFlush();
+        Close(pconn);
     }
     _logger->warn("Worker stopped");
 }
 
+// See Worker.h
+void Worker::OnAccept() {
+    for (;;) {
+        struct sockaddr in_addr;
+        socklen_t in_len;
+
+        // No need to make these sockets non blocking since accept4() takes care of it.
+        in_len = sizeof in_addr;
+        int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (infd == -1) {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                break; // We have processed all incoming connections.
+            } else if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            _logger->error("Failed to accept socket: {}", strerror(errno));
+            break;
+        }
+
+        // Print host and service info.
+        char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+        int retval = getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf,
+                                 NI_NUMERICHOST | NI_NUMERICSERV);
+        if (retval == 0) {
+            _logger->debug("Accepted connection on descriptor {} (host={}, port={})", infd, hbuf, sbuf);
+        }
+
+        _connections.fetch_add(1, std::memory_order_relaxed);
+        Serve(infd);
+    }
+}
+
+// See Worker.h
+void Worker::OnInbox() {
+    // Counter is reset, sockets pushed after that wake worker up once again
+    eventfd_t value;
+    eventfd_read(_inbox_fd, &value);
+
+    int socket;
+    while (_inbox->pop(socket)) {
+        Serve(socket);
+    }
+}
+
+// See Worker.h
+void Worker::Serve(int socket) {
+    // Register the new FD to be monitored by this worker
+    Connection *pc = new Connection(socket, _pStorage, _logger, _protocol, _trace);
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _live.insert(pc);
+    }
+    pc->Start();
+    Rearm(pc);
+}
+
+// See Worker.h
+void Worker::OnResume(Connection *pconn) {
+    pconn->DoResume();
+    Rearm(pconn);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _resuming--;
+    _resumed.notify_all();
+}
+
+// See Worker.h
+void Worker::Rearm(Connection *pconn) {
+    if (pconn->isAlive()) {
+        if (pconn->_event.events == pconn->_armed) {
+            return;
+        }
+
+        // Connection which isn't in epoll yet has nothing armed. Once it is added back by the
+        // pool, it belongs to the worker thread, so nothing is changed after epoll_ctl
+        int op = pconn->_armed == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        pconn->_armed = pconn->_event.events;
+        if (epoll_ctl(_epoll_fd, op, pconn->_socket, &pconn->_event)) {
+            _logger->error("Failed to arm connection on descriptor {}: {}", pconn->_socket, strerror(errno));
+            pconn->OnError();
+            Close(pconn);
+        }
+    }
+    // Or delete closed one
+    else {
+        Close(pconn);
+    }
+}
+
+// See Worker.h
+void Worker::Close(Connection *pconn) {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _live.erase(pconn);
+    }
+
+    // Closing socket takes it out of epoll
+    close(pconn->_socket);
+    delete pconn;
+    _connections.fetch_sub(1, std::memory_order_relaxed);
+}
+
 } // namespace MTnonblock
 } // namespace Network
 } // namespace Afina
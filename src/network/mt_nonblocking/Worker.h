@@ -2,8 +2,17 @@
 #define AFINA_NETWORK_MT_NONBLOCKING_WORKER_H
 
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <unordered_set>
+
+#include <afina/concurrency/MPSCQueue.h>
+
+#include <afina/logging/Trace.h>
+#include <afina/network/Server.h>
 
 namespace spdlog {
 class logger;
@@ -16,18 +25,40 @@ class Storage;
 namespace Logging {
 class Service;
 }
+namespace Concurrency {
+class Executor;
+}
 
 namespace Network {
 namespace MTnonblock {
 
+// Forward declaration, see Connection.h
+class Connection;
+
 /**
  * # Thread running epoll
  * On Start spaws background thread that is doing epoll on the given server
  * socket and process incoming connections and its data
+ *
+ * Each worker has its own epoll instance and its own listening socket bound to the same port
+ * with SO_REUSEPORT, kernel spreads new connections between them. Connection is served by the
+ * worker accepted it until it is closed, so workers share nothing but the storage.
+ *
+ * Worker could be started without listening socket, then connections are accepted by server
+ * and handed over with Push. Sockets are queued without locks, worker is woken up once per
+ * batch with Wakeup
  */
 class Worker {
 public:
-    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl);
+    // Max number of sockets waiting for the worker to take them
+    static constexpr std::size_t kInboxSize = 1024;
+
+    /**
+     * Connections accepted by worker speak the given protocol, each of them traces requests
+     * with a copy of the given trace
+     */
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           Network::ProtocolType protocol, Logging::Trace trace);
     ~Worker();
 
     Worker(Worker &&);
@@ -36,21 +67,40 @@ public:
     /**
      * Spaws new background thread that is doing epoll on the given server
      * socket. Once connection accepted it must be registered and being processed
-     * on this thread
+     * on this thread. Slow commands are executed on the given pool. Worker takes
+     * ownership of the server socket, -1 means that connections come with Push.
+     * event_fd is used by server to wake it up
+     */
+    void Start(int server_socket, int event_fd, Afina::Concurrency::Executor *executor);
+
+    /**
+     * Hands accepted socket over to the worker, it is served once worker is woken up. Returns
+     * false if worker has too many sockets queued already. Safe to call from any thread
+     */
+    bool Push(int socket);
+
+    /**
+     * Wakes worker up to take sockets pushed so far
+     */
+    void Wakeup();
+
+    /**
+     * Number of connections worker serves, including queued ones
      */
-    void Start(int epoll_fd);
+    inline uint32_t Load() const { return _connections.load(std::memory_order_relaxed); }
 
     /**
      * Signal background thread to stop. After that signal thread must stop to
      * accept new connections and must stop read new commands from existing. Once
-     * all readed commands are executed and results are send back to client, thread
-     * must stop
+     * commands taken by the pool are done, output is sent as far as sockets accept
+     * it without blocking and every connection is closed
      */
     void Stop();
 
     /**
      * Blocks calling thread until background one for this worker is actually
-     * been destoryed
+     * been destoryed. Sockets still queued to the worker are closed, so nobody
+     * should Push them afterwards
      */
     void Join();
 
@@ -60,6 +110,37 @@ protected:
      */
     void OnRun();
 
+    /**
+     * Accepts all pending connections of the server socket
+     */
+    void OnAccept();
+
+    /**
+     * Starts to serve sockets handed over by server
+     */
+    void OnInbox();
+
+    /**
+     * Registers new connection on the socket
+     */
+    void Serve(int socket);
+
+    /**
+     * Runs deferred commands of the connection, called on the pool
+     */
+    void OnResume(Connection *pconn);
+
+    /**
+     * Arms connection for the next event or deletes it if connection is closed. Epoll is
+     * touched only if connection wants other events than before
+     */
+    void Rearm(Connection *pconn);
+
+    /**
+     * Closes connection socket and deletes it
+     */
+    void Close(Connection *pconn);
+
 private:
     Worker(Worker &) = delete;
     Worker &operator=(Worker &) = delete;
@@ -73,14 +154,43 @@ private:
     // Logger to be used
     std::shared_ptr<spdlog::logger> _logger;
 
+    // Settings of the new connections
+    Network::ProtocolType _protocol;
+    Logging::Trace _trace;
+
     // Flag signals that thread should continue to operate
     std::atomic<bool> isRunning;
 
     // Thread serving requests in this worker
     std::thread _thread;
 
-    // EPOLL descriptor using for events processing
+    // EPOLL descriptor using for events processing, owned by worker
     int _epoll_fd;
+
+    // Socket to accept new connections on, owned by worker
+    int _server_socket;
+
+    // Sockets handed over by server and eventfd signaling that there are some
+    std::unique_ptr<Afina::Concurrency::MPSCQueue<int>> _inbox;
+    int _inbox_fd;
+
+    // Connections served or queued
+    std::atomic<uint32_t> _connections;
+
+    // Pool for the slow commands, owned by server
+    Afina::Concurrency::Executor *_executor;
+
+    // Protects connections below, pool deletes them as well
+    std::mutex _mutex;
+
+    // Signaled once connection taken by the pool is given back
+    std::condition_variable _resumed;
+
+    // Connections registered by worker and not closed yet
+    std::unordered_set<Connection *> _live;
+
+    // Number of connections being resumed on the pool
+    uint32_t _resuming;
 };
 
 } // namespace MTnonblock
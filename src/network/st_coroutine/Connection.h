@@ -1,36 +1,64 @@
 #ifndef AFINA_NETWORK_ST_COROUTINE_CONNECTION_H
 #define AFINA_NETWORK_ST_COROUTINE_CONNECTION_H
 
+#include <cstdint>
 #include <cstring>
+#include <memory>
+#include <utility>
 
 #include <sys/epoll.h>
 
+#include "protocol/Session.h"
+
 namespace Afina {
 namespace Network {
 namespace STcoroutine {
 
+/**
+ * # Coroutine waiting for the descriptor
+ * Descriptors are registered in epoll edge-triggered, so event reported while coroutine is busy
+ * must not be lost: it is kept in ready until coroutine asks for it
+ */
+struct Waiter {
+    // Coroutine to unblock
+    void *routine = nullptr;
+
+    // Events reported by epoll since coroutine has seen them last time
+    uint32_t ready = 0;
+
+    // Events coroutine is blocked on, none if it is running
+    uint32_t waiting = 0;
+};
+
+/**
+ * # Client connection
+ * Served by its own coroutine with plain blocking-style code: read, process, write everything,
+ * repeat. Whenever socket would block coroutine gives up control until epoll reports it ready.
+ * Connection lives on the heap: stack of coroutine is copied on every switch, so it holds as
+ * little as possible
+ */
 class Connection {
 public:
-    Connection(int s) : _socket(s) {
+    // Size of the read buffer
+    static constexpr std::size_t kReadSize = 4096;
+
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, Network::ProtocolType protocol, Logging::Trace trace)
+        : _socket(s), _session(ps, protocol, std::move(trace)) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
+        _event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
         _event.data.ptr = this;
     }
 
-    inline bool isAlive() const { return true; }
-
-    void Start();
-
-protected:
-    void OnError();
-    void OnClose();
-    void DoRead();
-    void DoWrite();
-
 private:
-    friend class ServerImpl;
+    friend class Worker;
 
     int _socket;
     struct epoll_event _event;
+
+    Waiter _waiter;
+
+    Protocol::Session _session;
+    char _buffer[kReadSize];
 };
 
 } // namespace STcoroutine
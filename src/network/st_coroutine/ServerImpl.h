@@ -1,8 +1,8 @@
 #ifndef AFINA_NETWORK_ST_COROUTINE_SERVER_H
 #define AFINA_NETWORK_ST_COROUTINE_SERVER_H
 
-#include <thread>
-#include <vector>
+#include <cstdint>
+#include <memory>
 
 #include <afina/network/Server.h>
 
@@ -19,7 +19,8 @@ class Worker;
 
 /**
  * # Network resource manager implementation
- * Epoll based server
+ * Coroutine based server. Single worker thread runs coroutine engine: one coroutine accepts
+ * new connections and each connection is served by a coroutine of its own, see Worker.h
  */
 class ServerImpl : public Server {
 public:
@@ -35,27 +36,15 @@ public:
     // See Server.h
     void Join() override;
 
-protected:
-    void OnRun();
-    void OnNewConnection(int);
-
 private:
     // logger to use
     std::shared_ptr<spdlog::logger> _logger;
 
-    // Port to listen for new connections, permits access only from
-    // inside of accept_thread
-    // Read-only
-    uint16_t listen_port;
-
-    // Socket to accept new connection on, shared between acceptors
-    int _server_socket;
-
-    // Curstom event "device" used to wakeup workers
+    // Curstom event "device" used to wakeup worker
     int _event_fd;
 
-    // IO thread
-    std::thread _work_thread;
+    // Thread running the engine
+    std::unique_ptr<Worker> _worker;
 };
 
 } // namespace STcoroutine
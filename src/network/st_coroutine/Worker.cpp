@@ -0,0 +1,265 @@
+#include "Worker.h"
+
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/coroutine/Engine.h>
+#include <afina/logging/Service.h>
+
+namespace Afina {
+namespace Network {
+namespace STcoroutine {
+
+// See Worker.h
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+               Network::ProtocolType protocol, Logging::Trace trace)
+    : _pStorage(ps), _pLogging(pl), _protocol(protocol), _trace(std::move(trace)), _server_socket(-1),
+      _event_fd(-1), _epoll_fd(-1), _engine(nullptr), _running(false) {}
+
+// See Worker.h
+Worker::~Worker() {
+    if (_epoll_fd != -1) {
+        close(_epoll_fd);
+    }
+    if (_server_socket != -1) {
+        close(_server_socket);
+    }
+}
+
+// See Worker.h
+void Worker::Start(int server_socket, int event_fd) {
+    assert(!_thread.joinable());
+    _server_socket = server_socket;
+    _event_fd = event_fd;
+    _logger = _pLogging->select("network.worker");
+
+    _epoll_fd = epoll_create1(0);
+    if (_epoll_fd == -1) {
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    }
+
+    // Acceptor is told apart by its own address, event_fd by nullptr
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = &_acceptor;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _server_socket, &event)) {
+        throw std::runtime_error("Failed to add file descriptor to epoll");
+    }
+
+    struct epoll_event event2;
+    event2.events = EPOLLIN;
+    event2.data.ptr = nullptr;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event2)) {
+        throw std::runtime_error("Failed to add file descriptor to epoll");
+    }
+
+    _thread = std::thread(&Worker::OnRun, this);
+}
+
+// See Worker.h
+void Worker::Join() {
+    assert(_thread.joinable());
+    _thread.join();
+}
+
+// See Worker.h
+void Worker::OnRun() {
+    _logger->trace("OnRun");
+
+    // Engine returns once all coroutines are done, that is after stop
+    Afina::Coroutine::Engine engine([this](Afina::Coroutine::Engine &) { OnIdle(); });
+    _engine = &engine;
+    _running = true;
+    engine.start(&Worker::RunWorker, this);
+    _engine = nullptr;
+
+    // No more connections are accepted by this worker
+    close(_server_socket);
+    _server_socket = -1;
+    _logger->warn("Worker stopped");
+}
+
+// See Worker.h
+void Worker::RunWorker(Worker *worker) {
+    // Routine started by engine has no handle to unblock it, so acceptor is spawned separately
+    worker->_acceptor.routine = worker->_engine->run(&Worker::RunAcceptor, static_cast<Worker *>(worker));
+}
+
+// See Worker.h
+void Worker::RunAcceptor(Worker *worker) { worker->OnAccept(); }
+
+// See Worker.h
+void Worker::RunConnection(Worker *worker, Connection *pconn) { worker->OnConnection(pconn); }
+
+// See Worker.h
+void Worker::OnAccept() {
+    while (Wait(_acceptor, EPOLLIN)) {
+        for (;;) {
+            struct sockaddr in_addr;
+            socklen_t in_len;
+
+            // No need to make these sockets non blocking since accept4() takes care of it.
+            in_len = sizeof in_addr;
+            int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (infd == -1) {
+                if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                    break; // We have processed all incoming connections.
+                } else if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                _logger->error("Failed to accept socket: {}", strerror(errno));
+                break;
+            }
+
+            // Print host and service info.
+            char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+            int retval = getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf,
+                                     NI_NUMERICHOST | NI_NUMERICSERV);
+            if (retval == 0) {
+                _logger->debug("Accepted connection on descriptor {} (host={}, port={})", infd, hbuf, sbuf);
+            }
+
+            // Register the new FD to be monitored by epoll, it is never rearmed
+            Connection *pc = new Connection(infd, _pStorage, _protocol, _trace);
+            if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
+                _logger->error("Failed to add connection to epoll: {}", strerror(errno));
+                close(pc->_socket);
+                delete pc;
+                continue;
+            }
+
+            // Engine takes arguments by rvalue reference, coroutine gets control once acceptor blocks
+            _connections.insert(pc);
+            pc->_waiter.routine = _engine->run(&Worker::RunConnection, this, static_cast<Connection *>(pc));
+        }
+    }
+    _logger->debug("Acceptor stopped");
+}
+
+// See Worker.h
+void Worker::OnConnection(Connection *pconn) {
+    try {
+        for (;;) {
+            ssize_t readed = Read(pconn);
+            if (readed <= 0) {
+                break;
+            }
+            _logger->debug("Got {} bytes from socket {}", readed, pconn->_socket);
+
+            // Everything is sent before the next read, so client which doesn't read responses
+            // is never read either
+            bool more = pconn->_session.Process(pconn->_buffer, readed);
+            if (!Write(pconn) || !more) {
+                break;
+            }
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", pconn->_socket, ex.what());
+    }
+
+    // Closing socket takes it out of epoll
+    _logger->debug("Close connection on descriptor {}", pconn->_socket);
+    close(pconn->_socket);
+    _connections.erase(pconn);
+    delete pconn;
+}
+
+// See Worker.h
+void Worker::OnIdle() {
+    std::array<struct epoll_event, 64> mod_list;
+    for (bool woken = false; !woken;) {
+        int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), -1);
+        if (nmod == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to wait for events: " + std::string(strerror(errno)));
+        }
+        _logger->debug("Engine wokeup: {} events", nmod);
+
+        for (int i = 0; i < nmod; i++) {
+            struct epoll_event &current_event = mod_list[i];
+
+            // Server asks to stop, everyone is woken up to see that
+            if (current_event.data.ptr == nullptr) {
+                _logger->debug("Stop coroutines due to stop signal");
+                _running = false;
+                _engine->unblock(_acceptor.routine);
+                for (auto pconn : _connections) {
+                    _engine->unblock(pconn->_waiter.routine);
+                }
+                woken = true;
+                continue;
+            }
+
+            Waiter *waiter = &_acceptor;
+            if (current_event.data.ptr != &_acceptor) {
+                waiter = &static_cast<Connection *>(current_event.data.ptr)->_waiter;
+            }
+
+            waiter->ready |= current_event.events;
+            if (waiter->ready & waiter->waiting) {
+                _engine->unblock(waiter->routine);
+                woken = true;
+            }
+        }
+    }
+}
+
+// See Worker.h
+bool Worker::Wait(Waiter &waiter, uint32_t events) {
+    // Errors wake up anyone, next syscall tells what happened
+    events |= EPOLLERR | EPOLLHUP | EPOLLRDHUP;
+    while (_running && (waiter.ready & events) == 0) {
+        waiter.waiting = events;
+        _engine->block();
+        waiter.waiting = 0;
+    }
+
+    waiter.ready &= ~events;
+    return _running;
+}
+
+// See Worker.h
+ssize_t Worker::Read(Connection *pconn) {
+    for (;;) {
+        ssize_t readed = read(pconn->_socket, pconn->_buffer, Connection::kReadSize);
+        if (readed >= 0) {
+            return readed;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            throw std::runtime_error("Failed to read connection: " + std::string(strerror(errno)));
+        }
+
+        if (!Wait(pconn->_waiter, EPOLLIN)) {
+            return -1;
+        }
+    }
+}
+
+// See Worker.h
+bool Worker::Write(Connection *pconn) {
+    while (!pconn->_session.Write(pconn->_socket)) {
+        if (!Wait(pconn->_waiter, EPOLLOUT)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace STcoroutine
+} // namespace Network
+} // namespace Afina
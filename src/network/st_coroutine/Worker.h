@@ -0,0 +1,150 @@
+#ifndef AFINA_NETWORK_ST_COROUTINE_WORKER_H
+#define AFINA_NETWORK_ST_COROUTINE_WORKER_H
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+
+#include <sys/types.h>
+
+#include <afina/logging/Trace.h>
+#include <afina/network/Server.h>
+
+#include "Connection.h"
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+namespace Logging {
+class Service;
+}
+namespace Coroutine {
+class Engine;
+}
+
+namespace Network {
+namespace STcoroutine {
+
+/**
+ * # Thread running coroutine engine
+ * On Start spawns background thread with its own coroutine engine and epoll instance: one
+ * coroutine accepts connections on the given server socket and each connection is served by a
+ * coroutine of its own, see Connection.h. Coroutine which would block on the socket is blocked
+ * in the engine instead, once nobody could run engine waits on epoll and unblocks coroutines
+ * whose sockets got ready.
+ *
+ * st_coroutine server runs a single worker, mt_coroutine runs one per thread. In the latter
+ * case every worker has its own listening socket bound to the same port with SO_REUSEPORT,
+ * kernel spreads new connections between them. Connection stays with the worker accepted it,
+ * so workers share nothing but the storage
+ */
+class Worker {
+public:
+    /**
+     * Connections accepted by worker speak the given protocol, each of them traces requests
+     * with a copy of the given trace
+     */
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           Network::ProtocolType protocol, Logging::Trace trace);
+    ~Worker();
+
+    /**
+     * Spawns background thread serving connections of the given server socket, worker takes
+     * ownership of it. event_fd is used by server to wake it up
+     */
+    void Start(int server_socket, int event_fd);
+
+    /**
+     * Blocks calling thread until background one for this worker is actually
+     * been destoryed. Worker stops once server signals event_fd
+     */
+    void Join();
+
+protected:
+    // Method executing by background thread, runs the engine
+    void OnRun();
+
+    // Accepts new connections and spawns coroutines serving them
+    void OnAccept();
+
+    // Serves connection until it is closed
+    void OnConnection(Connection *pconn);
+
+    // Waits on epoll until some coroutine could go on, called by engine once nobody could run
+    void OnIdle();
+
+    /**
+     * Blocks current coroutine until waiter gets one of the events or error, returns false if
+     * worker is stopping
+     */
+    bool Wait(Waiter &waiter, uint32_t events);
+
+    /**
+     * Reads from connection socket into its buffer, returns number of bytes read, 0 if client
+     * has closed connection or -1 if worker is stopping. Throws std::runtime_error on errors
+     */
+    ssize_t Read(Connection *pconn);
+
+    /**
+     * Sends all output of the connection, returns false if worker is stopping. Throws
+     * std::runtime_error on errors
+     */
+    bool Write(Connection *pconn);
+
+private:
+    Worker(Worker &) = delete;
+    Worker &operator=(Worker &) = delete;
+
+    // Coroutine entry points
+    static void RunWorker(Worker *worker);
+    static void RunAcceptor(Worker *worker);
+    static void RunConnection(Worker *worker, Connection *pconn);
+
+    // afina services
+    std::shared_ptr<Afina::Storage> _pStorage;
+
+    // afina services
+    std::shared_ptr<Afina::Logging::Service> _pLogging;
+
+    // Logger to be used
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Settings of the new connections
+    Network::ProtocolType _protocol;
+    Logging::Trace _trace;
+
+    // Thread serving requests in this worker
+    std::thread _thread;
+
+    // Socket to accept new connections on, owned by worker
+    int _server_socket;
+
+    // Eventfd server uses to stop workers
+    int _event_fd;
+
+    // Epoll descriptor, owned by worker thread
+    int _epoll_fd;
+
+    // Engine running coroutines, lives on the stack of worker thread
+    Afina::Coroutine::Engine *_engine;
+
+    // Whether worker is running, touched by worker thread only
+    bool _running;
+
+    // Acceptor coroutine waiting for new connections
+    Waiter _acceptor;
+
+    // Connections being served
+    std::unordered_set<Connection *> _connections;
+};
+
+} // namespace STcoroutine
+} // namespace Network
+} // namespace Afina
+#endif // AFINA_NETWORK_ST_COROUTINE_WORKER_H
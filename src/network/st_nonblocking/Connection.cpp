@@ -1,25 +1,85 @@
 #include "Connection.h"
 
-#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
 
 namespace Afina {
 namespace Network {
 namespace STnonblock {
 
+constexpr std::size_t Connection::kMaxOutput;
+
+// See Connection.h
+void Connection::Start() {
+    // Errors and hangups are reported anyway
+    _event.events = EPOLLIN | EPOLLET;
+}
+
 // See Connection.h
-void Connection::Start() { std::cout << "Start" << std::endl; }
+void Connection::OnError() { _alive = false; }
 
 // See Connection.h
-void Connection::OnError() { std::cout << "OnError" << std::endl; }
+void Connection::OnClose() { _alive = false; }
 
 // See Connection.h
-void Connection::OnClose() { std::cout << "OnClose" << std::endl; }
+void Connection::DoRead() {
+    _readable = true;
+    Serve();
+}
 
 // See Connection.h
-void Connection::DoRead() { std::cout << "DoRead" << std::endl; }
+void Connection::DoWrite() { Serve(); }
 
 // See Connection.h
-void Connection::DoWrite() { std::cout << "DoWrite" << std::endl; }
+void Connection::Serve() {
+    bool sent;
+    try {
+        // Edge doesn't come again for the data left in the socket, so once output is sent
+        // reading goes on until socket is drained
+        do {
+            char client_buffer[4096];
+            while (_readable && !_eof && _session.OutputSize() < kMaxOutput) {
+                ssize_t readed_bytes = read(_socket, client_buffer, sizeof(client_buffer));
+                if (readed_bytes > 0) {
+                    _logger->debug("Got {} bytes from socket", readed_bytes);
+                    _eof = !_session.Process(client_buffer, readed_bytes);
+                } else if (readed_bytes == 0) {
+                    _logger->debug("Connection closed");
+                    _eof = true;
+                } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    _readable = false;
+                } else if (errno != EINTR) {
+                    throw std::runtime_error(std::string(strerror(errno)));
+                }
+            }
+
+            // Responses of the whole batch go out at once
+            sent = _session.Write(_socket);
+        } while (sent && _readable && !_eof);
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to serve connection on descriptor {}: {}", _socket, ex.what());
+        _alive = false;
+        return;
+    }
+
+    // Interest changes only when socket stops to accept output and once it is all sent
+    _event.events = EPOLLIN | EPOLLET;
+    if (!sent) {
+        _event.events |= EPOLLOUT;
+    }
+
+    // Client is gone and there is nothing left to send
+    if (_eof && sent) {
+        _alive = false;
+    }
+}
 
 } // namespace STnonblock
 } // namespace Network
@@ -2,21 +2,39 @@
 #define AFINA_NETWORK_ST_NONBLOCKING_CONNECTION_H
 
 #include <cstring>
+#include <memory>
+#include <utility>
 
 #include <sys/epoll.h>
 
+#include "protocol/Session.h"
+
+namespace spdlog {
+class logger;
+}
+
 namespace Afina {
 namespace Network {
 namespace STnonblock {
 
+/**
+ * # Client connection
+ * Connection is registered in epoll edge-triggered, so each event is served until socket
+ * would block. Everything available in the socket is read and executed at once, responses of
+ * the batch are sent with a single writev. Whatever socket doesn't accept waits for EPOLLOUT,
+ * reading is paused while there is too much of it and goes on once output is sent
+ */
 class Connection {
 public:
-    Connection(int s) : _socket(s) {
+    Connection(int s, std::shared_ptr<Afina::Storage> ps, std::shared_ptr<spdlog::logger> pl,
+               Network::ProtocolType protocol, Logging::Trace trace)
+        : _socket(s), _session(ps, protocol, std::move(trace)), _logger(pl), _alive(true), _eof(false),
+          _readable(false) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
         _event.data.ptr = this;
     }
 
-    inline bool isAlive() const { return true; }
+    inline bool isAlive() const { return _alive; }
 
     void Start();
 
@@ -27,10 +45,27 @@ protected:
     void DoWrite();
 
 private:
+    // Reads and runs commands as long as output is sent, then arms connection for what it waits for
+    void Serve();
+
     friend class ServerImpl;
 
+    // Output size at which connection stops to read new commands
+    static constexpr std::size_t kMaxOutput = 1024 * 1024;
+
     int _socket;
     struct epoll_event _event;
+
+    Protocol::Session _session;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    bool _alive;
+
+    // Client has nothing more to say, connection is closed once output is sent
+    bool _eof;
+
+    // Socket might have data which isn't read yet, EPOLLIN isn't reported for it again
+    bool _readable;
 };
 
 } // namespace STnonblock
@@ -207,7 +207,7 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
         }
 
         // Register the new FD to be monitored by epoll.
-        Connection *pc = new(std::nothrow) Connection(infd);
+        Connection *pc = new(std::nothrow) Connection(infd, pStorage, _logger, protocol, NewTrace());
         if (pc == nullptr) {
             throw std::runtime_error("Failed to allocate connection");
         }
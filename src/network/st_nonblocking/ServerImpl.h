@@ -1,6 +1,7 @@
 #ifndef AFINA_NETWORK_ST_NONBLOCKING_SERVER_H
 #define AFINA_NETWORK_ST_NONBLOCKING_SERVER_H
 
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -14,12 +15,13 @@ namespace Afina {
 namespace Network {
 namespace STnonblock {
 
-// Forward declaration, see Worker.h
-class Worker;
+// Forward declaration, see Connection.h
+class Connection;
 
 /**
  * # Network resource manager implementation
- * Epoll based server
+ * Epoll based server. Single thread serves every connection, storage might be not thread safe
+ * (see st_lru), so even slow commands are run by it rather than by a thread pool
  */
 class ServerImpl : public Server {
 public:
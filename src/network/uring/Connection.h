@@ -0,0 +1,69 @@
+#ifndef AFINA_NETWORK_URING_CONNECTION_H
+#define AFINA_NETWORK_URING_CONNECTION_H
+
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "protocol/Session.h"
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+/**
+ * # Client connection
+ * State of the connection served by worker, see Worker.h. There is at most one request of each
+ * kind in flight: multishot recv, send of the queued output and cancel of the recv. Connection is
+ * closed once it is done and deleted once kernel has nothing more to say about it
+ */
+class Connection {
+public:
+    Connection(int socket, std::shared_ptr<Afina::Storage> ps, Network::ProtocolType protocol, Logging::Trace trace)
+        : _socket(socket), _session(ps, protocol, std::move(trace)), _inflight(0), _receiving(false),
+          _sending(false), _cancelling(false), _eof(false), _closing(false) {
+        std::memset(&_msg, 0, sizeof(_msg));
+        _msg.msg_iov = _iov;
+    }
+
+private:
+    friend class Worker;
+
+    // Output size at which connection stops to receive new commands
+    static constexpr std::size_t kMaxOutput = 1024 * 1024;
+
+    // Socket or index of the registered file
+    int _socket;
+
+    Protocol::Session _session;
+
+    // Output being sent
+    struct msghdr _msg;
+    struct iovec _iov[Protocol::Session::kMaxIov];
+
+    // Requests kernel hasn't completed yet
+    unsigned _inflight;
+
+    // Requests in flight:
+    // - receiving: multishot recv is armed
+    // - sending: output is being sent
+    // - cancelling: recv is asked to stop
+    bool _receiving;
+    bool _sending;
+    bool _cancelling;
+
+    // Client has nothing more to say, connection is closed once output is sent
+    bool _eof;
+
+    // Connection is going to be closed as soon as there are no requests in flight
+    bool _closing;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_CONNECTION_H
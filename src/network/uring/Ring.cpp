@@ -0,0 +1,158 @@
+#include "Ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+// Raw syscalls, glibc has no wrappers for them
+static inline int io_uring_setup(unsigned entries, struct io_uring_params *params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static inline int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+static inline int io_uring_register(int fd, unsigned opcode, const void *arg, unsigned nr) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr));
+}
+
+// See Ring.h
+Ring::Ring(unsigned entries) : _sq_ptr(MAP_FAILED), _cq_ptr(MAP_FAILED), _sqes(nullptr), _sqe_tail(0) {
+    // Completions are processed only when thread asks for them, so kernel doesn't need to
+    // interrupt it. Older kernels don't know the flag
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_COOP_TASKRUN;
+    _fd = io_uring_setup(entries, &params);
+    if (_fd == -1 && errno == EINVAL) {
+        std::memset(&params, 0, sizeof(params));
+        _fd = io_uring_setup(entries, &params);
+    }
+    if (_fd == -1) {
+        throw std::runtime_error("Failed to setup io_uring: " + std::string(strerror(errno)));
+    }
+    _features = params.features;
+
+    _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (_features & IORING_FEAT_SINGLE_MMAP) {
+        _sq_size = _cq_size = std::max(_sq_size, _cq_size);
+    }
+
+    _sq_ptr = mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+    if (_sq_ptr == MAP_FAILED) {
+        close(_fd);
+        throw std::runtime_error("Failed to map io_uring: " + std::string(strerror(errno)));
+    }
+
+    if (_features & IORING_FEAT_SINGLE_MMAP) {
+        _cq_ptr = _sq_ptr;
+    } else {
+        _cq_ptr = mmap(nullptr, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+        if (_cq_ptr == MAP_FAILED) {
+            munmap(_sq_ptr, _sq_size);
+            close(_fd);
+            throw std::runtime_error("Failed to map io_uring: " + std::string(strerror(errno)));
+        }
+    }
+
+    _sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (_cq_ptr != _sq_ptr) {
+            munmap(_cq_ptr, _cq_size);
+        }
+        munmap(_sq_ptr, _sq_size);
+        close(_fd);
+        throw std::runtime_error("Failed to map io_uring: " + std::string(strerror(errno)));
+    }
+    _sqes = static_cast<struct io_uring_sqe *>(sqes);
+
+    char *sq = static_cast<char *>(_sq_ptr);
+    _sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    _sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    _sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    _sq_entries = params.sq_entries;
+    _sqe_tail = *_sq_tail;
+
+    // Entries are always used in order, so index array maps each slot onto itself
+    unsigned *array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < _sq_entries; i++) {
+        array[i] = i;
+    }
+
+    char *cq = static_cast<char *>(_cq_ptr);
+    _cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    _cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    _cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+// See Ring.h
+Ring::~Ring() {
+    munmap(_sqes, _sqes_size);
+    if (_cq_ptr != _sq_ptr) {
+        munmap(_cq_ptr, _cq_size);
+    }
+    munmap(_sq_ptr, _sq_size);
+    close(_fd);
+}
+
+// See Ring.h
+struct io_uring_sqe *Ring::Sqe() {
+    if (_sqe_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) >= _sq_entries) {
+        Submit(0);
+        if (_sqe_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) >= _sq_entries) {
+            throw std::runtime_error("io_uring submission queue is full");
+        }
+    }
+
+    struct io_uring_sqe *sqe = &_sqes[_sqe_tail & _sq_mask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    _sqe_tail++;
+    return sqe;
+}
+
+// See Ring.h
+bool Ring::Submit(unsigned wait_nr) {
+    // Entries kernel failed to take last time are submitted again
+    unsigned to_submit = _sqe_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    __atomic_store_n(_sq_tail, _sqe_tail, __ATOMIC_RELEASE);
+    if (to_submit == 0 && wait_nr == 0) {
+        return true;
+    }
+
+    int result = io_uring_enter(_fd, to_submit, wait_nr, wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0);
+    if (result == -1) {
+        // Completion queue is overflown or there is no memory for the requests, either way
+        // completions are to be reaped first
+        if (errno == EINTR || errno == EBUSY || errno == EAGAIN) {
+            return false;
+        }
+        throw std::runtime_error("Failed to submit io_uring requests: " + std::string(strerror(errno)));
+    }
+    return true;
+}
+
+// See Ring.h
+int Ring::Register(unsigned opcode, const void *arg, unsigned nr) {
+    if (io_uring_register(_fd, opcode, arg, nr) == -1) {
+        return -errno;
+    }
+    return 0;
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,100 @@
+#ifndef AFINA_NETWORK_URING_RING_H
+#define AFINA_NETWORK_URING_RING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+/**
+ * # io_uring instance
+ * Thin wrapper over the raw syscalls, there is no liburing dependency. Submission and completion
+ * queues are shared with the kernel through mmap, so preparing request and reaping its result
+ * cost no syscall at all: single io_uring_enter submits everything prepared so far and waits
+ * for completions.
+ *
+ * Ring isn't thread safe, it is supposed to be owned by a single thread.
+ */
+class Ring {
+public:
+    /**
+     * Creates ring with the given number of submission entries, throws std::runtime_error if
+     * kernel doesn't support io_uring
+     */
+    explicit Ring(unsigned entries);
+    ~Ring();
+
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    /**
+     * Returns zeroed submission entry to fill, it goes to the kernel on the next Submit.
+     * Queued entries are submitted right away if the queue is full
+     */
+    struct io_uring_sqe *Sqe();
+
+    /**
+     * Submits prepared entries and waits until at least wait_nr completions are there. Returns
+     * false if wait was interrupted, throws std::runtime_error on other errors
+     */
+    bool Submit(unsigned wait_nr);
+
+    /**
+     * Calls handler for every completion ready so far and marks them seen, returns number
+     * of completions handled. Handler is free to prepare new entries
+     */
+    template <typename F> unsigned Reap(F handler) {
+        unsigned head = *_cq_head;
+        unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+        unsigned n = 0;
+        for (; head != tail; head++, n++) {
+            handler(_cqes[head & _cq_mask]);
+        }
+        __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+        return n;
+    }
+
+    /**
+     * Registers resources of the ring, see io_uring_register(2). Returns -errno on failure
+     */
+    int Register(unsigned opcode, const void *arg, unsigned nr);
+
+    // Features kernel reported for the ring
+    inline uint32_t Features() const { return _features; }
+
+private:
+    int _fd;
+    uint32_t _features;
+
+    // Mappings shared with the kernel
+    void *_sq_ptr;
+    std::size_t _sq_size;
+    void *_cq_ptr;
+    std::size_t _cq_size;
+    struct io_uring_sqe *_sqes;
+    std::size_t _sqes_size;
+
+    // Submission queue, entries up to _sqe_tail are prepared, but kernel sees only those
+    // published by Submit
+    unsigned *_sq_head;
+    unsigned *_sq_tail;
+    unsigned _sq_mask;
+    unsigned _sq_entries;
+    unsigned _sqe_tail;
+
+    // Completion queue
+    unsigned *_cq_head;
+    unsigned *_cq_tail;
+    unsigned _cq_mask;
+    struct io_uring_cqe *_cqes;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_RING_H
@@ -0,0 +1,62 @@
+#ifndef AFINA_NETWORK_URING_SERVER_H
+#define AFINA_NETWORK_URING_SERVER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <afina/network/Server.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+// Forward declaration, see Worker.h
+class Worker;
+
+/**
+ * # Network resource manager implementation
+ * io_uring based server. Each worker has its own ring and its own listening socket bound to the
+ * same port with SO_REUSEPORT, so kernel spreads new connections between workers and they share
+ * nothing but the storage. There are no acceptor threads, multishot accept of the worker makes
+ * them needless
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+protected:
+    // Opens socket listening on the port, bound with SO_REUSEPORT so that every worker could
+    // have one. Socket is left blocking, io_uring waits for connections itself
+    int Listen(uint16_t port);
+
+private:
+    // logger to use
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Curstom event "device" used to wakeup workers
+    int _event_fd;
+
+    // threads serving connections
+    std::vector<std::unique_ptr<Worker>> _workers;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_SERVER_H
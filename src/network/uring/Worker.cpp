@@ -0,0 +1,384 @@
+#include "Worker.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/logging/Service.h>
+
+#include "Connection.h"
+#include "Ring.h"
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+constexpr unsigned Worker::kRingEntries;
+constexpr unsigned Worker::kBuffers;
+constexpr std::size_t Worker::kBufferSize;
+constexpr unsigned Worker::kFiles;
+
+// Request kind is kept in the low bits of user_data, the rest is the connection it is for
+enum Op : uint64_t { kAccept = 1, kWake, kRecv, kSend, kCancel, kClose, kCancelAll };
+static constexpr uint64_t kOpMask = 7;
+
+static inline uint64_t Tag(Connection *pconn, Op op) { return reinterpret_cast<uint64_t>(pconn) | op; }
+
+// Buffer group of the input buffers
+static constexpr uint16_t kBufferGroup = 0;
+
+// See Worker.h
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+               Network::ProtocolType protocol, Logging::Trace trace)
+    : _pStorage(ps), _pLogging(pl), _protocol(protocol), _trace(std::move(trace)), isRunning(false),
+      _server_socket(-1), _event_fd(-1), _accepting(false), _fixed_files(false), _draining(false),
+      _buf_ring(nullptr), _buf_ring_size(0), _buffers(nullptr), _buf_tail(0) {}
+
+// See Worker.h
+Worker::~Worker() {
+    // Ring goes first, kernel must not touch buffers after they are gone
+    _ring.reset();
+    if (_buf_ring != nullptr) {
+        munmap(_buf_ring, _buf_ring_size);
+    }
+    delete[] _buffers;
+    if (_server_socket != -1) {
+        close(_server_socket);
+    }
+}
+
+// See Worker.h
+void Worker::Start(int server_socket, int event_fd) {
+    if (isRunning.exchange(true) == false) {
+        assert(!_ring);
+        _server_socket = server_socket;
+        _event_fd = event_fd;
+        _logger = _pLogging->select("network.worker");
+
+        _ring.reset(new Ring(kRingEntries));
+
+        // Ring of the buffers must be page aligned, so it is mapped rather than allocated
+        _buf_ring_size = kBuffers * sizeof(struct io_uring_buf);
+        void *buf_ring = mmap(nullptr, _buf_ring_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+        if (buf_ring == MAP_FAILED) {
+            throw std::runtime_error("Failed to map buffer ring: " + std::string(strerror(errno)));
+        }
+        _buf_ring = static_cast<struct io_uring_buf_ring *>(buf_ring);
+        _buffers = new char[kBuffers * kBufferSize];
+
+        struct io_uring_buf_reg reg;
+        std::memset(&reg, 0, sizeof(reg));
+        reg.ring_addr = reinterpret_cast<uint64_t>(_buf_ring);
+        reg.ring_entries = kBuffers;
+        reg.bgid = kBufferGroup;
+        int result = _ring->Register(IORING_REGISTER_PBUF_RING, &reg, 1);
+        if (result < 0) {
+            throw std::runtime_error("Failed to register buffer ring: " + std::string(strerror(-result)));
+        }
+        for (unsigned i = 0; i < kBuffers; i++) {
+            Recycle(i);
+        }
+
+        // Sockets are registered only if there is a room for them, plain descriptors work as well
+        struct io_uring_rsrc_register files;
+        std::memset(&files, 0, sizeof(files));
+        files.nr = kFiles;
+        files.flags = IORING_RSRC_REGISTER_SPARSE;
+        result = _ring->Register(IORING_REGISTER_FILES2, &files, sizeof(files));
+        _fixed_files = result == 0;
+        if (!_fixed_files) {
+            _logger->warn("Failed to register files, plain descriptors are used: {}", strerror(-result));
+        }
+
+        Accept();
+        Wait(_event_fd);
+        _thread = std::thread(&Worker::OnRun, this);
+    }
+}
+
+// See Worker.h
+void Worker::Stop() { isRunning = false; }
+
+// See Worker.h
+void Worker::Join() {
+    assert(_thread.joinable());
+    _thread.join();
+}
+
+// See Worker.h
+void Worker::OnRun() {
+    assert(_ring);
+    _logger->trace("OnRun");
+
+    // Requests prepared while handling completions go to the kernel along with the next wait
+    auto handler = [this](const struct io_uring_cqe &cqe) { OnComplete(cqe); };
+    while (isRunning) {
+        _ring->Submit(1);
+        _ring->Reap(handler);
+    }
+
+    // Everything kernel is doing is cancelled, connections are closed once it confirms that
+    _draining = true;
+    struct io_uring_sqe *sqe = _ring->Sqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY | IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = Tag(nullptr, kCancelAll);
+
+    std::unordered_set<Connection *> connections(_connections);
+    for (auto pconn : connections) {
+        pconn->_closing = true;
+        Update(pconn);
+    }
+    while (_accepting || !_connections.empty()) {
+        _ring->Submit(1);
+        _ring->Reap(handler);
+    }
+
+    // No more connections are accepted by this worker
+    close(_server_socket);
+    _server_socket = -1;
+    _logger->warn("Worker stopped");
+}
+
+// See Worker.h
+void Worker::OnComplete(const struct io_uring_cqe &cqe) {
+    Connection *pconn = reinterpret_cast<Connection *>(cqe.user_data & ~kOpMask);
+    switch (cqe.user_data & kOpMask) {
+    case kAccept:
+        OnAccept(cqe);
+        break;
+
+    case kWake:
+        // Server signals to stop, loop sees that
+        break;
+
+    case kRecv:
+        OnRecv(pconn, cqe);
+        Update(pconn);
+        break;
+
+    case kSend:
+        OnSend(pconn, cqe);
+        Update(pconn);
+        break;
+
+    case kCancel:
+        pconn->_cancelling = false;
+        pconn->_inflight--;
+        Update(pconn);
+        break;
+
+    case kClose:
+        _logger->debug("Connection on descriptor {} closed", pconn->_socket);
+        _connections.erase(pconn);
+        delete pconn;
+        break;
+
+    case kCancelAll:
+        break;
+    }
+}
+
+// See Worker.h
+void Worker::OnAccept(const struct io_uring_cqe &cqe) {
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        _accepting = false;
+    }
+
+    if (cqe.res >= 0) {
+        _logger->debug("Accepted connection on descriptor {}", cqe.res);
+        Connection *pconn = new Connection(cqe.res, _pStorage, _protocol, _trace);
+        _connections.insert(pconn);
+        pconn->_closing = _draining;
+        Update(pconn);
+    } else if (cqe.res != -ECANCELED && cqe.res != -ECONNABORTED && cqe.res != -EINTR) {
+        _logger->error("Failed to accept socket: {}", strerror(-cqe.res));
+    }
+
+    // Kernel could end multishot request at will, so it is armed once again
+    if (!_accepting && !_draining) {
+        Accept();
+    }
+}
+
+// See Worker.h
+void Worker::OnRecv(Connection *pconn, const struct io_uring_cqe &cqe) {
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        pconn->_receiving = false;
+        pconn->_inflight--;
+    }
+
+    if (cqe.res > 0) {
+        assert(cqe.flags & IORING_CQE_F_BUFFER);
+        uint16_t bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+
+        // Input which arrived after client has quit or connection failed is dropped
+        if (!pconn->_eof && !pconn->_closing) {
+            _logger->debug("Got {} bytes from socket {}", cqe.res, pconn->_socket);
+            try {
+                if (!pconn->_session.Process(_buffers + bid * kBufferSize, cqe.res)) {
+                    pconn->_eof = true;
+                }
+            } catch (std::runtime_error &ex) {
+                _logger->error("Failed to process connection on descriptor {}: {}", pconn->_socket, ex.what());
+                pconn->_closing = true;
+            }
+        }
+        Recycle(bid);
+    } else if (cqe.res == 0) {
+        _logger->debug("Connection on descriptor {} is closed by client", pconn->_socket);
+        pconn->_eof = true;
+    } else if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+        // Out of buffers recv is just armed once again, cancelled one is either paused or closing
+        _logger->error("Failed to read connection on descriptor {}: {}", pconn->_socket, strerror(-cqe.res));
+        pconn->_closing = true;
+    }
+}
+
+// See Worker.h
+void Worker::OnSend(Connection *pconn, const struct io_uring_cqe &cqe) {
+    pconn->_sending = false;
+    pconn->_inflight--;
+    if (cqe.res < 0) {
+        if (cqe.res != -ECANCELED) {
+            _logger->error("Failed to send response: {}", strerror(-cqe.res));
+        }
+        pconn->_closing = true;
+        return;
+    }
+    pconn->_session.Consume(cqe.res);
+}
+
+// See Worker.h
+void Worker::Update(Connection *pconn) {
+    if (!pconn->_closing) {
+        if (pconn->_session.HasOutput() && !pconn->_sending) {
+            Send(pconn);
+        }
+
+        // Client which doesn't read responses isn't allowed to queue more of them
+        bool wanted = !pconn->_eof && pconn->_session.OutputSize() < Connection::kMaxOutput;
+        if (wanted && !pconn->_receiving && !pconn->_cancelling) {
+            Receive(pconn);
+        } else if (!wanted && pconn->_receiving && !pconn->_cancelling) {
+            Cancel(pconn);
+        }
+
+        if (pconn->_eof && !pconn->_session.HasOutput()) {
+            pconn->_closing = true;
+        }
+    }
+
+    if (pconn->_closing) {
+        if (pconn->_receiving && !pconn->_cancelling) {
+            Cancel(pconn);
+        } else if (pconn->_inflight == 0) {
+            Close(pconn);
+        }
+    }
+}
+
+// See Worker.h
+void Worker::Accept() {
+    struct io_uring_sqe *sqe = _ring->Sqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = _server_socket;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    if (_fixed_files) {
+        sqe->file_index = IORING_FILE_INDEX_ALLOC;
+    } else {
+        sqe->accept_flags = SOCK_CLOEXEC;
+    }
+    sqe->user_data = Tag(nullptr, kAccept);
+    _accepting = true;
+}
+
+// See Worker.h
+void Worker::Wait(int event_fd) {
+    struct io_uring_sqe *sqe = _ring->Sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = event_fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = Tag(nullptr, kWake);
+}
+
+// See Worker.h
+void Worker::Receive(Connection *pconn) {
+    struct io_uring_sqe *sqe = _ring->Sqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = pconn->_socket;
+    sqe->flags = IOSQE_BUFFER_SELECT | (_fixed_files ? IOSQE_FIXED_FILE : 0);
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = Tag(pconn, kRecv);
+    pconn->_receiving = true;
+    pconn->_inflight++;
+}
+
+// See Worker.h
+void Worker::Send(Connection *pconn) {
+    // Kernel reads output right from the chunks, they must stay as is until send completes
+    pconn->_msg.msg_iovlen = pconn->_session.Gather(pconn->_iov, Protocol::Session::kMaxIov);
+    pconn->_session.Seal();
+
+    struct io_uring_sqe *sqe = _ring->Sqe();
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = pconn->_socket;
+    sqe->flags = _fixed_files ? IOSQE_FIXED_FILE : 0;
+    sqe->addr = reinterpret_cast<uint64_t>(&pconn->_msg);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = Tag(pconn, kSend);
+    pconn->_sending = true;
+    pconn->_inflight++;
+}
+
+// See Worker.h
+void Worker::Cancel(Connection *pconn) {
+    struct io_uring_sqe *sqe = _ring->Sqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = Tag(pconn, kRecv);
+    sqe->user_data = Tag(pconn, kCancel);
+    pconn->_cancelling = true;
+    pconn->_inflight++;
+}
+
+// See Worker.h
+void Worker::Close(Connection *pconn) {
+    struct io_uring_sqe *sqe = _ring->Sqe();
+    sqe->opcode = IORING_OP_CLOSE;
+    if (_fixed_files) {
+        // Registered socket is told by its slot, counted from one
+        sqe->file_index = pconn->_socket + 1;
+    } else {
+        sqe->fd = pconn->_socket;
+    }
+    sqe->user_data = Tag(pconn, kClose);
+    pconn->_inflight++;
+}
+
+// See Worker.h
+void Worker::Recycle(uint16_t bid) {
+    // Entries overlay the ring header, its bufs member ends up at the wrong offset in C++
+    struct io_uring_buf &buf = reinterpret_cast<struct io_uring_buf *>(_buf_ring)[_buf_tail & (kBuffers - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(_buffers + bid * kBufferSize);
+    buf.len = kBufferSize;
+    buf.bid = bid;
+    _buf_tail++;
+    __atomic_store_n(&_buf_ring->tail, _buf_tail, __ATOMIC_RELEASE);
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
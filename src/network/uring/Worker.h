@@ -0,0 +1,191 @@
+#ifndef AFINA_NETWORK_URING_WORKER_H
+#define AFINA_NETWORK_URING_WORKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+
+#include <afina/logging/Trace.h>
+#include <afina/network/Server.h>
+
+struct io_uring_buf_ring;
+struct io_uring_cqe;
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+namespace Logging {
+class Service;
+}
+
+namespace Network {
+namespace Uring {
+
+// Forward declaration, see Connection.h and Ring.h
+class Connection;
+class Ring;
+
+/**
+ * # Thread running io_uring
+ * On Start spawns background thread that accepts connections on the given server socket and
+ * serves them. Unlike epoll, kernel is asked to do the IO rather than tell when it could be done:
+ * - single multishot accept produces every new connection of the listener
+ * - single multishot recv per connection produces its input, each chunk in one of the buffers
+ *   worker has provided to the kernel in advance, so no memory waits for idle clients
+ * - output is sent with sendmsg right from the session chunks, which are sealed until it completes
+ *
+ * Requests are submitted in batches along with waiting for completions, so busy worker makes a
+ * single syscall per loop no matter how many connections it serves. If kernel allows, sockets
+ * are registered in the ring and never appear in the file table of the process, that saves
+ * reference counting on every request.
+ *
+ * Slow commands are never deferred, there is no pool to run them on.
+ */
+class Worker {
+public:
+    // Number of submission entries in the ring
+    static constexpr unsigned kRingEntries = 1024;
+
+    // Buffers provided to the kernel for the input, number must be a power of two
+    static constexpr unsigned kBuffers = 256;
+    static constexpr std::size_t kBufferSize = 16 * 1024;
+
+    // Slots in the table of registered sockets
+    static constexpr unsigned kFiles = 16384;
+
+    /**
+     * Connections accepted by worker speak the given protocol, each of them traces requests
+     * with a copy of the given trace
+     */
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           Network::ProtocolType protocol, Logging::Trace trace);
+    ~Worker();
+
+    /**
+     * Sets ring up and spawns background thread serving connections of the given server
+     * socket, worker takes ownership of it. event_fd is used by server to wake it up. Throws
+     * std::runtime_error if kernel lacks features worker relies on
+     */
+    void Start(int server_socket, int event_fd);
+
+    /**
+     * Signal background thread to stop. Worker stops to accept new connections and cancels
+     * everything kernel is doing for the existing ones, then closes them
+     */
+    void Stop();
+
+    /**
+     * Blocks calling thread until background one for this worker is actually
+     * been destoryed
+     */
+    void Join();
+
+protected:
+    /**
+     * Method executing by background thread
+     */
+    void OnRun();
+
+    /**
+     * Handles completion of the request
+     */
+    void OnComplete(const struct io_uring_cqe &cqe);
+
+    /**
+     * Handles new connection or failure of the accept
+     */
+    void OnAccept(const struct io_uring_cqe &cqe);
+
+    /**
+     * Handles input of the connection, buffer it is in goes back to the kernel afterwards
+     */
+    void OnRecv(Connection *pconn, const struct io_uring_cqe &cqe);
+
+    /**
+     * Handles output sent to the client
+     */
+    void OnSend(Connection *pconn, const struct io_uring_cqe &cqe);
+
+    /**
+     * Submits requests connection needs next: send of pending output, recv of more input or
+     * cancel of the recv once connection has enough. Connection done with is closed as soon
+     * as kernel completes everything it is doing for it
+     */
+    void Update(Connection *pconn);
+
+    // Request submission
+    void Accept();
+    void Wait(int event_fd);
+    void Receive(Connection *pconn);
+    void Send(Connection *pconn);
+    void Cancel(Connection *pconn);
+    void Close(Connection *pconn);
+
+    /**
+     * Gives buffer back to the kernel
+     */
+    void Recycle(uint16_t bid);
+
+private:
+    Worker(Worker &) = delete;
+    Worker &operator=(Worker &) = delete;
+
+    // afina services
+    std::shared_ptr<Afina::Storage> _pStorage;
+
+    // afina services
+    std::shared_ptr<Afina::Logging::Service> _pLogging;
+
+    // Logger to be used
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Settings of the new connections
+    Network::ProtocolType _protocol;
+    Logging::Trace _trace;
+
+    // Flag signals that thread should continue to operate
+    std::atomic<bool> isRunning;
+
+    // Thread serving requests in this worker
+    std::thread _thread;
+
+    // Ring owned by worker
+    std::unique_ptr<Ring> _ring;
+
+    // Socket to accept new connections on, owned by worker
+    int _server_socket;
+
+    // Eventfd server uses to wake worker up
+    int _event_fd;
+
+    // Whether multishot accept is armed
+    bool _accepting;
+
+    // Whether sockets are registered in the ring
+    bool _fixed_files;
+
+    // Worker is stopping, all connections are to be closed
+    bool _draining;
+
+    // Ring of the buffers provided to the kernel and memory of the buffers
+    struct io_uring_buf_ring *_buf_ring;
+    std::size_t _buf_ring_size;
+    char *_buffers;
+    uint16_t _buf_tail;
+
+    // Connections served by worker
+    std::unordered_set<Connection *> _connections;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+#endif // AFINA_NETWORK_URING_WORKER_H
@@ -0,0 +1,308 @@
+#include "BinaryParser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <endian.h>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+#include <afina/execute/Stats.h>
+
+namespace Afina {
+namespace Protocol {
+
+constexpr uint8_t BinaryParser::kRequestMagic;
+constexpr uint8_t BinaryParser::kResponseMagic;
+constexpr std::size_t BinaryParser::kHeaderSize;
+constexpr std::size_t BinaryParser::kMaxBody;
+
+// Fields of the packet could be unaligned, so they are copied out
+static inline uint16_t load16(const char *p) {
+    uint16_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return be16toh(v);
+}
+
+static inline uint32_t load32(const char *p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return be32toh(v);
+}
+
+// Exptime of the packet is unsigned, the ones beyond int32 are far in the future anyway
+static inline int64_t load_deadline(const char *p) {
+    uint32_t exptime = load32(p);
+    return Execute::Deadline(static_cast<int32_t>(std::min<uint32_t>(exptime, INT32_MAX)));
+}
+
+// See BinaryParser.h
+bool BinaryParser::Parse(const char *input, const std::size_t size, std::size_t &parsed) {
+    parsed = 0;
+    if (parse_complete) {
+        return true;
+    }
+
+    // Most of the time the whole packet is in the input, so it could be used right there
+    if (pending.empty() && size >= kHeaderSize) {
+        decode(input);
+        if (size - kHeaderSize >= body_length) {
+            body = input + kHeaderSize;
+            parsed = kHeaderSize + body_length;
+            parse_complete = true;
+            return true;
+        }
+    }
+
+    while (parsed < size) {
+        std::size_t want = kHeaderSize;
+        if (pending.size() >= kHeaderSize) {
+            want += body_length;
+        }
+
+        std::size_t take = std::min(want - pending.size(), size - parsed);
+        pending.append(input + parsed, take);
+        parsed += take;
+
+        if (pending.size() == kHeaderSize) {
+            decode(pending.data());
+        }
+
+        if (pending.size() >= kHeaderSize && pending.size() == kHeaderSize + body_length) {
+            body = pending.data() + kHeaderSize;
+            parse_complete = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+// See BinaryParser.h
+void BinaryParser::decode(const char *header) {
+    if (static_cast<uint8_t>(header[0]) != kRequestMagic) {
+        throw std::runtime_error("Invalid binary request magic");
+    }
+
+    opcode = static_cast<uint8_t>(header[1]);
+    key_length = load16(header + 2);
+    extras_length = static_cast<uint8_t>(header[4]);
+    body_length = load32(header + 8);
+    std::memcpy(&opaque, header + 12, sizeof(opaque)); // sent back as is
+
+    if (body_length > kMaxBody) {
+        throw std::runtime_error("Binary request body is too large");
+    }
+    if (std::size_t(key_length) + extras_length > body_length) {
+        throw std::runtime_error("Invalid binary request lengths");
+    }
+}
+
+// See BinaryParser.h
+void BinaryParser::Execute(Storage &storage, std::string &out) {
+    if (!parse_complete) {
+        throw std::runtime_error("There is no parsed binary request");
+    }
+
+    std::string key(body + extras_length, key_length);
+    const char *value = body + extras_length + key_length;
+    std::size_t value_size = body_length - extras_length - key_length;
+
+    bool quiet = false;
+    switch (opcode) {
+    case oGetQ:
+    case oGetKQ:
+    case oGatQ:
+        quiet = true;
+    // fall through
+    case oGet:
+    case oGetK:
+    case oGat: {
+        bool touch = opcode == oGat || opcode == oGatQ;
+        if (extras_length != (touch ? 4 : 0) || key_length == 0 || value_size != 0) {
+            return error(out, sInvalid, "Invalid arguments");
+        }
+
+        std::string result;
+        bool found = storage.Get(key, result);
+        if (found && touch) {
+            found = storage.Expire(key, load_deadline(body));
+        }
+        if (!found) {
+            if (!quiet) {
+                error(out, sNotFound, "Not found");
+            }
+            return;
+        }
+
+        // Flags aren't stored, so they are always zero
+        const char flags[4] = {0, 0, 0, 0};
+        bool with_key = opcode == oGetK || opcode == oGetKQ;
+        return respond(out, sOk, flags, sizeof(flags), with_key ? key.data() : nullptr, with_key ? key.size() : 0,
+                       result.data(), result.size());
+    }
+
+    case oSetQ:
+    case oAddQ:
+    case oReplaceQ:
+        quiet = true;
+    // fall through
+    case oSet:
+    case oAdd:
+    case oReplace: {
+        if (extras_length != 8 || key_length == 0) {
+            return error(out, sInvalid, "Invalid arguments");
+        }
+
+        // Extras are flags and exptime, flags aren't stored
+        std::string data(value, value_size);
+        int64_t deadline = load_deadline(body + 4);
+        Status status = sOk;
+        if (opcode == oSet || opcode == oSetQ) {
+            status = storage.Put(key, data, deadline) ? sOk : sTooLarge;
+        } else if (opcode == oAdd || opcode == oAddQ) {
+            status = storage.PutIfAbsent(key, data, deadline) ? sOk : sExists;
+        } else {
+            status = storage.Set(key, data, deadline) ? sOk : sNotFound;
+        }
+
+        if (status != sOk) {
+            return error(out, status, status == sExists ? "Data exists for key" : "Not stored");
+        } else if (!quiet) {
+            respond(out, sOk);
+        }
+        return;
+    }
+
+    case oAppendQ:
+    case oPrependQ:
+        quiet = true;
+    // fall through
+    case oAppend:
+    case oPrepend: {
+        if (extras_length != 0 || key_length == 0) {
+            return error(out, sInvalid, "Invalid arguments");
+        }
+
+        // Item keeps its expiration time
+        std::string data(value, value_size);
+        bool stored = opcode == oAppend || opcode == oAppendQ ? storage.Append(key, data) : storage.Prepend(key, data);
+        if (!stored) {
+            return error(out, sNotStored, "Not stored");
+        }
+        if (!quiet) {
+            respond(out, sOk);
+        }
+        return;
+    }
+
+    case oTouch:
+        if (extras_length != 4 || key_length == 0 || value_size != 0) {
+            return error(out, sInvalid, "Invalid arguments");
+        }
+
+        if (!storage.Expire(key, load_deadline(body))) {
+            return error(out, sNotFound, "Not found");
+        }
+        return respond(out, sOk);
+
+    case oDeleteQ:
+        quiet = true;
+    // fall through
+    case oDelete:
+        if (extras_length != 0 || key_length == 0 || value_size != 0) {
+            return error(out, sInvalid, "Invalid arguments");
+        }
+
+        if (!storage.Delete(key)) {
+            return error(out, sNotFound, "Not found");
+        } else if (!quiet) {
+            respond(out, sOk);
+        }
+        return;
+
+    case oStat: {
+        // Each stat is a separate packet, empty one terminates the list. Key selects the group
+        std::vector<std::pair<std::string, std::string>> stats;
+        if (!Execute::Stats::Collect(storage, key, stats)) {
+            return error(out, sNotFound, "Not found");
+        }
+        for (auto &stat : stats) {
+            respond(out, sOk, nullptr, 0, stat.first.data(), stat.first.size(), stat.second.data(),
+                    stat.second.size());
+        }
+        return respond(out, sOk);
+    }
+
+    case oNoop:
+        return respond(out, sOk);
+
+    case oQuitQ:
+        quit = true;
+        return;
+
+    case oQuit:
+        quit = true;
+        return respond(out, sOk);
+
+    default:
+        return error(out, sUnknownCommand, "Unknown command");
+    }
+}
+
+// See BinaryParser.h
+void BinaryParser::respond(std::string &out, Status status, const char *extras, std::size_t extras_size,
+                           const char *key, std::size_t key_size, const char *value, std::size_t value_size) const {
+    char header[kHeaderSize];
+    std::memset(header, 0, sizeof(header));
+
+    uint16_t key_be = htobe16(key_size);
+    uint16_t status_be = htobe16(status);
+    uint32_t body_be = htobe32(extras_size + key_size + value_size);
+
+    header[0] = static_cast<char>(kResponseMagic);
+    header[1] = static_cast<char>(opcode);
+    std::memcpy(header + 2, &key_be, sizeof(key_be));
+    header[4] = static_cast<char>(extras_size);
+    std::memcpy(header + 6, &status_be, sizeof(status_be));
+    std::memcpy(header + 8, &body_be, sizeof(body_be));
+    std::memcpy(header + 12, &opaque, sizeof(opaque));
+
+    out.append(header, sizeof(header));
+    if (extras_size > 0) {
+        out.append(extras, extras_size);
+    }
+    if (key_size > 0) {
+        out.append(key, key_size);
+    }
+    if (value_size > 0) {
+        out.append(value, value_size);
+    }
+}
+
+// See BinaryParser.h
+void BinaryParser::respond(std::string &out, Status status) const {
+    respond(out, status, nullptr, 0, nullptr, 0, nullptr, 0);
+}
+
+// Errors carry human readable message as a value
+void BinaryParser::error(std::string &out, Status status, const char *message) const {
+    respond(out, status, nullptr, 0, nullptr, 0, message, std::strlen(message));
+}
+
+// See BinaryParser.h
+void BinaryParser::Reset() {
+    opcode = 0;
+    key_length = 0;
+    extras_length = 0;
+    body_length = 0;
+    opaque = 0;
+    body = nullptr;
+    pending.clear();
+    parse_complete = false;
+}
+
+} // namespace Protocol
+} // namespace Afina
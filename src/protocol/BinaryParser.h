@@ -0,0 +1,138 @@
+#ifndef AFINA_PROTOCOL_BINARY_PARSER_H
+#define AFINA_PROTOCOL_BINARY_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Afina {
+class Storage;
+
+namespace Protocol {
+
+/**
+ * # Memcached binary protocol
+ * Each request is a fixed 24 bytes header followed by extras, key and value, so there is
+ * nothing to tokenize: parser only waits for the whole packet and then runs it against
+ * the storage, encoding response right into the output.
+ *
+ * Quiet commands (getq, setq, ...) send nothing back unless there is an error, so clients
+ * could pipeline them and finish a batch with noop.
+ *
+ * Just like text parser this one doesn't copy request out of the input if the whole packet
+ * is there, so Execute must be called before the input buffer gets changed.
+ */
+class BinaryParser {
+public:
+    // First byte of each request, connection is considered binary if it starts with it
+    static constexpr uint8_t kRequestMagic = 0x80;
+
+    // First byte of each response
+    static constexpr uint8_t kResponseMagic = 0x81;
+
+    // Size of the packet header
+    static constexpr std::size_t kHeaderSize = 24;
+
+    // Max size of the packet body, larger requests are considered to be garbage
+    static constexpr std::size_t kMaxBody = 64 * 1024 * 1024;
+
+    // Opcodes of supported commands
+    enum Opcode : uint8_t {
+        oGet = 0x00,
+        oSet = 0x01,
+        oAdd = 0x02,
+        oReplace = 0x03,
+        oDelete = 0x04,
+        oQuit = 0x07,
+        oGetQ = 0x09,
+        oNoop = 0x0a,
+        oGetK = 0x0c,
+        oGetKQ = 0x0d,
+        oAppend = 0x0e,
+        oPrepend = 0x0f,
+        oStat = 0x10,
+        oSetQ = 0x11,
+        oAddQ = 0x12,
+        oReplaceQ = 0x13,
+        oDeleteQ = 0x14,
+        oQuitQ = 0x17,
+        oAppendQ = 0x19,
+        oPrependQ = 0x1a,
+        oTouch = 0x1c,
+        oGat = 0x1d,
+        oGatQ = 0x1e
+    };
+
+    // Response statuses
+    enum Status : uint16_t {
+        sOk = 0x0000,
+        sNotFound = 0x0001,
+        sExists = 0x0002,
+        sTooLarge = 0x0003,
+        sInvalid = 0x0004,
+        sNotStored = 0x0005,
+        sUnknownCommand = 0x0081
+    };
+
+    BinaryParser() : quit(false) { Reset(); }
+
+    /**
+     * Push given bytes into parser input. Returns true once the whole packet is there, see
+     * Parser::Parse. Throws std::runtime_error if input isn't a binary protocol packet
+     *
+     * @param input bytes read from the client
+     * @param size number of bytes in the input
+     * @param parsed output parameter tells how many bytes was consumed
+     * @return true if request has been parsed out
+     */
+    bool Parse(const char *input, const std::size_t size, std::size_t &parsed);
+
+    /**
+     * Runs parsed request against the storage and appends encoded response to the output.
+     * Nothing is appended for successful quiet commands
+     */
+    void Execute(Storage &storage, std::string &out);
+
+    /**
+     * Reset parser so that it could be used to parse out new request
+     */
+    void Reset();
+
+    /**
+     * True if client asked to close connection, server should do it once response is sent.
+     * Stays set after Reset
+     */
+    inline bool Quit() const { return quit; }
+
+    inline uint8_t Code() const { return opcode; }
+
+private:
+    // Decodes and checks header of the packet
+    void decode(const char *header);
+
+    void respond(std::string &out, Status status, const char *extras, std::size_t extras_size, const char *key,
+                 std::size_t key_size, const char *value, std::size_t value_size) const;
+    void respond(std::string &out, Status status) const;
+    void error(std::string &out, Status status, const char *message) const;
+
+    // Request header fields
+    uint8_t opcode;
+    uint16_t key_length;
+    uint8_t extras_length;
+    uint32_t body_length;
+    uint32_t opaque;
+
+    // Request body: extras, key and value. Points either to the input or to the buffer below
+    const char *body;
+
+    // Packet which was split between several input buffers, memory is reused
+    std::string pending;
+
+    bool parse_complete;
+    bool quit;
+};
+
+} // namespace Protocol
+} // namespace Afina
+
+#endif // AFINA_PROTOCOL_BINARY_PARSER_H
@@ -0,0 +1,83 @@
+#include "CommandSlot.h"
+
+#include <stdexcept>
+
+namespace Afina {
+namespace Protocol {
+
+// See CommandSlot.h
+CommandSlot::CommandSlot()
+    : _op(Parser::Op::None), _current(nullptr), _set("", 0, 0), _add("", 0, 0), _replace("", 0, 0),
+      _append("", 0, 0), _prepend("", 0, 0), _get(std::vector<std::string>()), _gat(std::vector<std::string>(), 0),
+      _delete(""), _touch("", 0), _scan("", Execute::Scan::kDefaultCount), _flush_all(0),
+      _meta_get("", Execute::MetaFlags()), _meta_set("", Execute::MetaFlags()), _meta_delete("", Execute::MetaFlags()) {}
+
+// See CommandSlot.h
+void CommandSlot::Execute(Storage &storage, const std::string &args, std::string &out, Execute::Get::Output *items) {
+    // Dynamic type of each member is known, so compiler calls Execute directly
+    switch (_op) {
+    case Parser::Op::Set:
+        _set.Execute(storage, args, out);
+        break;
+    case Parser::Op::Add:
+        _add.Execute(storage, args, out);
+        break;
+    case Parser::Op::Replace:
+        _replace.Execute(storage, args, out);
+        break;
+    case Parser::Op::Append:
+        _append.Execute(storage, args, out);
+        break;
+    case Parser::Op::Prepend:
+        _prepend.Execute(storage, args, out);
+        break;
+    case Parser::Op::Get:
+    case Parser::Op::Gets:
+        if (items != nullptr) {
+            _get.Execute(storage, args, out, *items);
+        } else {
+            _get.Execute(storage, args, out);
+        }
+        break;
+    case Parser::Op::Gat:
+    case Parser::Op::Gats:
+        if (items != nullptr) {
+            _gat.Execute(storage, args, out, *items);
+        } else {
+            _gat.Execute(storage, args, out);
+        }
+        break;
+    case Parser::Op::Delete:
+        _delete.Execute(storage, args, out);
+        break;
+    case Parser::Op::Touch:
+        _touch.Execute(storage, args, out);
+        break;
+    case Parser::Op::Scan:
+        _scan.Execute(storage, args, out);
+        break;
+    case Parser::Op::Stats:
+        _stats.Execute(storage, args, out);
+        break;
+    case Parser::Op::FlushAll:
+        _flush_all.Execute(storage, args, out);
+        break;
+    case Parser::Op::MetaGet:
+        _meta_get.Execute(storage, args, out);
+        break;
+    case Parser::Op::MetaSet:
+        _meta_set.Execute(storage, args, out);
+        break;
+    case Parser::Op::MetaDelete:
+        _meta_delete.Execute(storage, args, out);
+        break;
+    case Parser::Op::MetaNoop:
+        _meta_noop.Execute(storage, args, out);
+        break;
+    default:
+        throw std::runtime_error("There is no command in the slot");
+    }
+}
+
+} // namespace Protocol
+} // namespace Afina
@@ -0,0 +1,84 @@
+#ifndef AFINA_PROTOCOL_COMMAND_SLOT_H
+#define AFINA_PROTOCOL_COMMAND_SLOT_H
+
+#include <string>
+
+#include <afina/execute/Add.h>
+#include <afina/execute/Append.h>
+#include <afina/execute/Delete.h>
+#include <afina/execute/FlushAll.h>
+#include <afina/execute/Gat.h>
+#include <afina/execute/Get.h>
+#include <afina/execute/MetaDelete.h>
+#include <afina/execute/MetaGet.h>
+#include <afina/execute/MetaNoop.h>
+#include <afina/execute/MetaSet.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Replace.h>
+#include <afina/execute/Scan.h>
+#include <afina/execute/Set.h>
+#include <afina/execute/Stats.h>
+#include <afina/execute/Touch.h>
+
+#include "Parser.h"
+
+namespace Afina {
+class Storage;
+
+namespace Protocol {
+
+/**
+ * # Reusable place for the command of a connection
+ * Slot keeps one instance of each command kind, parser fills one of them on each build.
+ * Instances live as long as the connection does, so strings inside of them keep their
+ * memory and typical request is handled without any heap allocation.
+ */
+class CommandSlot {
+public:
+    CommandSlot();
+
+    /**
+     * Command built into the slot last time, nullptr if there is none
+     */
+    inline Execute::Command *Current() const { return _current; }
+
+    /**
+     * Runs the current command. Command kind is known, so there is no virtual call. If items
+     * are given retrieval commands put found values there instead of the output
+     */
+    void Execute(Storage &storage, const std::string &args, std::string &out, Execute::Get::Output *items = nullptr);
+
+private:
+    friend class Parser;
+
+    inline Execute::Command *Use(Parser::Op op, Execute::Command *command) {
+        _op = op;
+        _current = command;
+        return command;
+    }
+
+    Parser::Op _op;
+    Execute::Command *_current;
+
+    Execute::Set _set;
+    Execute::Add _add;
+    Execute::Replace _replace;
+    Execute::Append _append;
+    Execute::Prepend _prepend;
+    Execute::Get _get;
+    Execute::Gat _gat;
+    Execute::Delete _delete;
+    Execute::Touch _touch;
+    Execute::Scan _scan;
+    Execute::Stats _stats;
+    Execute::FlushAll _flush_all;
+    Execute::MetaGet _meta_get;
+    Execute::MetaSet _meta_set;
+    Execute::MetaDelete _meta_delete;
+    Execute::MetaNoop _meta_noop;
+};
+
+} // namespace Protocol
+} // namespace Afina
+
+#endif // AFINA_PROTOCOL_COMMAND_SLOT_H
@@ -1,195 +1,550 @@
 #include "Parser.h"
 
-#include <iostream>
-#include <sstream>
-#include <stdexcept>
+#include <cctype>
+#include <cstring>
 
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
 #include <afina/execute/Command.h>
 #include <afina/execute/Delete.h>
+#include <afina/execute/FlushAll.h>
+#include <afina/execute/Gat.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/MetaDelete.h>
+#include <afina/execute/MetaGet.h>
+#include <afina/execute/MetaNoop.h>
+#include <afina/execute/MetaSet.h>
+#include <afina/execute/Prepend.h>
+#include <afina/execute/Replace.h>
+#include <afina/execute/Scan.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
+#include <afina/execute/Touch.h>
+
+#include "CommandSlot.h"
+#include "Tokenizer.h"
 
 namespace Afina {
 namespace Protocol {
 
+constexpr std::size_t Parser::kMaxLine;
+
+// Command names are told apart by length first, so that each name is compared at most
+// with a couple of candidates
+static Parser::Op recognize(const char *name, std::size_t size) {
+    switch (size) {
+    case 2:
+        if (name[0] != 'm') {
+            break;
+        } else if (name[1] == 'g') {
+            return Parser::Op::MetaGet;
+        } else if (name[1] == 's') {
+            return Parser::Op::MetaSet;
+        } else if (name[1] == 'd') {
+            return Parser::Op::MetaDelete;
+        } else if (name[1] == 'n') {
+            return Parser::Op::MetaNoop;
+        }
+        break;
+
+    case 3:
+        if (std::memcmp(name, "get", 3) == 0) {
+            return Parser::Op::Get;
+        } else if (std::memcmp(name, "set", 3) == 0) {
+            return Parser::Op::Set;
+        } else if (std::memcmp(name, "add", 3) == 0) {
+            return Parser::Op::Add;
+        } else if (std::memcmp(name, "gat", 3) == 0) {
+            return Parser::Op::Gat;
+        }
+        break;
+
+    case 4:
+        if (std::memcmp(name, "gets", 4) == 0) {
+            return Parser::Op::Gets;
+        } else if (std::memcmp(name, "gats", 4) == 0) {
+            return Parser::Op::Gats;
+        } else if (std::memcmp(name, "scan", 4) == 0) {
+            return Parser::Op::Scan;
+        }
+        break;
+
+    case 5:
+        if (std::memcmp(name, "stats", 5) == 0) {
+            return Parser::Op::Stats;
+        } else if (std::memcmp(name, "touch", 5) == 0) {
+            return Parser::Op::Touch;
+        }
+        break;
+
+    case 6:
+        if (std::memcmp(name, "append", 6) == 0) {
+            return Parser::Op::Append;
+        } else if (std::memcmp(name, "delete", 6) == 0) {
+            return Parser::Op::Delete;
+        }
+        break;
+
+    case 7:
+        if (std::memcmp(name, "prepend", 7) == 0) {
+            return Parser::Op::Prepend;
+        } else if (std::memcmp(name, "replace", 7) == 0) {
+            return Parser::Op::Replace;
+        }
+        break;
+
+    case 9:
+        if (std::memcmp(name, "flush_all", 9) == 0) {
+            return Parser::Op::FlushAll;
+        }
+        break;
+    }
+    return Parser::Op::None;
+}
+
+// Parses optional scan page size, arguments are checked by ParseLine already
+static std::size_t scan_count(const std::vector<Slice> &keys) {
+    uint64_t value = Execute::Scan::kDefaultCount;
+    if (keys.size() == 2) {
+        Tokenizer::parse_uint(keys[1].data, keys[1].size, UINT32_MAX, value);
+    }
+    return value;
+}
+
 // See Parse.h
 bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
-    size_t pos;
     parsed = 0;
+    if (parse_complete) {
+        return true;
+    }
 
-    for (pos = 0; pos < size && !parse_complete; pos++) {
-        char c = input[pos];
-        // std::cout << "[" << pos << "] '" << c << "': state=" << int(state) << std::endl;
-
-        switch (state) {
-        case State::sName: {
-            if (c == ' ' || c == '\r') {
-                // std::cout << "parser debug: name='" << name << "'" << std::endl;
-                if (name == "set" || name == "add" || name == "append" || name == "prepend") {
-                    state = State::spKey;
-                } else if (name == "get" || name == "gets") {
-                    state = State::sgKey;
-                } else if (name == "stats") {
-                    state = State::sLF;
-                    continue;
-                } else {
-                    throw std::runtime_error("Unknown command name: " + name);
-                }
-            } else {
-                name.push_back(c);
-            }
-            break;
+    std::size_t eol = Tokenizer::find(input, size, '\n');
+    if (eol == size) {
+        // Too long line is dropped as it goes, error is reported once it ends
+        if (!overflow && line.size() + size > kMaxLine) {
+            overflow = true;
+            line.clear();
         }
-
-        case State::spKey: {
-            if (c == ' ') {
-                state = State::spFlags;
-                keys.push_back(curKey);
-                // std::cout << "parser debug: key[" << keys.size() - 1 << "]='" << curKey << "'" << std::endl;
-            } else {
-                curKey.push_back(c);
-            }
-            break;
+        if (!overflow) {
+            line.append(input, size);
         }
+        parsed = size;
+        return false;
+    }
 
-        case State::sgKey: {
-            if (c == '\r') {
-                keys.push_back(curKey);
-                // std::cout << "parser debug: total '" << keys.size() << " keys" << std::endl;
+    parsed = eol + 1;
+    parse_complete = true;
+    if (overflow || line.size() + eol > kMaxLine) {
+        fail("CLIENT_ERROR line is too long");
+        return true;
+    }
 
-                if (keys.size() == 0) {
-                    throw std::runtime_error("Client provides no key to retrive");
-                }
+    // Most of the time whole line is in the input, so it could be parsed right there
+    const char *data = input;
+    std::size_t length = eol;
+    if (!line.empty()) {
+        line.append(input, eol);
+        data = line.data();
+        length = line.size();
+    }
 
-                curKey.clear();
-                state = State::sLF;
-            } else if (c == ' ') {
-                // std::cout << "parser debug: key[" << keys.size() << "]='" << curKey << "'" << std::endl;
-                state = State::sgKey;
-                keys.push_back(curKey);
-                curKey.clear();
-            } else {
-                curKey.push_back(c);
-            }
-            break;
+    if (length == 0 || data[length - 1] != '\r') {
+        fail("CLIENT_ERROR bad command line termination");
+        return true;
+    }
+
+    // Line buffer is kept until Reset, keys might point into it
+    ParseLine(data, length - 1);
+    return true;
+}
+
+// See Parse.h
+void Parser::fail(const char *message) {
+    if (error == nullptr) {
+        error = message;
+    }
+}
+
+// See Parse.h
+bool Parser::Parse(const std::string &input, size_t &parsed) {
+    bool buffered = !line.empty();
+    if (!Parse(input.data(), input.size(), parsed)) {
+        return false;
+    }
+
+    if (!buffered) {
+        line.assign(input.data(), parsed);
+        for (auto &key : keys) {
+            key.data = line.data() + (key.data - input.data());
         }
+    }
+    return true;
+}
 
-        case State::spFlags: {
-            if (c == ' ') {
-                negative = false;
-                state = State::spExprTimeStart;
-                // std::cout << "parser debug: flags='" << flags << "'" << std::endl;
-            } else if (c >= '0' && c <= '9') {
-                uint32_t f = (flags * 10) + (c - '0');
-                if (f < flags) {
-                    // Overflow
-                    throw std::runtime_error("Flags field overflow");
-                }
-                flags = f;
+// See Parse.h
+void Parser::ParseLine(const char *data, std::size_t size) {
+    // Storage commands: <name> <key> <flags> <exptime> <bytes> [noreply]
+    // Meta commands: <name> <key> [<datalen>] <flag>*
+    bool is_storage = false;
+    bool is_meta = false;
+    std::size_t index = 0;
+    Tokenizer::split(data, size, [this, &is_storage, &is_meta, &index](const char *token, std::size_t length) {
+        switch (index++) {
+        case 0:
+            name.assign(token, length);
+            op = recognize(token, length);
+            if (op == Op::None) {
+                fail("ERROR");
+                return false;
             }
-            break;
-        }
+            is_storage = op == Op::Set || op == Op::Add || op == Op::Replace || op == Op::Append || op == Op::Prepend;
+            is_meta = op == Op::MetaGet || op == Op::MetaSet || op == Op::MetaDelete || op == Op::MetaNoop;
+            return true;
+
+        case 1:
+            keys.push_back(Slice(token, length));
+            return true;
 
-        case State::spExprTimeStart: {
-            if (c == '-') {
-                negative = true;
-                state = State::spExprTime;
-            } else if (c >= '0' && c <= '9') {
-                exprtime = (c - '0');
-                state = State::spExprTime;
+        case 2:
+            if (is_storage) {
+                uint64_t value;
+                if (!Tokenizer::parse_uint(token, length, UINT32_MAX, value)) {
+                    fail("CLIENT_ERROR invalid flags");
+                    return false;
+                }
+                flags = value;
+                return true;
+            } else if (op == Op::MetaSet) {
+                uint64_t value;
+                if (!Tokenizer::parse_uint(token, length, UINT32_MAX, value)) {
+                    fail("CLIENT_ERROR invalid data length");
+                    return false;
+                }
+                bytes = value;
+                return true;
             }
             break;
-        }
 
-        case State::spExprTime: {
-            if (c == ' ') {
-                state = State::spBytes;
-                // std::cout << "parser debug: ExprTime='" << exprtime << "'" << std::endl;
-            } else if (c >= '0' && c <= '9') {
-                int32_t et = exprtime;
-                if (negative) {
-                    et -= (c - '0');
-                    if (et > exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
-                } else {
-                    et += (c - '0');
-                    if (et < exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
+        case 3:
+            if (is_storage) {
+                int64_t value;
+                if (!Tokenizer::parse_int(token, length, INT32_MAX, value)) {
+                    fail("CLIENT_ERROR invalid exptime");
+                    return false;
                 }
-                exprtime = et;
+                exprtime = value;
+                return true;
             }
             break;
-        }
 
-        case State::spBytes: {
-            if (c == '\r') {
-                state = State::sLF;
-                // std::cout << "parser debug: bytes='" << bytes << "'" << std::endl;
-            } else if (c >= '0' && c <= '9') {
-                uint32_t b = (bytes * 10) + (c - '0');
-                if (b < bytes) {
-                    // Overflow
-                    throw std::runtime_error("Bytes field overflow");
+        case 4:
+            if (is_storage) {
+                uint64_t value;
+                if (!Tokenizer::parse_uint(token, length, UINT32_MAX, value)) {
+                    fail("CLIENT_ERROR invalid data length");
+                    return false;
                 }
-                bytes = b;
+                bytes = value;
+                return true;
             }
             break;
-        }
 
-        case State::sLF: {
-            if (c == '\n') {
-                parse_complete = true;
-            } else {
-                std::stringstream err;
-                err << "Invalid char " << (int)c << " at position " << (parsed + pos) << ", \\n expected";
-                throw std::runtime_error(err.str());
+        case 5:
+            if (is_storage && Slice(token, length) == "noreply") {
+                noreply = true;
+                return true;
+            }
+        // fall through
+        default:
+            if (is_storage) {
+                fail("CLIENT_ERROR bad command line format");
+                return false;
             }
             break;
         }
 
-        default:
-            throw std::runtime_error("Unknown state");
+        if (is_meta) {
+            return ParseMetaFlag(token, length);
+        }
+        keys.push_back(Slice(token, length));
+        return true;
+    });
+
+    if (error != nullptr) {
+        return;
+    }
+
+    // Arguments of the other commands are collected as keys, trailing noreply could be told
+    // apart from the key only by position
+    if (op == Op::Delete || op == Op::Touch || op == Op::FlushAll) {
+        std::size_t args = op == Op::Touch ? 2 : (op == Op::Delete ? 1 : 0);
+        if (keys.size() > args && keys.back() == "noreply") {
+            noreply = true;
+            keys.pop_back();
+        }
+    }
+
+    if (index == 0) {
+        fail("ERROR");
+    } else if (is_storage && index != 5 + noreply) {
+        fail("CLIENT_ERROR bad command line format");
+    } else if (op == Op::MetaSet && index < 3) {
+        fail("CLIENT_ERROR bad command line format");
+    } else if (op == Op::MetaNoop && !keys.empty()) {
+        fail("CLIENT_ERROR bad command line format");
+    } else if (op == Op::Stats && keys.size() > 1) {
+        fail("CLIENT_ERROR bad command line format");
+    } else if (op == Op::Stats && keys.size() == 1 && !(keys[0] == "items" || keys[0] == "slabs")) {
+        fail("CLIENT_ERROR bad command line format");
+    } else if (op == Op::FlushAll) {
+        uint64_t delay;
+        if (keys.size() > 1 ||
+            (keys.size() == 1 && !Tokenizer::parse_uint(keys[0].data, keys[0].size, INT32_MAX, delay))) {
+            fail("CLIENT_ERROR bad command line format");
+        } else if (keys.size() == 1) {
+            exprtime = delay;
+        }
+    } else if (op != Op::Stats && op != Op::MetaNoop && keys.empty()) {
+        fail("CLIENT_ERROR bad command line format");
+    } else if (op == Op::Delete && keys.size() != 1) {
+        fail("CLIENT_ERROR bad command line format");
+    } else if (op == Op::Touch || op == Op::Gat || op == Op::Gats) {
+        // touch <key> <exptime>, gat <exptime> <key>*
+        bool touch = op == Op::Touch;
+        int64_t value;
+        if ((touch && keys.size() != 2) || (!touch && keys.size() < 2)) {
+            fail("CLIENT_ERROR bad command line format");
+        } else if (!Tokenizer::parse_int(keys[touch].data, keys[touch].size, INT32_MAX, value)) {
+            fail("CLIENT_ERROR invalid exptime");
+        } else {
+            exprtime = value;
+            keys.erase(touch ? keys.end() - 1 : keys.begin());
+        }
+    } else if (op == Op::Scan) {
+        // Empty page would return the same cursor back, so client never gets to the end
+        uint64_t count;
+        if (keys.size() > 2 ||
+            (keys.size() == 2 &&
+             (!Tokenizer::parse_uint(keys[1].data, keys[1].size, UINT32_MAX, count) || count == 0))) {
+            fail("CLIENT_ERROR invalid scan count");
+        }
+    }
+}
+
+// See Parse.h
+bool Parser::ParseMetaFlag(const char *token, std::size_t length) {
+    const char *allowed = "";
+    if (op == Op::MetaGet) {
+        allowed = "cfkOqstTv";
+    } else if (op == Op::MetaSet) {
+        allowed = "FkMOqT";
+    } else if (op == Op::MetaDelete) {
+        allowed = "kOq";
+    }
+
+    char flag = token[0];
+    if (std::strchr(allowed, flag) == nullptr) {
+        fail("CLIENT_ERROR invalid flag");
+        return false;
+    }
+
+    const char *arg = token + 1;
+    std::size_t arg_size = length - 1;
+    switch (flag) {
+    case 'O':
+        if (arg_size > 32) {
+            fail("CLIENT_ERROR opaque token is too long");
+            return false;
         }
+        meta.opaque.assign(arg, arg_size);
+        break;
+
+    case 'F': {
+        uint64_t value;
+        if (!Tokenizer::parse_uint(arg, arg_size, UINT32_MAX, value)) {
+            fail("CLIENT_ERROR invalid flags");
+            return false;
+        }
+        meta.client_flags = value;
+        break;
     }
 
-    parsed += pos;
-    return parse_complete;
+    case 'T': {
+        int64_t value;
+        if (!Tokenizer::parse_int(arg, arg_size, INT32_MAX, value)) {
+            fail("CLIENT_ERROR invalid exptime");
+            return false;
+        }
+        meta.ttl = value;
+        break;
+    }
+
+    case 'M':
+        if (arg_size != 1 || std::strchr("EAPRSeaprs", arg[0]) == nullptr) {
+            fail("CLIENT_ERROR invalid mode switch");
+            return false;
+        }
+        meta.mode = std::toupper(arg[0]);
+        break;
+
+    default:
+        if (arg_size != 0) {
+            fail("CLIENT_ERROR invalid flag");
+            return false;
+        }
+        break;
+    }
+    meta.set(flag);
+    return true;
 }
 
 // See Parse.h
 std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
-    if (state != State::sLF) {
+    if (!parse_complete || error != nullptr) {
+        return std::unique_ptr<Execute::Command>(nullptr);
+    }
+
+    body_size = bytes;
+    switch (op) {
+    case Op::Set:
+        return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0].str(), flags, exprtime));
+    case Op::Add:
+        return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0].str(), flags, exprtime));
+    case Op::Replace:
+        return std::unique_ptr<Execute::Command>(new Execute::Replace(keys[0].str(), flags, exprtime));
+    case Op::Append:
+        return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0].str(), flags, exprtime));
+    case Op::Prepend:
+        return std::unique_ptr<Execute::Command>(new Execute::Prepend(keys[0].str(), flags, exprtime));
+    case Op::Get:
+    case Op::Gets:
+    case Op::Gat:
+    case Op::Gats: {
+        std::vector<std::string> get_keys;
+        get_keys.reserve(keys.size());
+        for (auto &key : keys) {
+            get_keys.push_back(key.str());
+        }
+
+        bool cas = op == Op::Gets || op == Op::Gats;
+        if (op == Op::Get || op == Op::Gets) {
+            return std::unique_ptr<Execute::Command>(new Execute::Get(get_keys, cas));
+        }
+        return std::unique_ptr<Execute::Command>(new Execute::Gat(get_keys, exprtime, cas));
+    }
+    case Op::Delete:
+        return std::unique_ptr<Execute::Command>(new Execute::Delete(keys[0].str()));
+    case Op::Touch:
+        return std::unique_ptr<Execute::Command>(new Execute::Touch(keys[0].str(), exprtime));
+    case Op::Stats:
+        return std::unique_ptr<Execute::Command>(new Execute::Stats(keys.empty() ? std::string() : keys[0].str()));
+    case Op::FlushAll:
+        return std::unique_ptr<Execute::Command>(new Execute::FlushAll(exprtime));
+    case Op::Scan: {
+        std::size_t count = scan_count(keys);
+        return std::unique_ptr<Execute::Command>(new Execute::Scan(keys[0].str(), count));
+    }
+    case Op::MetaGet:
+        return std::unique_ptr<Execute::Command>(new Execute::MetaGet(keys[0].str(), meta));
+    case Op::MetaSet:
+        return std::unique_ptr<Execute::Command>(new Execute::MetaSet(keys[0].str(), meta));
+    case Op::MetaDelete:
+        return std::unique_ptr<Execute::Command>(new Execute::MetaDelete(keys[0].str(), meta));
+    case Op::MetaNoop:
+        return std::unique_ptr<Execute::Command>(new Execute::MetaNoop());
+    default:
         return std::unique_ptr<Execute::Command>(nullptr);
     }
+}
+
+// See Parse.h
+Execute::Command *Parser::Build(CommandSlot &slot, size_t &body_size) const {
+    if (!parse_complete || error != nullptr) {
+        return nullptr;
+    }
 
     body_size = bytes;
-    if (name == "set") {
-        return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0], flags, exprtime));
-    } else if (name == "add") {
-        return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
-    } else if (name == "append") {
-        return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
-    } else if (name == "get") {
-        return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
-    } else if (name == "stats") {
-        return std::unique_ptr<Execute::Command>(new Execute::Stats());
-    } else {
-        throw std::runtime_error("Unsupported command");
+    switch (op) {
+    case Op::Set:
+        slot._set.Assign(keys[0].data, keys[0].size, flags, exprtime);
+        return slot.Use(op, &slot._set);
+    case Op::Add:
+        slot._add.Assign(keys[0].data, keys[0].size, flags, exprtime);
+        return slot.Use(op, &slot._add);
+    case Op::Replace:
+        slot._replace.Assign(keys[0].data, keys[0].size, flags, exprtime);
+        return slot.Use(op, &slot._replace);
+    case Op::Append:
+        slot._append.Assign(keys[0].data, keys[0].size, flags, exprtime);
+        return slot.Use(op, &slot._append);
+    case Op::Prepend:
+        slot._prepend.Assign(keys[0].data, keys[0].size, flags, exprtime);
+        return slot.Use(op, &slot._prepend);
+    case Op::Get:
+    case Op::Gets:
+        slot._get.Resize(keys.size());
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            keys[i].assign_to(slot._get.key(i));
+        }
+        slot._get.SetCas(op == Op::Gets);
+        return slot.Use(op, &slot._get);
+    case Op::Gat:
+    case Op::Gats:
+        slot._gat.Resize(keys.size());
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            keys[i].assign_to(slot._gat.key(i));
+        }
+        slot._gat.SetCas(op == Op::Gats);
+        slot._gat.SetExpire(exprtime);
+        return slot.Use(op, &slot._gat);
+    case Op::Delete:
+        slot._delete.Assign(keys[0].data, keys[0].size);
+        return slot.Use(op, &slot._delete);
+    case Op::Touch:
+        slot._touch.Assign(keys[0].data, keys[0].size, exprtime);
+        return slot.Use(op, &slot._touch);
+    case Op::Stats:
+        if (keys.empty()) {
+            slot._stats.Assign("", 0);
+        } else {
+            slot._stats.Assign(keys[0].data, keys[0].size);
+        }
+        return slot.Use(op, &slot._stats);
+    case Op::FlushAll:
+        slot._flush_all.Assign(exprtime);
+        return slot.Use(op, &slot._flush_all);
+    case Op::Scan: {
+        std::size_t count = scan_count(keys);
+        slot._scan.Assign(keys[0].data, keys[0].size, count);
+        return slot.Use(op, &slot._scan);
+    }
+    case Op::MetaGet:
+        slot._meta_get.Assign(keys[0].data, keys[0].size, meta);
+        return slot.Use(op, &slot._meta_get);
+    case Op::MetaSet:
+        slot._meta_set.Assign(keys[0].data, keys[0].size, meta);
+        return slot.Use(op, &slot._meta_set);
+    case Op::MetaDelete:
+        slot._meta_delete.Assign(keys[0].data, keys[0].size, meta);
+        return slot.Use(op, &slot._meta_delete);
+    case Op::MetaNoop:
+        return slot.Use(op, &slot._meta_noop);
+    default:
+        return nullptr;
     }
 }
 
 // See Parse.h
 void Parser::Reset() {
-    state = State::sName;
+    line.clear();
+    op = Op::None;
     name.clear();
     keys.clear();
-    curKey.clear();
+    meta.Clear();
     parse_complete = false;
+    overflow = false;
+    error = nullptr;
+    noreply = false;
     flags = 0;
     bytes = 0;
     exprtime = 0;
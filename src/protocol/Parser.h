@@ -8,15 +8,29 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <afina/execute/MetaCommand.h>
+
+#include "Slice.h"
+
 namespace Afina {
 namespace Execute {
 class Command;
 } // namespace Execute
 namespace Protocol {
 
+class CommandSlot;
+
 /**
  * # Memcached protocol parser
- * Parser supports subset of memcached protocol
+ * Parser supports subset of memcached protocol. Command line is located with vectorized
+ * search of the line delimiter and then split onto tokens, see Tokenizer.h
+ *
+ * Parser doesn't copy keys out of the input. Once command is parsed keys are slices of the
+ * buffer passed to the last Parse call, so the buffer must stay untouched until command gets
+ * built. Only a line split between several Parse calls is copied into the parser itself.
+ *
+ * Parser never throws on bad input: invalid line is consumed up to its end and reported with
+ * Error, so that the stream stays in sync and the next line is parsed as usual.
  */
 class Parser {
 public:
@@ -25,11 +39,14 @@ public:
      * Push given string into parser input. Method returns true if it was a command parsed out
      * from comulative input. In a such case method Build will return new command
      *
+     * Unlike the other overload parser keeps its own copy of the command line, so input could
+     * be a temporary
+     *
      * @param input sttring to be added to the parsed input
      * @param parsed output parameter tells how many bytes was consumed from the string
      * @return true if command has been parsed out
      */
-    bool Parse(const std::string &input, size_t &parsed) { return Parse(&input[0], input.size(), parsed); }
+    bool Parse(const std::string &input, size_t &parsed);
 
     /**
      * Push given string into parser input. Method returns true if it was a command parsed out
@@ -48,28 +65,91 @@ public:
      */
     std::unique_ptr<Execute::Command> Build(size_t &body_size) const;
 
+    /**
+     * Same as above, but command is built inside of the given slot which is reused from one
+     * command to another, so there is no heap allocation. Returned command is owned by slot
+     * and is valid until the next build into the same slot
+     */
+    Execute::Command *Build(CommandSlot &slot, size_t &body_size) const;
+
     /**
      * Reset parse so that it could be used to parse out new command
      */
     void Reset();
 
+    // Commands known to parser
+    enum class Op : uint8_t {
+        None,
+        Set,
+        Add,
+        Replace,
+        Append,
+        Prepend,
+        Get,
+        Gets,
+        Gat,
+        Gats,
+        Delete,
+        Touch,
+        Scan,
+        Stats,
+        FlushAll,
+        MetaGet,
+        MetaSet,
+        MetaDelete,
+        MetaNoop
+    };
+
     inline const std::string &Name() const { return name; }
 
-private:
+    inline Op Code() const { return op; }
+
     /**
-     * State of the command parser. Prefixes are:
-     * - s: state for PUT and GET commands
-     * - sp: for PUT commands only
-     * - sg: for GET commands only
+     * Response for the invalid command line, nullptr if line is fine. Parse returns true for
+     * the invalid line as well, so that caller could answer it and go on with the next one
      */
-    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+    inline const char *Error() const { return error; }
 
-    // Current parser state
-    State state;
+    /**
+     * True if command line is followed by the data block. Block might be empty, but its
+     * trailing \r\n is still there
+     */
+    inline bool HasBody() const {
+        return op == Op::Set || op == Op::Add || op == Op::Replace || op == Op::Append || op == Op::Prepend ||
+               op == Op::MetaSet;
+    }
 
-    // vrious fields of the command
+    /**
+     * True if client asked not to send anything back with trailing "noreply" token. Command is
+     * executed as usual, but its response should be dropped
+     */
+    inline bool NoReply() const { return noreply; }
+
+    /**
+     * Keys (or other string arguments) of the parsed command, see note on slices above
+     */
+    inline const std::vector<Slice> &Keys() const { return keys; }
+
+    // Max length of the command line, longer lines are considered to be garbage
+    static constexpr std::size_t kMaxLine = 64 * 1024;
+
+private:
+    // Parse out complete command line without line delimiter
+    void ParseLine(const char *data, std::size_t size);
+
+    // Parse out one flag of meta command, returns false if it is invalid
+    bool ParseMetaFlag(const char *token, std::size_t length);
+
+    // Marks parsed line as invalid, the first error wins
+    void fail(const char *message);
+
+    // Beginning of the command line which was split between input buffers
+    std::string line;
+
+    // vrious fields of the command, memory of both is reused between commands
+    Op op;
     std::string name;
-    std::vector<std::string> keys;
+    std::vector<Slice> keys;
 
     // <flags> is an arbitrary 16-bit unsigned integer (written out in decimal) that the server stores along with
     // the data and sends back when the item is retrieved. Clients may use this as a bit field to store data-specific
@@ -77,7 +157,7 @@ private:
     // instead of 16, but you might want to restrict yourself to 16 bits for compatibility with older versions.
     uint32_t flags;
 
-    // <exptime> is expiration time. If it's 0, the item never expires (although it may be deleted from the cache to
+    // <exptime> is expiration time, delay of flush_all is kept here as well. If it's 0, the item never expires (although it may be deleted from the cache to
     // make place for other items). If it's non-zero (either Unix time or offset in seconds from current time), it is
     // guaranteed that clients will not be able to retrieve this item after the expiration time arrives (measured by
     // server time). If a negative value is given the item is immediately expired.
@@ -88,9 +168,17 @@ private:
     // it's followed by an empty data block).
     uint32_t bytes;
 
-    bool negative;
-    std::string curKey;
+    // Flags of meta commands
+    Execute::MetaFlags meta;
+
+    // Static message for the client if parsed line is invalid
+    const char *error;
+
+    // Line is longer than kMaxLine, the rest of it is dropped until line end
+    bool overflow;
+
     bool parse_complete;
+    bool noreply;
 };
 
 } // namespace Protocol
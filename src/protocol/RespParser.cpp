@@ -0,0 +1,334 @@
+#include "RespParser.h"
+
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+#include <strings.h>
+
+#include <afina/Storage.h>
+
+#include "Tokenizer.h"
+
+namespace Afina {
+namespace Protocol {
+
+constexpr std::size_t RespParser::kMaxArgs;
+constexpr std::size_t RespParser::kMaxBulk;
+constexpr std::size_t RespParser::kMaxLine;
+
+// Command names are case insensitive
+static inline bool is(const Slice &token, const char *name) {
+    return std::strlen(name) == token.size && strncasecmp(token.data, name, token.size) == 0;
+}
+
+// Reply encoders
+static inline void simple(std::string &out, const char *status) { out.append("+").append(status).append("\r\n"); }
+
+static inline void error(std::string &out, const std::string &message) {
+    out.append("-").append(message).append("\r\n");
+}
+
+static inline void integer(std::string &out, int64_t value) {
+    out.append(":").append(std::to_string(value)).append("\r\n");
+}
+
+static inline void bulk(std::string &out, const char *data, std::size_t size) {
+    out.append("$").append(std::to_string(size)).append("\r\n").append(data, size).append("\r\n");
+}
+
+static inline void null(std::string &out) { out.append("$-1\r\n"); }
+
+// See RespParser.h
+bool RespParser::Parse(const char *input, const std::size_t size, std::size_t &parsed) {
+    parsed = 0;
+    if (parse_complete) {
+        return true;
+    } else if (size == 0) {
+        return false;
+    }
+
+    // Most of the time the whole request is in the input, so it could be used right there
+    if (pending.empty()) {
+        std::size_t used = 0;
+        if (parse(input, size, used)) {
+            parsed = used;
+            parse_complete = true;
+            return true;
+        }
+        pending.assign(input, size);
+        parsed = size;
+        return false;
+    }
+
+    // Large bulk string comes in many pieces, there is no need to parse request again until
+    // all of it is there
+    std::size_t before = pending.size();
+    pending.append(input, size);
+    std::size_t used = 0;
+    if (pending.size() < need || !parse(pending.data(), pending.size(), used)) {
+        parsed = size;
+        return false;
+    }
+
+    // Whatever follows the request is left in the input for the next one
+    pending.resize(used);
+    parsed = used - before;
+    parse_complete = true;
+    return true;
+}
+
+// See RespParser.h
+bool RespParser::parse(const char *data, std::size_t size, std::size_t &used) {
+    args.clear();
+    if (data[0] != '*') {
+        return parse_inline(data, size, used);
+    }
+
+    std::size_t pos = 0;
+    uint64_t count;
+    if (!header(data, size, pos, '*', kMaxArgs, count)) {
+        return false;
+    }
+
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t length;
+        if (!header(data, size, pos, '$', kMaxBulk, length)) {
+            return false;
+        }
+        if (size - pos < length + 2) {
+            need = pos + length + 2;
+            return false;
+        }
+        if (data[pos + length] != '\r' || data[pos + length + 1] != '\n') {
+            throw std::runtime_error("Invalid RESP bulk string termination");
+        }
+        args.emplace_back(data + pos, length);
+        pos += length + 2;
+    }
+
+    used = pos;
+    return true;
+}
+
+// See RespParser.h
+bool RespParser::parse_inline(const char *data, std::size_t size, std::size_t &used) {
+    std::size_t eol = Tokenizer::find(data, size, '\n');
+    if (eol == size) {
+        if (size > kMaxLine) {
+            throw std::runtime_error("RESP inline request is too long");
+        }
+        need = size + 1;
+        return false;
+    }
+
+    // Just like redis bare \n is fine as well
+    std::size_t length = (eol > 0 && data[eol - 1] == '\r') ? eol - 1 : eol;
+    Tokenizer::split(data, length, [this](const char *token, std::size_t token_size) {
+        args.emplace_back(token, token_size);
+        return true;
+    });
+    used = eol + 1;
+    return true;
+}
+
+// See RespParser.h
+bool RespParser::header(const char *data, std::size_t size, std::size_t &pos, char type, uint64_t max,
+                        uint64_t &value) {
+    std::size_t eol = Tokenizer::find(data + pos, size - pos, '\n');
+    if (eol == size - pos) {
+        if (size - pos > kMaxLine) {
+            throw std::runtime_error("RESP header is too long");
+        }
+        need = size + 1;
+        return false;
+    }
+
+    if (eol < 3 || data[pos] != type || data[pos + eol - 1] != '\r' ||
+        !Tokenizer::parse_uint(data + pos + 1, eol - 2, max, value)) {
+        throw std::runtime_error(type == '*' ? "Invalid RESP multibulk length" : "Invalid RESP bulk length");
+    }
+    pos += eol + 1;
+    return true;
+}
+
+// See RespParser.h
+void RespParser::Execute(Storage &storage, std::string &out) {
+    if (!parse_complete) {
+        throw std::runtime_error("There is no parsed RESP request");
+    } else if (args.empty()) {
+        // Empty request is ignored, just as redis does
+        return;
+    }
+
+    // Arity counts command name, negative one means "at least"
+    static const struct {
+        const char *name;
+        int arity;
+        void (RespParser::*run)(Storage &, std::string &);
+    } commands[] = {
+        {"GET", 2, &RespParser::cmd_get},       {"SET", -3, &RespParser::cmd_set},
+        {"DEL", -2, &RespParser::cmd_del},      {"MGET", -2, &RespParser::cmd_mget},
+        {"EXPIRE", 3, &RespParser::cmd_expire}, {"INCR", 2, &RespParser::cmd_incr},
+        {"PING", -1, &RespParser::cmd_ping},    {"QUIT", 1, &RespParser::cmd_quit},
+    };
+
+    for (auto &command : commands) {
+        if (!is(args[0], command.name)) {
+            continue;
+        }
+
+        int argc = static_cast<int>(args.size());
+        if ((command.arity > 0 && argc != command.arity) || (command.arity < 0 && argc < -command.arity)) {
+            return error(out, "ERR wrong number of arguments for '" + args[0].str() + "' command");
+        }
+        return (this->*command.run)(storage, out);
+    }
+    error(out, "ERR unknown command '" + args[0].str() + "'");
+}
+
+// GET key
+void RespParser::cmd_get(Storage &storage, std::string &out) {
+    args[1].assign_to(key);
+    if (!storage.Get(key, value)) {
+        return null(out);
+    }
+    bulk(out, value.data(), value.size());
+}
+
+// SET key value [EX seconds|PX milliseconds] [NX|XX]
+void RespParser::cmd_set(Storage &storage, std::string &out) {
+    int64_t ttl_ms = 0;
+    bool nx = false, xx = false;
+    for (std::size_t i = 3; i < args.size(); i++) {
+        if (is(args[i], "NX") && !xx) {
+            nx = true;
+        } else if (is(args[i], "XX") && !nx) {
+            xx = true;
+        } else if ((is(args[i], "EX") || is(args[i], "PX")) && ttl_ms == 0 && i + 1 < args.size()) {
+            int64_t number;
+            if (!Tokenizer::parse_int(args[i + 1].data, args[i + 1].size, INT32_MAX, number)) {
+                return error(out, "ERR value is not an integer or out of range");
+            } else if (number <= 0) {
+                return error(out, "ERR invalid expire time in 'set' command");
+            }
+            ttl_ms = is(args[i], "EX") ? number * 1000 : number;
+            i++;
+        } else {
+            return error(out, "ERR syntax error");
+        }
+    }
+
+    // Storage counts time in seconds, so TTL is rounded up
+    int64_t deadline = ttl_ms != 0 ? static_cast<int64_t>(std::time(nullptr)) + (ttl_ms + 999) / 1000 : 0;
+    args[1].assign_to(key);
+    args[2].assign_to(value);
+    bool stored;
+    if (nx) {
+        stored = storage.PutIfAbsent(key, value, deadline);
+    } else if (xx) {
+        stored = storage.Set(key, value, deadline);
+    } else if (!storage.Put(key, value, deadline)) {
+        return error(out, "ERR value is too large");
+    } else {
+        stored = true;
+    }
+
+    // Condition of NX/XX isn't met
+    if (!stored) {
+        return null(out);
+    }
+    simple(out, "OK");
+}
+
+// DEL key [key ...]
+void RespParser::cmd_del(Storage &storage, std::string &out) {
+    int64_t deleted = 0;
+    for (std::size_t i = 1; i < args.size(); i++) {
+        args[i].assign_to(key);
+        deleted += storage.Delete(key);
+    }
+    integer(out, deleted);
+}
+
+// MGET key [key ...]
+void RespParser::cmd_mget(Storage &storage, std::string &out) {
+    out.append("*").append(std::to_string(args.size() - 1)).append("\r\n");
+    for (std::size_t i = 1; i < args.size(); i++) {
+        args[i].assign_to(key);
+        if (storage.Get(key, value)) {
+            bulk(out, value.data(), value.size());
+        } else {
+            null(out);
+        }
+    }
+}
+
+// EXPIRE key seconds, key is deleted right away if TTL isn't positive
+void RespParser::cmd_expire(Storage &storage, std::string &out) {
+    int64_t seconds;
+    if (!Tokenizer::parse_int(args[2].data, args[2].size, INT32_MAX, seconds)) {
+        return error(out, "ERR value is not an integer or out of range");
+    }
+
+    args[1].assign_to(key);
+    if (seconds <= 0) {
+        return integer(out, storage.Delete(key));
+    }
+    integer(out, storage.Expire(key, static_cast<int64_t>(std::time(nullptr)) + seconds));
+}
+
+// INCR key, missing key is considered to be 0. Value is changed by storage in one step, so
+// concurrent increments of the same key are never lost
+void RespParser::cmd_incr(Storage &storage, std::string &out) {
+    args[1].assign_to(key);
+
+    int64_t number = 0;
+    const char *failure = nullptr;
+    bool stored = storage.Modify(key, [&number, &failure](std::string &value, bool found) {
+        number = 0;
+        if (found && !Tokenizer::parse_int(value.data(), value.size(), INT64_MAX, number)) {
+            failure = "ERR value is not an integer or out of range";
+            return false;
+        } else if (number == INT64_MAX) {
+            failure = "ERR increment or decrement would overflow";
+            return false;
+        }
+
+        // Value keeps its TTL, just as in redis
+        value = std::to_string(++number);
+        return true;
+    });
+
+    if (!stored) {
+        return error(out, failure != nullptr ? failure : "ERR value is too large");
+    }
+    integer(out, number);
+}
+
+// PING [message]
+void RespParser::cmd_ping(Storage &storage, std::string &out) {
+    if (args.size() > 2) {
+        return error(out, "ERR wrong number of arguments for 'ping' command");
+    } else if (args.size() == 2) {
+        return bulk(out, args[1].data, args[1].size);
+    }
+    simple(out, "PONG");
+}
+
+// QUIT
+void RespParser::cmd_quit(Storage &storage, std::string &out) {
+    quit = true;
+    simple(out, "OK");
+}
+
+// See RespParser.h
+void RespParser::Reset() {
+    args.clear();
+    pending.clear();
+    need = 0;
+    parse_complete = false;
+}
+
+} // namespace Protocol
+} // namespace Afina
@@ -0,0 +1,113 @@
+#ifndef AFINA_PROTOCOL_RESP_PARSER_H
+#define AFINA_PROTOCOL_RESP_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Slice.h"
+
+namespace Afina {
+class Storage;
+
+namespace Protocol {
+
+/**
+ * # Redis protocol (RESP2)
+ * Request is an array of bulk strings:
+ * *<count>\r\n$<length>\r\n<bytes>\r\n...
+ *
+ * Inline commands, i.e space separated words terminated by \r\n, are understood as well, so
+ * that server could be poked with telnet. Supported commands are mapped onto the storage:
+ * GET, SET [EX|PX|NX|XX], DEL, MGET, EXPIRE, INCR, PING and QUIT.
+ *
+ * Just like the other parsers this one doesn't copy arguments out of the input if the whole
+ * request is there, so Execute must be called before the input buffer gets changed. Request
+ * split between several inputs is collected in the parser.
+ */
+class RespParser {
+public:
+    // Max number of arguments in the request
+    static constexpr std::size_t kMaxArgs = 1024 * 1024;
+
+    // Max size of bulk string, larger requests are considered to be garbage
+    static constexpr std::size_t kMaxBulk = 64 * 1024 * 1024;
+
+    // Max length of inline command or header line
+    static constexpr std::size_t kMaxLine = 64 * 1024;
+
+    RespParser() : quit(false) { Reset(); }
+
+    /**
+     * Push given bytes into parser input. Returns true once the whole request is there, see
+     * Parser::Parse. Throws std::runtime_error if input isn't a valid RESP request, stream
+     * can't be resynced after that
+     *
+     * @param input bytes read from the client
+     * @param size number of bytes in the input
+     * @param parsed output parameter tells how many bytes was consumed
+     * @return true if request has been parsed out
+     */
+    bool Parse(const char *input, const std::size_t size, std::size_t &parsed);
+
+    /**
+     * Runs parsed request against the storage and appends encoded reply to the output
+     */
+    void Execute(Storage &storage, std::string &out);
+
+    /**
+     * Reset parser so that it could be used to parse out new request
+     */
+    void Reset();
+
+    /**
+     * True if client asked to close connection, server should do it once reply is sent.
+     * Stays set after Reset
+     */
+    inline bool Quit() const { return quit; }
+
+    /**
+     * Arguments of the parsed request, the first one is command name
+     */
+    inline const std::vector<Slice> &Args() const { return args; }
+
+private:
+    // Parses whole request out of the buffer, returns false if it is incomplete
+    bool parse(const char *data, std::size_t size, std::size_t &used);
+    bool parse_inline(const char *data, std::size_t size, std::size_t &used);
+
+    // Parses "<type><number>\r\n" line at the given position and moves past it
+    bool header(const char *data, std::size_t size, std::size_t &pos, char type, uint64_t max, uint64_t &value);
+
+    // Commands, arity is checked already
+    void cmd_get(Storage &storage, std::string &out);
+    void cmd_set(Storage &storage, std::string &out);
+    void cmd_del(Storage &storage, std::string &out);
+    void cmd_mget(Storage &storage, std::string &out);
+    void cmd_expire(Storage &storage, std::string &out);
+    void cmd_incr(Storage &storage, std::string &out);
+    void cmd_ping(Storage &storage, std::string &out);
+    void cmd_quit(Storage &storage, std::string &out);
+
+    // Arguments of the request, point either to the input or to the buffer below
+    std::vector<Slice> args;
+
+    // Request which was split between several input buffers, memory is reused
+    std::string pending;
+
+    // Pending request can't be complete until it has that many bytes
+    std::size_t need;
+
+    // Storage works with strings, memory of both is reused between requests
+    std::string key;
+    std::string value;
+
+    bool parse_complete;
+    bool quit;
+};
+
+} // namespace Protocol
+} // namespace Afina
+
+#endif // AFINA_PROTOCOL_RESP_PARSER_H
@@ -0,0 +1,380 @@
+#include "Session.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <sys/uio.h>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+#include <afina/metrics/Registry.h>
+
+namespace Afina {
+namespace Protocol {
+
+constexpr std::size_t Session::kChunkSize;
+constexpr std::size_t Session::kMaxIov;
+constexpr std::size_t Session::kMinZeroCopy;
+constexpr std::size_t Session::kSlowKeys;
+constexpr std::size_t Session::kSlowBody;
+
+// Server wide metrics shared by all sessions, registered once
+struct SessionMetrics {
+    SessionMetrics()
+        : curr_connections(Metrics::Registry::Instance().GetGauge("curr_connections")),
+          total_connections(Metrics::Registry::Instance().GetCounter("total_connections")),
+          bytes_read(Metrics::Registry::Instance().GetCounter("bytes_read")),
+          bytes_written(Metrics::Registry::Instance().GetCounter("bytes_written")),
+          cmd_touch(Metrics::Registry::Instance().GetCounter("cmd_touch")),
+          cmd_flush(Metrics::Registry::Instance().GetCounter("cmd_flush")),
+          cmd_deferred(Metrics::Registry::Instance().GetCounter("cmd_deferred")) {}
+
+    std::shared_ptr<Metrics::Gauge> curr_connections;
+    std::shared_ptr<Metrics::Counter> total_connections;
+    std::shared_ptr<Metrics::Counter> bytes_read;
+    std::shared_ptr<Metrics::Counter> bytes_written;
+    std::shared_ptr<Metrics::Counter> cmd_touch;
+    std::shared_ptr<Metrics::Counter> cmd_flush;
+    std::shared_ptr<Metrics::Counter> cmd_deferred;
+};
+
+static SessionMetrics &metrics() {
+    static SessionMetrics instance;
+    return instance;
+}
+
+// See Session.h
+Session::Session(std::shared_ptr<Afina::Storage> storage, Network::ProtocolType protocol, Logging::Trace trace)
+    : _storage(storage), _mode(protocol == Network::ProtocolType::Resp ? Mode::Resp : Mode::Unknown),
+      _trace(std::move(trace)), _command(nullptr), _arg_remains(0), _items(*this), _slow(false), _defer_slow(false),
+      _deferred(false), _out_head(0), _out_tail(0), _out_offset(0), _out_bytes(0), _out_sealed(false) {
+    metrics().curr_connections->inc();
+    metrics().total_connections->inc();
+}
+
+// See Session.h
+Session::~Session() { metrics().curr_connections->dec(); }
+
+// See Session.h
+bool Session::Process(const char *input, std::size_t size) {
+    if (size == 0) {
+        return true;
+    }
+
+    metrics().bytes_read->add(size);
+    if (_deferred) {
+        _backlog.append(input, size);
+        return true;
+    }
+
+    if (_mode == Mode::Unknown) {
+        _mode = static_cast<uint8_t>(input[0]) == BinaryParser::kRequestMagic ? Mode::Binary : Mode::Text;
+    }
+
+    if (_mode == Mode::Binary) {
+        ProcessBinary(input, size);
+        return !_binary.Quit();
+    } else if (_mode == Mode::Resp) {
+        ProcessResp(input, size);
+        return !_resp.Quit();
+    }
+
+    ProcessText(input, size);
+    return true;
+}
+
+// Binary packets carry their own sizes, so there is no need to track arguments
+void Session::ProcessBinary(const char *input, std::size_t size) {
+    while (size > 0) {
+        std::size_t parsed = 0;
+        if (_binary.Parse(input, size, parsed)) {
+            AFINA_TRACE(_trace, DEBUG, "binary opcode 0x{:02x}", _binary.Code());
+            std::size_t tail = _out_tail;
+            bool sealed = _out_sealed;
+            std::string &out = Tail();
+            std::size_t before = out.size();
+            _binary.Execute(*_storage, out);
+            _out_bytes += out.size() - before;
+            if (out.empty()) {
+                // Quiet command has nothing to say, chunk taken for it isn't needed and the
+                // previous one is appended to just as if nothing happened
+                _out_tail = tail;
+                _out_sealed = sealed;
+            }
+            _binary.Reset();
+        }
+        input += parsed;
+        size -= parsed;
+
+        if (_binary.Quit()) {
+            // Whatever follows quit is ignored
+            return;
+        }
+    }
+}
+
+// Just like binary requests, redis ones carry their own sizes
+void Session::ProcessResp(const char *input, std::size_t size) {
+    while (size > 0) {
+        std::size_t parsed = 0;
+        if (_resp.Parse(input, size, parsed)) {
+            AFINA_TRACE(_trace, DEBUG, "{}({})", _resp.Args().empty() ? std::string() : _resp.Args()[0].str(),
+                        _resp.Args().size() > 1 ? _resp.Args()[1].str() : std::string());
+            std::size_t tail = _out_tail;
+            bool sealed = _out_sealed;
+            std::string &out = Tail();
+            std::size_t before = out.size();
+            _resp.Execute(*_storage, out);
+            _out_bytes += out.size() - before;
+            if (out.empty()) {
+                // Empty request has nothing to say, see ProcessBinary
+                _out_tail = tail;
+                _out_sealed = sealed;
+            }
+            _resp.Reset();
+        }
+        input += parsed;
+        size -= parsed;
+
+        if (_resp.Quit()) {
+            // Whatever follows quit is ignored
+            return;
+        }
+    }
+}
+
+// Single block of data readed from the socket could trigger inside actions a multiple times,
+// for example:
+// - read#0: [<command1 start>]
+// - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
+void Session::ProcessText(const char *input, std::size_t size) {
+    while (size > 0) {
+        // There is no command yet
+        if (!_command) {
+            std::size_t parsed = 0;
+            if (_parser.Parse(input, size, parsed)) {
+                // Keys are slices of the input, so command has to be built before it moves on
+                std::size_t body_size = 0;
+                _command = _parser.Build(_slot, body_size);
+                _arg_remains = _parser.HasBody() ? body_size + 2 : 0;
+
+                // Invalid line or command which isn't supported yet, body (if any) would be
+                // answered as another invalid line just as memcached does
+                if (!_command) {
+                    _result.assign(_parser.Error() != nullptr ? _parser.Error() : "ERROR");
+                    Respond();
+                    _parser.Reset();
+                } else {
+                    AFINA_TRACE(_trace, DEBUG, "{}({}) {} bytes", _parser.Name(),
+                                _parser.Keys().empty() ? std::string() : _parser.Keys()[0].str(), body_size);
+                    _slow = _defer_slow && Slow(body_size);
+                }
+            }
+
+            // Parser always takes whole input unless command is complete
+            if (parsed == 0) {
+                break;
+            }
+            input += parsed;
+            size -= parsed;
+        }
+
+        // There is command, but we still wait for argument to arrive...
+        if (_command && _arg_remains > 0) {
+            std::size_t to_read = std::min(_arg_remains, size);
+            _argument.append(input, to_read);
+            input += to_read;
+            size -= to_read;
+            _arg_remains -= to_read;
+        }
+
+        // There is command & argument - RUN! Slow one waits for Resume along with the rest of input
+        if (_command && _arg_remains == 0) {
+            if (_slow) {
+                metrics().cmd_deferred->inc();
+                _deferred = true;
+                _backlog.append(input, size);
+                return;
+            }
+            Run();
+        }
+    }
+}
+
+// See Session.h
+void Session::Run() {
+    if (_parser.Code() == Parser::Op::Touch) {
+        metrics().cmd_touch->inc();
+    } else if (_parser.Code() == Parser::Op::FlushAll) {
+        metrics().cmd_flush->inc();
+    }
+
+    if (!_parser.HasBody()) {
+        _slot.Execute(*_storage, _argument, _result, &_items);
+    } else if (_argument.compare(_argument.size() - 2, 2, "\r\n") == 0) {
+        _argument.resize(_argument.size() - 2);
+        _slot.Execute(*_storage, _argument, _result);
+    } else {
+        _result.assign("CLIENT_ERROR bad data chunk");
+    }
+
+    if (!_parser.NoReply()) {
+        Respond();
+    }
+
+    // Prepare for the next command
+    _command = nullptr;
+    _slow = false;
+    _argument.clear();
+    _parser.Reset();
+}
+
+// See Session.h
+void Session::Resume() {
+    while (_deferred) {
+        _deferred = false;
+        Run();
+
+        // Input is moved aside, another slow command in there puts the rest of it back
+        _resumed.swap(_backlog);
+        _backlog.clear();
+        ProcessText(_resumed.data(), _resumed.size());
+        _resumed.clear();
+    }
+}
+
+// See Session.h
+bool Session::Slow(std::size_t body_size) const {
+    switch (_parser.Code()) {
+    case Parser::Op::Get:
+    case Parser::Op::Gets:
+    case Parser::Op::Gat:
+    case Parser::Op::Gats:
+        return _parser.Keys().size() >= kSlowKeys;
+    case Parser::Op::Scan:
+        return static_cast<const Execute::Scan *>(_command)->count() >= kSlowKeys;
+    default:
+        return _parser.HasBody() && body_size >= kSlowBody;
+    }
+}
+
+// See Session.h
+void Session::Respond() {
+    // Quiet commands might have nothing to say
+    if (_result.empty()) {
+        return;
+    }
+
+    _out_bytes += _result.size() + 2;
+    if (_result.size() < kChunkSize) {
+        Tail().append(_result).append("\r\n");
+    } else {
+        // Large response goes out as is, chunk memory is left to the next result instead
+        Push().swap(_result);
+        Tail().append("\r\n");
+    }
+}
+
+// See Session.h
+void Session::Items::Item(const std::string &header, std::string &value) {
+    _session._out_bytes += header.size() + value.size() + 2;
+    if (value.size() < kMinZeroCopy) {
+        _session.Tail().append(header).append(value).append("\r\n");
+        return;
+    }
+
+    // Value is sent right from the string storage has filled, chunk memory goes to the next value
+    _session.Tail().append(header);
+    _session.Push().swap(value);
+    _session.Tail().append("\r\n");
+}
+
+// See Session.h
+std::string &Session::Tail() {
+    if (_out_tail > _out_head && !_out_sealed && _out[_out_tail - 1].size() < kChunkSize) {
+        return _out[_out_tail - 1];
+    }
+
+    std::string &chunk = Push();
+    _out_sealed = false;
+    return chunk;
+}
+
+// See Session.h
+std::string &Session::Push() {
+    if (_out_tail == _out.size()) {
+        _out.emplace_back();
+    }
+
+    std::string &chunk = _out[_out_tail++];
+    chunk.clear();
+    _out_sealed = true;
+    return chunk;
+}
+
+// See Session.h
+std::size_t Session::Gather(struct iovec *iov, std::size_t max) const {
+    std::size_t n = 0;
+    for (std::size_t i = _out_head; i < _out_tail && n < max; i++, n++) {
+        iov[n].iov_base = const_cast<char *>(_out[i].data());
+        iov[n].iov_len = _out[i].size();
+    }
+
+    if (n > 0) {
+        iov[0].iov_base = static_cast<char *>(iov[0].iov_base) + _out_offset;
+        iov[0].iov_len -= _out_offset;
+    }
+    return n;
+}
+
+// See Session.h
+void Session::Consume(std::size_t written) {
+    metrics().bytes_written->add(written);
+    _out_bytes -= written;
+    while (_out_head < _out_tail) {
+        std::size_t left = _out[_out_head].size() - _out_offset;
+        if (written < left) {
+            _out_offset += written;
+            break;
+        }
+
+        written -= left;
+        _out_offset = 0;
+
+        // Memory of huge responses isn't worth to be kept
+        if (_out[_out_head].capacity() > 4 * kChunkSize) {
+            std::string().swap(_out[_out_head]);
+        }
+        _out_head++;
+    }
+
+    // Everything is sent, chunks could be reused from the beginning
+    if (_out_head == _out_tail) {
+        _out_head = _out_tail = 0;
+    }
+}
+
+// See Session.h
+bool Session::Write(int socket) {
+    struct iovec iov[kMaxIov];
+    while (HasOutput()) {
+        std::size_t n = Gather(iov, kMaxIov);
+        ssize_t written = writev(socket, iov, n);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return false;
+            }
+            throw std::runtime_error("Failed to send response: " + std::string(strerror(errno)));
+        }
+        Consume(written);
+    }
+    return true;
+}
+
+} // namespace Protocol
+} // namespace Afina
@@ -0,0 +1,217 @@
+#ifndef AFINA_PROTOCOL_SESSION_H
+#define AFINA_PROTOCOL_SESSION_H
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/logging/Trace.h>
+#include <afina/network/Server.h>
+
+#include "BinaryParser.h"
+#include "CommandSlot.h"
+#include "Parser.h"
+#include "RespParser.h"
+
+struct iovec;
+
+namespace Afina {
+class Storage;
+
+namespace Protocol {
+
+/**
+ * # Protocol state of the client connection
+ * Network layer pushes whatever it has read from the socket, session parses and runs every
+ * complete command out of it and queues the responses. Once the read batch is processed the
+ * whole queue goes out with a single writev, so pipelined requests cost one syscall per batch
+ * rather than per command.
+ *
+ * Small responses are coalesced into chunks of kChunkSize bytes, large ones keep their own
+ * buffer and are gathered by writev without any copy. Values found by get are handed over the
+ * same way: item line and trailing \r\n go to the chunks, while value of kMinZeroCopy bytes or
+ * more becomes an entry of its own. Chunks are reused once sent, so steady state doesn't
+ * allocate.
+ *
+ * Memcached protocol is chosen by the first byte client sends: binary requests start with the
+ * magic byte, everything else is considered to be text protocol. Listener could speak redis
+ * protocol instead, that is known once session is created.
+ *
+ * Requests are traced at DEBUG level with the given sampled trace, see Logging::Trace.
+ *
+ * Event loop could ask session to stop at the text command which is expected to be slow: large
+ * multiget, scan page or data block of kSlowBody bytes. Such command and everything after it
+ * is left for Resume, which is supposed to be called off the loop thread.
+ *
+ * Session lives as long as the connection does, so it keeps connection and traffic metrics of
+ * the server, see Metrics::Registry.
+ */
+class Session {
+public:
+    // Responses are coalesced into chunks of this size
+    static constexpr std::size_t kChunkSize = 16 * 1024;
+
+    // Max number of chunks passed to one writev call
+    static constexpr std::size_t kMaxIov = 64;
+
+    // Smaller values are cheaper to copy into the chunk than to send as a separate entry
+    static constexpr std::size_t kMinZeroCopy = 2 * 1024;
+
+    // Retrieval of that many keys or scan of that many items is considered to be slow
+    static constexpr std::size_t kSlowKeys = 32;
+
+    // Data block of that size is considered to be slow to store
+    static constexpr std::size_t kSlowBody = 256 * 1024;
+
+    explicit Session(std::shared_ptr<Afina::Storage> storage,
+                     Network::ProtocolType protocol = Network::ProtocolType::Memcached,
+                     Logging::Trace trace = Logging::Trace());
+    ~Session();
+
+    /**
+     * Runs every complete command out of the input and queues responses, see Write. Partial
+     * command stays in the session until the rest of it arrives. Invalid text commands are
+     * answered with an error and skipped. Binary and redis streams can't be resynced, so for
+     * malformed input of those std::runtime_error is thrown and connection should be closed
+     *
+     * @param input bytes read from the client
+     * @param size number of bytes in the input
+     * @return false if client asked to close connection, it should be done once output is sent
+     */
+    bool Process(const char *input, std::size_t size);
+
+    /**
+     * Lets the session stop at a slow command instead of running it, see Deferred
+     */
+    inline void SetDeferSlow(bool defer) { _defer_slow = defer; }
+
+    /**
+     * True if processing has stopped at a slow command. Input passed to Process is kept until
+     * Resume is called, nothing is executed meanwhile
+     */
+    inline bool Deferred() const { return _deferred; }
+
+    /**
+     * Runs deferred command and the input which came after it. Input could have another slow
+     * command, it is executed right away as well
+     */
+    void Resume();
+
+    /**
+     * Sends queued output with writev until everything is sent or socket would block. Returns
+     * true if nothing is left. Throws std::runtime_error if socket is broken
+     */
+    bool Write(int socket);
+
+    // True if there is output waiting to be sent
+    inline bool HasOutput() const { return _out_head < _out_tail; }
+
+    // Number of bytes waiting to be sent
+    inline std::size_t OutputSize() const { return _out_bytes; }
+
+    /**
+     * Fills iov with the output not sent yet, returns number of entries used. Together with
+     * Consume lets the caller send output on its own, Write is built on top of them
+     */
+    std::size_t Gather(struct iovec *iov, std::size_t max) const;
+
+    /**
+     * Makes output queued so far immutable, responses processed afterwards go to new chunks.
+     * Memory passed by Gather stays valid until it is consumed, so it could be sent while
+     * session keeps processing input
+     */
+    inline void Seal() { _out_sealed = true; }
+
+    /**
+     * Drops first written bytes of the output
+     */
+    void Consume(std::size_t written);
+
+private:
+    enum class Mode { Unknown, Text, Binary, Resp };
+
+    // Queues items found by retrieval commands right into the output
+    class Items : public Execute::Get::Output {
+    public:
+        explicit Items(Session &session) : _session(session) {}
+        void Item(const std::string &header, std::string &value) override;
+
+    private:
+        Session &_session;
+    };
+
+    void ProcessText(const char *input, std::size_t size);
+    void ProcessBinary(const char *input, std::size_t size);
+    void ProcessResp(const char *input, std::size_t size);
+
+    // Runs the text command which is complete along with its argument
+    void Run();
+
+    // Estimated cost of the text command just built
+    bool Slow(std::size_t body_size) const;
+
+    // Queues response of the text command out of _result
+    void Respond();
+
+    // Chunk to append the next response to
+    std::string &Tail();
+
+    // Takes unused chunk and puts it into the end of the output, nothing is appended to it
+    // afterwards
+    std::string &Push();
+
+    std::shared_ptr<Afina::Storage> _storage;
+    Mode _mode;
+    Logging::Trace _trace;
+
+    // Text protocol state:
+    // - parser: parse state of the stream
+    // - slot: reusable storage for commands parsed out of stream
+    // - command: last command parsed out of stream, lives in the slot
+    // - arg_remains: how many bytes to read from stream to get command argument, including \r\n
+    // - argument: buffer stores argument
+    // - result: output of the last command
+    // - slow: command should be deferred if session is allowed to
+    Parser _parser;
+    CommandSlot _slot;
+    Execute::Command *_command;
+    std::size_t _arg_remains;
+    std::string _argument;
+    std::string _result;
+    Items _items;
+    bool _slow;
+
+    // Deferred command state:
+    // - defer_slow: session is allowed to stop at slow commands
+    // - deferred: there is a command waiting for Resume
+    // - backlog: input which came after the deferred command
+    // - resumed: backlog taken by Resume, memory of both is reused
+    bool _defer_slow;
+    bool _deferred;
+    std::string _backlog;
+    std::string _resumed;
+
+    // Binary protocol state
+    BinaryParser _binary;
+
+    // Redis protocol state
+    RespParser _resp;
+
+    // Chunks [_out_head, _out_tail) are waiting to be sent, first one is sent up to the
+    // _out_offset. Chunks past the tail are kept to reuse their memory. Last chunk is sealed
+    // if it holds response taken by swap, appending to it would copy the whole response, or
+    // if it is being sent, see Seal. Deque never moves chunks once they are added
+    std::deque<std::string> _out;
+    std::size_t _out_head;
+    std::size_t _out_tail;
+    std::size_t _out_offset;
+    std::size_t _out_bytes;
+    bool _out_sealed;
+};
+
+} // namespace Protocol
+} // namespace Afina
+
+#endif // AFINA_PROTOCOL_SESSION_H
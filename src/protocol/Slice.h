@@ -0,0 +1,38 @@
+#ifndef AFINA_PROTOCOL_SLICE_H
+#define AFINA_PROTOCOL_SLICE_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace Afina {
+namespace Protocol {
+
+/**
+ * # Range of bytes owned by someone else
+ * Parser uses it to point to tokens right in the client input buffer instead of copying
+ * them out, so slice is valid only as long as that buffer is left untouched
+ */
+struct Slice {
+    Slice() : data(nullptr), size(0) {}
+    Slice(const char *d, std::size_t s) : data(d), size(s) {}
+
+    inline bool empty() const { return size == 0; }
+
+    inline std::string str() const { return std::string(data, size); }
+
+    // Copy bytes into existing string, reuses its memory if there is enough
+    inline void assign_to(std::string &out) const { out.assign(data, size); }
+
+    inline bool operator==(const char *other) const {
+        return std::strlen(other) == size && std::memcmp(data, other, size) == 0;
+    }
+
+    const char *data;
+    std::size_t size;
+};
+
+} // namespace Protocol
+} // namespace Afina
+
+#endif // AFINA_PROTOCOL_SLICE_H
@@ -0,0 +1,167 @@
+#ifndef AFINA_PROTOCOL_TOKENIZER_H
+#define AFINA_PROTOCOL_TOKENIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace Afina {
+namespace Protocol {
+
+/**
+ * # Helpers to split command line onto tokens
+ * Input is scanned by blocks of kBlock bytes: each block is compared against the
+ * delimiter at once, giving a bit mask of matches. Tokens are sliced out of the mask with
+ * count-trailing-zeros, so there is no per byte branching for the common case.
+ */
+namespace Tokenizer {
+
+#if defined(__AVX2__)
+constexpr std::size_t kBlock = 32;
+
+// Bit i is set if block[i] == c, block must have kBlock readable bytes
+inline uint32_t match(const char *block, char c) {
+    __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, _mm256_set1_epi8(c))));
+}
+#elif defined(__SSE2__)
+constexpr std::size_t kBlock = 16;
+
+// Bit i is set if block[i] == c, block must have kBlock readable bytes
+inline uint32_t match(const char *block, char c) {
+    __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(data, _mm_set1_epi8(c))));
+}
+#else
+constexpr std::size_t kBlock = 8;
+
+// Bit i is set if block[i] == c, block must have kBlock readable bytes
+inline uint32_t match(const char *block, char c) {
+    uint32_t result = 0;
+    for (std::size_t i = 0; i < kBlock; i++) {
+        result |= uint32_t(block[i] == c) << i;
+    }
+    return result;
+}
+#endif
+
+constexpr uint32_t kBlockMask = kBlock == 32 ? 0xFFFFFFFFu : ((1u << kBlock) - 1);
+
+// Same as match for the tail shorter than kBlock, bits past the size are never set
+inline uint32_t match_tail(const char *tail, std::size_t size, char c) {
+    char block[kBlock];
+    std::memcpy(block, tail, size);
+    std::memset(block + size, c ^ 1, kBlock - size);
+    return match(block, c);
+}
+
+/**
+ * Returns position of the first c in the data, or size if there is none
+ */
+inline std::size_t find(const char *data, std::size_t size, char c) {
+    std::size_t base = 0;
+    for (; base + kBlock <= size; base += kBlock) {
+        uint32_t mask = match(data + base, c);
+        if (mask != 0) {
+            return base + __builtin_ctz(mask);
+        }
+    }
+
+    if (base < size) {
+        uint32_t mask = match_tail(data + base, size - base, c);
+        if (mask != 0) {
+            return base + __builtin_ctz(mask);
+        }
+    }
+    return size;
+}
+
+/**
+ * Calls func(const char *token, std::size_t size) for each space separated token of the
+ * line. Any number of spaces between tokens is allowed. Stops and returns false once func
+ * returns false
+ */
+template <typename F> bool split(const char *line, std::size_t size, F func) {
+    // Start of the token being sliced out, size if there is none
+    std::size_t start = size;
+    for (std::size_t base = 0; base < size; base += kBlock) {
+        // Bytes past the line end are treated as spaces so that the last token gets closed
+        uint32_t spaces;
+        if (base + kBlock <= size) {
+            spaces = match(line + base, ' ');
+        } else {
+            spaces = match_tail(line + base, size - base, ' ') | (kBlockMask & ~((1u << (size - base)) - 1));
+        }
+
+        // Looking for the token start outside of token and for its end inside
+        uint64_t boundaries = start == size ? (~spaces & kBlockMask) : spaces;
+        while (boundaries != 0) {
+            std::size_t bit = __builtin_ctzll(boundaries);
+            if (start == size) {
+                start = base + bit;
+                boundaries = spaces & (~uint64_t(0) << bit);
+            } else {
+                if (!func(line + start, base + bit - start)) {
+                    return false;
+                }
+                start = size;
+                boundaries = ~spaces & kBlockMask & (~uint64_t(0) << bit);
+            }
+        }
+    }
+
+    // Line ends right at the block boundary
+    if (start != size) {
+        return func(line + start, size - start);
+    }
+    return true;
+}
+
+/**
+ * Parses unsigned decimal that fits into max. Returns false if token has anything but
+ * digits or value is too large
+ */
+inline bool parse_uint(const char *token, std::size_t size, uint64_t max, uint64_t &value) {
+    // 19 digits always fit into uint64_t, so overflow is only checked once in the end
+    if (size == 0 || size > 19) {
+        return false;
+    }
+
+    uint64_t result = 0;
+    for (std::size_t i = 0; i < size; i++) {
+        uint8_t digit = static_cast<uint8_t>(token[i] - '0');
+        if (digit > 9) {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+
+    if (result > max) {
+        return false;
+    }
+    value = result;
+    return true;
+}
+
+/**
+ * Parses signed decimal in range [-max, max], see parse_uint
+ */
+inline bool parse_int(const char *token, std::size_t size, int64_t max, int64_t &value) {
+    bool negative = size > 0 && token[0] == '-';
+    uint64_t result;
+    if (!parse_uint(token + negative, size - negative, static_cast<uint64_t>(max), result)) {
+        return false;
+    }
+    value = negative ? -static_cast<int64_t>(result) : static_cast<int64_t>(result);
+    return true;
+}
+
+} // namespace Tokenizer
+} // namespace Protocol
+} // namespace Afina
+
+#endif // AFINA_PROTOCOL_TOKENIZER_H
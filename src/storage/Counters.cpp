@@ -0,0 +1,34 @@
+#include "Counters.h"
+
+namespace Afina {
+namespace Backend {
+
+// See Counters.h
+void StorageStats::Append(std::vector<std::pair<std::string, std::string>> &stats) const {
+    stats.emplace_back("cmd_get", std::to_string(cmd_get));
+    stats.emplace_back("cmd_set", std::to_string(cmd_set));
+    stats.emplace_back("get_hits", std::to_string(get_hits));
+    stats.emplace_back("get_misses", std::to_string(get_misses));
+    stats.emplace_back("evictions", std::to_string(evictions));
+    stats.emplace_back("expirations", std::to_string(expirations));
+    stats.emplace_back("curr_items", std::to_string(curr_items));
+    stats.emplace_back("total_items", std::to_string(total_items));
+    stats.emplace_back("bytes", std::to_string(bytes));
+    stats.emplace_back("limit_maxbytes", std::to_string(limit_maxbytes));
+}
+
+// See Counters.h
+void StorageCounters::Collect(StorageStats &stats) const {
+    stats.cmd_get += cmd_get.get();
+    stats.get_hits += get_hits.get();
+    stats.get_misses += get_misses.get();
+    stats.cmd_set += cmd_set.get();
+    stats.evictions += evictions.get();
+    stats.expirations += expirations.get();
+    stats.curr_items += curr_items.get();
+    stats.total_items += total_items.get();
+    stats.bytes += bytes.get();
+}
+
+} // namespace Backend
+} // namespace Afina
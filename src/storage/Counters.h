@@ -0,0 +1,86 @@
+#ifndef AFINA_STORAGE_COUNTERS_H
+#define AFINA_STORAGE_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Statistics counter with a single writer
+ * Only the thread which owns the cache (or holds its lock) changes counter, so increment
+ * is a plain load and store without lock prefix. Any other thread could read it at any
+ * moment to aggregate statistics.
+ */
+class Counter {
+public:
+    Counter() : _value(0) {}
+    Counter(const Counter &other) : _value(other.get()) {}
+
+    inline void add(int64_t delta) {
+        _value.store(_value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+    inline void inc() { add(1); }
+    inline void set(uint64_t value) { _value.store(value, std::memory_order_relaxed); }
+    inline uint64_t get() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> _value;
+};
+
+/**
+ * # Aggregated storage statistics
+ * Plain snapshot of counters, names follow memcached "stats" command
+ */
+struct StorageStats {
+    uint64_t cmd_get = 0;
+    uint64_t get_hits = 0;
+    uint64_t get_misses = 0;
+    uint64_t cmd_set = 0;
+    uint64_t evictions = 0;
+    uint64_t expirations = 0;
+    uint64_t curr_items = 0;
+    uint64_t total_items = 0;
+    uint64_t bytes = 0;
+    uint64_t limit_maxbytes = 0;
+
+    /**
+     * Append statistics as name/value pairs, see Afina::Storage::Stats
+     */
+    void Append(std::vector<std::pair<std::string, std::string>> &stats) const;
+};
+
+/**
+ * # Counters of a single cache
+ * Padded from both sides so that counters of one stripe never share cache line with data
+ * changed by threads working on other stripes.
+ */
+struct StorageCounters {
+    char _head_padding[64];
+
+    Counter cmd_get;
+    Counter get_hits;
+    Counter get_misses;
+    Counter cmd_set;
+    Counter evictions;
+    Counter expirations;
+    Counter curr_items;
+    Counter total_items;
+    Counter bytes;
+
+    char _tail_padding[64];
+
+    /**
+     * Adds counters to the given snapshot
+     */
+    void Collect(StorageStats &stats) const;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_COUNTERS_H
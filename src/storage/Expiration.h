@@ -0,0 +1,67 @@
+#ifndef AFINA_STORAGE_EXPIRATION_H
+#define AFINA_STORAGE_EXPIRATION_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * Current unix time in seconds, deadlines of entries are compared against it. Expired entries
+ * aren't looked for, they are dropped once somebody touches them or get evicted as usual
+ */
+inline int64_t unix_now() { return static_cast<int64_t>(std::time(nullptr)); }
+
+// True if entry with the given deadline is expired at the moment, 0 means never
+inline bool is_expired(int64_t deadline, int64_t now) { return deadline != 0 && deadline <= now; }
+
+/**
+ * # Generation of the cache contents
+ * Each entry is stamped with the generation it was written in, flush just starts the new one.
+ * Entries of older generations are considered to be gone: they are dropped once somebody looks
+ * them up or reclaimed by eviction, so flush takes the same time no matter how large cache is.
+ *
+ * Delayed flush is kept aside and applied by the first lookup after its time comes. Clock could
+ * be shared by several caches (stripes, tiers) to flush all of them at once, so it is thread safe.
+ */
+class FlushClock {
+public:
+    FlushClock() : _generation(1), _flush_at(0) {}
+
+    // Generation entries written at the moment belong to
+    inline uint32_t generation() {
+        int64_t at = _flush_at.load(std::memory_order_acquire);
+        if (at != 0 && at <= unix_now() && _flush_at.compare_exchange_strong(at, 0)) {
+            // Only one of the racing threads gets there
+            _generation.fetch_add(1, std::memory_order_acq_rel);
+        }
+        return _generation.load(std::memory_order_acquire);
+    }
+
+    // True if entry of the given generation is still there
+    inline bool is_live(uint32_t generation) { return generation == this->generation(); }
+
+    /**
+     * Drops all entries existing at the given unix time, 0 means right now. Pending delayed flush
+     * is replaced by the new one
+     */
+    inline void flush(int64_t at) {
+        if (at != 0 && at > unix_now()) {
+            _flush_at.store(at, std::memory_order_release);
+            return;
+        }
+        _flush_at.store(0, std::memory_order_release);
+        _generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+private:
+    std::atomic<uint32_t> _generation;
+    std::atomic<int64_t> _flush_at;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EXPIRATION_H
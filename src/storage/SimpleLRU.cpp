@@ -1,8 +1,12 @@
 #include "SimpleLRU.h"
 
+#include <cassert>
+
 namespace Afina {
 namespace Backend {
 
+constexpr std::size_t SimpleLRU::kScanVisits;
+
 std::size_t SimpleLRU::get_size () {
     return _size;
 }
@@ -14,11 +18,11 @@ bool SimpleLRU::is_overflow(const std::string &key, const std::string &value) {
     return false;
 }
 
-void SimpleLRU::add_key_value(const std::string &key, const std::string &value) {
+void SimpleLRU::add_key_value(const std::string &key, const std::string &value, int64_t deadline) {
     while (_size + key.size() + value.size() > _max_size) {
         erase_last();
     }
-    auto *node = new lru_node{key, value, nullptr, nullptr};
+    auto *node = new lru_node{key, value, deadline, _clock->generation(), nullptr, nullptr};
     if (_lru_head) {
         _lru_head->prev = node;
     } else {
@@ -28,17 +32,33 @@ void SimpleLRU::add_key_value(const std::string &key, const std::string &value)
     _lru_head.reset(node);
     _lru_index.insert({std::reference_wrapper<const std::string>(node->key), std::reference_wrapper<lru_node>(*node)});
     _size += key.size() + value.size();
+
+    _counters.curr_items.inc();
+    _counters.total_items.inc();
+    _counters.bytes.set(_size);
 }
 
 
 void SimpleLRU::erase_last() {
+    // Flushed entries are just reclaimed, they are gone already
+    bool live = _clock->is_live(_lru_tail->generation);
+    if (live && _on_evict) {
+        _on_evict(_lru_tail->key, _lru_tail->value, _lru_tail->deadline);
+    }
     _size -= _lru_tail->key.size() + _lru_tail->value.size();
     _lru_index.erase(_lru_tail->key);
+
+    if (live) {
+        _counters.evictions.inc();
+    }
+    _counters.curr_items.add(-1);
+    _counters.bytes.set(_size);
     if (_lru_head.get() != _lru_tail) {
         _lru_tail = _lru_tail->prev;
         _lru_tail->next.reset(nullptr);
     } else {
         _lru_head.reset(nullptr);
+        _lru_tail = nullptr;
     }
 }
 
@@ -63,7 +83,7 @@ void SimpleLRU::update_the_position(lru_node &node) {
     }
 }
 
-void SimpleLRU::set_existed(lru_node &node, const std::string &value) {
+void SimpleLRU::set_existed(lru_node &node, const std::string &value, int64_t deadline) {
     update_the_position(node);
     if (value.size() > node.value.size()) {
         while (_size + value.size() - node.value.size() > _max_size) {
@@ -72,54 +92,123 @@ void SimpleLRU::set_existed(lru_node &node, const std::string &value) {
     }
     _size += value.size() - node.value.size();
     node.value = value;
+    node.deadline = deadline;
+    node.generation = _clock->generation();
+
+    _counters.total_items.inc();
+    _counters.bytes.set(_size);
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Put(const std::string &key, const std::string &value) {
+bool SimpleLRU::Put(const std::string &key, const std::string &value, int64_t deadline) {
+    _counters.cmd_set.inc();
     if (is_overflow(key, value)) {
         return false;
     }
     auto node = _lru_index.find(key);
     if (node != _lru_index.end()) {
-        set_existed((node->second).get(), value);
+        set_existed((node->second).get(), value, deadline);
     } else {
-        add_key_value(key, value);
+        add_key_value(key, value, deadline);
     }
     return true;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value, int64_t deadline) {
+    _counters.cmd_set.inc();
     if (is_overflow(key, value)) {
         return false;
     }
-    if (_lru_index.find(key) == _lru_index.end()) {
-        add_key_value(key, value);
+    if (find(key) == nullptr) {
+        add_key_value(key, value, deadline);
         return true;
     }
     return false;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Set(const std::string &key, const std::string &value) {
+bool SimpleLRU::Set(const std::string &key, const std::string &value, int64_t deadline) {
+    _counters.cmd_set.inc();
     if (is_overflow(key, value)) {
         return false;
     }
-    auto node = _lru_index.find(key);
-    if (node != _lru_index.end()) {
-        set_existed((node->second).get(), value);
+    lru_node *node = find(key);
+    if (node != nullptr) {
+        set_existed(*node, value, deadline);
         return true;
     }
     return false;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Delete(const std::string &key) {
-    if (_lru_index.find(key) == _lru_index.end()) {
+bool SimpleLRU::Append(const std::string &key, const std::string &value) { return concat(key, value, false); }
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Prepend(const std::string &key, const std::string &value) { return concat(key, value, true); }
+
+// Joins value with the existing one, entry keeps its expiration time
+bool SimpleLRU::concat(const std::string &key, const std::string &value, bool front) {
+    _counters.cmd_set.inc();
+    lru_node *node = find(key);
+    if (node == nullptr) {
+        return false;
+    }
+
+    std::string joined = front ? value + node->value : node->value + value;
+    if (is_overflow(key, joined)) {
+        return false;
+    }
+    set_existed(*node, joined, node->deadline);
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Modify(const std::string &key, const std::function<bool(std::string &value, bool found)> &update) {
+    _counters.cmd_set.inc();
+    lru_node *node = find(key);
+    std::string value;
+    if (node != nullptr) {
+        value = node->value;
+    }
+
+    if (!update(value, node != nullptr) || is_overflow(key, value)) {
         return false;
     }
-    lru_node *node_ptr = &(_lru_index.find(key)->second.get());
-    _lru_index.erase(_lru_index.find(key));
+    if (node != nullptr) {
+        set_existed(*node, value, node->deadline);
+    } else {
+        add_key_value(key, value, 0);
+    }
+    return true;
+}
+
+// Looks for the live entry, expired or flushed one is dropped on the way
+SimpleLRU::lru_node *SimpleLRU::find(const std::string &key) {
+    auto it = _lru_index.find(key);
+    if (it == _lru_index.end()) {
+        return nullptr;
+    }
+
+    lru_node &node = it->second.get();
+    if (!_clock->is_live(node.generation)) {
+        remove(node);
+        return nullptr;
+    } else if (node.deadline != 0 && is_expired(node.deadline, unix_now())) {
+        remove(node);
+        _counters.expirations.inc();
+        return nullptr;
+    }
+    return &node;
+}
+
+// Unlinks entry from the list and index and frees it
+void SimpleLRU::remove(lru_node &node) {
+    lru_node *node_ptr = &node;
+    _lru_index.erase(node_ptr->key);
+    _size -= node_ptr->key.size() + node_ptr->value.size();
+    _counters.curr_items.add(-1);
+    _counters.bytes.set(_size);
 
     if (node_ptr != _lru_head.get()) {
         if (node_ptr->next) {
@@ -138,20 +227,116 @@ bool SimpleLRU::Delete(const std::string &key) {
             _lru_tail = nullptr;
         }
     }
-    _size -= node_ptr->key.size() + node_ptr->value.size();
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Delete(const std::string &key) {
+    lru_node *node = find(key);
+    if (node == nullptr) {
+        return false;
+    }
+    remove(*node);
     return true;
 }
 
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::Get(const std::string &key, std::string &value) {
-    auto node = _lru_index.find(key);
-    if (node == _lru_index.end()) {
+    int64_t deadline;
+    return Get(key, value, deadline);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Get(const std::string &key, std::string &value, int64_t &deadline) {
+    _counters.cmd_get.inc();
+    lru_node *node = find(key);
+    if (node == nullptr) {
+        _counters.get_misses.inc();
         return false;
     }
-    update_the_position(node->second.get());
+    _counters.get_hits.inc();
+    update_the_position(*node);
     value = _lru_head->value;
+    deadline = _lru_head->deadline;
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Expire(const std::string &key, int64_t deadline) {
+    lru_node *node = find(key);
+    if (node == nullptr) {
+        return false;
+    }
+    node->deadline = deadline;
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::GetExpire(const std::string &key, int64_t &deadline) {
+    lru_node *node = find(key);
+    if (node == nullptr) {
+        return false;
+    }
+    deadline = node->deadline;
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+void SimpleLRU::Flush(int64_t at) {
+    // Nothing is freed here, see FlushClock
+    _clock->flush(at);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Scan(std::string &cursor, std::size_t count, std::vector<std::string> &keys) {
+    // Index is ordered by key, so cursor is just the last returned key. It stays valid no matter
+    // how many keys were inserted or evicted since previous call. Prefix keeps empty key apart
+    // from the empty cursor
+    assert(count > 0);
+    auto it = _lru_index.begin();
+    if (!cursor.empty()) {
+        if (cursor[0] != '>') {
+            return false;
+        }
+        std::string last = cursor.substr(1);
+        it = _lru_index.upper_bound(std::cref(last));
+    }
+
+    // Entries which are gone already are skipped, but not dropped: that would break iterator.
+    // Page could end up empty if there are too many of them, cursor moves forward anyway
+    int64_t now = unix_now();
+    uint32_t generation = _clock->generation();
+    std::size_t found = 0;
+    std::size_t visits = kScanVisits * count;
+    auto last = _lru_index.end();
+    for (; it != _lru_index.end() && found < count && visits > 0; ++it, visits--) {
+        const lru_node &node = it->second.get();
+        if (node.generation == generation && !is_expired(node.deadline, now)) {
+            keys.push_back(it->first.get());
+            found++;
+        }
+        last = it;
+    }
+
+    if (it == _lru_index.end()) {
+        cursor.clear();
+    } else {
+        cursor = ">" + last->first.get();
+    }
     return true;
 }
 
+// See MapBasedGlobalLockImpl.h
+void SimpleLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    StorageStats total;
+    Collect(total);
+    total.Append(stats);
+}
+
+// See MapBasedGlobalLockImpl.h
+void SimpleLRU::Collect(StorageStats &stats) const {
+    _counters.Collect(stats);
+    stats.limit_maxbytes += _max_size;
+}
+
 } // namespace Backend
 } // namespace Afina
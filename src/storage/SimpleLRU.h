@@ -1,13 +1,18 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <afina/Storage.h>
 
+#include "Counters.h"
+#include "Expiration.h"
+
 namespace Afina {
 namespace Backend {
 
@@ -17,7 +22,13 @@ namespace Backend {
  */
 class SimpleLRU : public Afina::Storage {
 public:
-    SimpleLRU(size_t max_size = 1024) : _max_size(max_size), _size(0), _lru_index(), _lru_head(), _lru_tail(nullptr) {}
+    // Scan visits at most that many entries per requested key, so that a lot of expired or
+    // flushed ones doesn't hold the cache for long
+    static constexpr std::size_t kScanVisits = 4;
+
+    SimpleLRU(size_t max_size = 1024)
+        : _max_size(max_size), _size(0), _lru_index(), _lru_head(), _lru_tail(nullptr),
+          _clock(std::make_shared<FlushClock>()) {}
 
 
     ~SimpleLRU() {
@@ -33,15 +44,35 @@ public:
 
     std::size_t get_size ();
 
+    // Function to be called for each entry evicted to free space for the new ones. It is not
+    // called for explicitly deleted, overwritten or expired entries and must not access the cache
+    using eviction_func =
+        std::function<void(const std::string &key, const std::string &value, int64_t deadline)>;
+
+    void set_eviction_callback(eviction_func on_evict) { _on_evict = std::move(on_evict); }
+
+    // Makes cache to be flushed together with others sharing the same clock, must be set
+    // before anything is stored
+    void set_flush_clock(std::shared_ptr<FlushClock> clock) { _clock = std::move(clock); }
+
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, int64_t deadline = 0) override;
 
     // Implements Afina::Storage interface
-    bool Put(const std::string &key, const std::string &value) override;
+    bool PutIfAbsent(const std::string &key, const std::string &value, int64_t deadline = 0) override;
 
     // Implements Afina::Storage interface
-    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+    bool Set(const std::string &key, const std::string &value, int64_t deadline = 0) override;
 
     // Implements Afina::Storage interface
-    bool Set(const std::string &key, const std::string &value) override;
+    bool Append(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Modify(const std::string &key, const std::function<bool(std::string &value, bool found)> &update) override;
 
     // Implements Afina::Storage interface
     bool Delete(const std::string &key) override;
@@ -49,19 +80,50 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
+    // Implements Afina::Storage interface
+    bool Expire(const std::string &key, int64_t deadline) override;
+
+    // Implements Afina::Storage interface
+    bool GetExpire(const std::string &key, int64_t &deadline) override;
+
+    // Implements Afina::Storage interface
+    void Flush(int64_t at) override;
+
+    // Same as Get, but expiration time of the entry is returned as well
+    bool Get(const std::string &key, std::string &value, int64_t &deadline);
+
+    // Implements Afina::Storage interface
+    bool Scan(std::string &cursor, std::size_t count, std::vector<std::string> &keys) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+    // Adds counters of this cache to the given snapshot, safe to call from any thread
+    void Collect(StorageStats &stats) const;
+
 private:
     // LRU cache node
     using lru_node = struct lru_node {
         std::string key;
         std::string value;
+
+        // Unix time entry expires at, 0 if never
+        int64_t deadline;
+
+        // Flush generation entry was written in, see FlushClock
+        uint32_t generation;
+
 //        std::unique_ptr<lru_node> prev;
         lru_node* prev;
         std::unique_ptr<lru_node> next;
     };
 
-    void add_key_value(const std::string &key, const std::string &value);
+    lru_node *find(const std::string &key);
+    void remove(lru_node &node);
+    void add_key_value(const std::string &key, const std::string &value, int64_t deadline);
     void erase_last();
-    void set_existed(lru_node &node, const std::string &value);
+    void set_existed(lru_node &node, const std::string &value, int64_t deadline);
+    bool concat(const std::string &key, const std::string &value, bool front);
     void update_the_position(lru_node &node);
     bool is_overflow(const std::string &key, const std::string &value);
 
@@ -83,6 +145,15 @@ private:
     // Index of nodes from list above, allows fast random access to elements by lru_node#key
     std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>, std::less<std::string>> _lru_index;
 
+    // Optional observer of evicted entries
+    eviction_func _on_evict;
+
+    // Entries written before the last flush are still here until somebody runs into them
+    std::shared_ptr<FlushClock> _clock;
+
+    // Statistics, changed only by the thread owning the cache
+    StorageCounters _counters;
+
 };
 
 } // namespace Backend
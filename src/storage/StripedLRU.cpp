@@ -1,41 +1,293 @@
 #include "StripedLRU.h"
 
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+
 namespace Afina {
 namespace Backend {
 
+constexpr std::size_t StripedLRU::kHotKeys;
+constexpr uint32_t StripedLRU::kSampleRate;
+constexpr uint32_t StripedLRU::kHotRefresh;
+constexpr uint32_t StripedLRU::kHotShare;
+
 StripedLRU::StripedLRU(std::size_t memory_limit,
                        std::size_t stripe_count) :
                                                     _capacity(memory_limit / stripe_count),
                                                    _stripe_count(stripe_count),
-                                                    _mutex(stripe_count) {
+                                                    _mutex(stripe_count),
+                                                    _version(stripe_count),
+                                                    _clock(std::make_shared<FlushClock>()) {
     for (std::size_t i = 0 ; i < _stripe_count; i++) {
         _shard.emplace_back(SimpleLRU(_capacity));
+        _shard.back().set_flush_clock(_clock);
+    }
+}
+
+bool StripedLRU::Put(const std::string &key, const std::string &value, int64_t deadline) {
+    std::size_t stripe = hash(key) % _stripe_count;
+    std::lock_guard<std::mutex> _lock(_mutex[stripe]);
+    bool result = _shard[stripe].Put(key, value, deadline);
+    if (result) {
+        _version[stripe].value.fetch_add(1, std::memory_order_release);
+    }
+    return result;
+}
+
+bool StripedLRU::PutIfAbsent(const std::string &key, const std::string &value, int64_t deadline) {
+    std::size_t stripe = hash(key) % _stripe_count;
+    std::lock_guard<std::mutex> _lock(_mutex[stripe]);
+    bool result = _shard[stripe].PutIfAbsent(key, value, deadline);
+    if (result) {
+        _version[stripe].value.fetch_add(1, std::memory_order_release);
     }
+    return result;
 }
 
-bool StripedLRU::Put(const std::string &key, const std::string &value) {
-    std::lock_guard<std::mutex> _lock(_mutex[hash(key) % _stripe_count]);
-    return _shard[hash(key) % _stripe_count].Put(key, value);
+bool StripedLRU::Set(const std::string &key, const std::string &value, int64_t deadline) {
+    std::size_t stripe = hash(key) % _stripe_count;
+    std::lock_guard<std::mutex> _lock(_mutex[stripe]);
+    bool result = _shard[stripe].Set(key, value, deadline);
+    if (result) {
+        _version[stripe].value.fetch_add(1, std::memory_order_release);
+    }
+    return result;
+}
+
+bool StripedLRU::Append(const std::string &key, const std::string &value) {
+    std::size_t stripe = hash(key) % _stripe_count;
+    std::lock_guard<std::mutex> _lock(_mutex[stripe]);
+    bool result = _shard[stripe].Append(key, value);
+    if (result) {
+        _version[stripe].value.fetch_add(1, std::memory_order_release);
+    }
+    return result;
 }
 
-bool StripedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
-    std::lock_guard<std::mutex> _lock(_mutex[hash(key) % _stripe_count]);
-    return _shard[hash(key) % _stripe_count].PutIfAbsent(key, value);
+bool StripedLRU::Prepend(const std::string &key, const std::string &value) {
+    std::size_t stripe = hash(key) % _stripe_count;
+    std::lock_guard<std::mutex> _lock(_mutex[stripe]);
+    bool result = _shard[stripe].Prepend(key, value);
+    if (result) {
+        _version[stripe].value.fetch_add(1, std::memory_order_release);
+    }
+    return result;
 }
 
-bool StripedLRU::Set(const std::string &key, const std::string &value) {
-    std::lock_guard<std::mutex> _lock(_mutex[hash(key) % _stripe_count]);
-    return _shard[hash(key) % _stripe_count].Set(key, value);
+bool StripedLRU::Modify(const std::string &key, const std::function<bool(std::string &value, bool found)> &update) {
+    std::size_t stripe = hash(key) % _stripe_count;
+    std::lock_guard<std::mutex> _lock(_mutex[stripe]);
+    bool result = _shard[stripe].Modify(key, update);
+    if (result) {
+        _version[stripe].value.fetch_add(1, std::memory_order_release);
+    }
+    return result;
 }
 
 bool StripedLRU::Delete(const std::string &key) {
-    std::lock_guard<std::mutex> _lock(_mutex[hash(key) % _stripe_count]);
-    return _shard[hash(key) % _stripe_count].Delete(key);
+    std::size_t stripe = hash(key) % _stripe_count;
+    std::lock_guard<std::mutex> _lock(_mutex[stripe]);
+    bool result = _shard[stripe].Delete(key);
+    if (result) {
+        _version[stripe].value.fetch_add(1, std::memory_order_release);
+    }
+    return result;
 }
 
 bool StripedLRU::Get(const std::string &key, std::string &value) {
-    std::lock_guard<std::mutex> _lock(_mutex[hash(key) % _stripe_count]);
-    return _shard[hash(key) % _stripe_count].Get(key, value);
+    std::size_t stripe = hash(key) % _stripe_count;
+    replica &r = _replicas.get();
+
+    // Hot set has changed, replicated entries might be not hot anymore
+    uint64_t generation = _hot_generation.load(std::memory_order_acquire);
+    if (r.generation != generation) {
+        std::lock_guard<std::mutex> _lock(_hot_mutex);
+        r.hot = _hot;
+        r.entries.clear();
+        r.generation = _hot_generation.load(std::memory_order_relaxed);
+    }
+
+    // Replica is valid until there were no writes into the stripe since it was made. Note
+    // that replica hits doesn't move key in the LRU, so a hot key could be still evicted,
+    // eviction is a write and so invalidates replica
+    if (!r.entries.empty()) {
+        auto it = r.entries.find(key);
+        if (it != r.entries.end() &&
+            it->second.version == _version[stripe].value.load(std::memory_order_acquire) &&
+            (it->second.deadline == 0 || !is_expired(it->second.deadline, unix_now())) &&
+            _clock->is_live(it->second.generation)) {
+            value = it->second.value;
+            r.hits.store(r.hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            sample(r, key);
+            return true;
+        }
+    }
+
+    // Generation is taken before the lookup, so that replica made right before flush is
+    // considered to be stale
+    bool result;
+    uint64_t version;
+    int64_t deadline = 0;
+    uint32_t flush_generation = _clock->generation();
+    {
+        std::lock_guard<std::mutex> _lock(_mutex[stripe]);
+        result = _shard[stripe].Get(key, value, deadline);
+        version = _version[stripe].value.load(std::memory_order_relaxed);
+    }
+
+    if (result && !r.hot.empty() && r.hot.count(key) > 0) {
+        replica_entry &entry = r.entries[key];
+        entry.value = value;
+        entry.version = version;
+        entry.deadline = deadline;
+        entry.generation = flush_generation;
+    }
+    sample(r, key);
+    return result;
+}
+
+bool StripedLRU::Expire(const std::string &key, int64_t deadline) {
+    std::size_t stripe = hash(key) % _stripe_count;
+    std::lock_guard<std::mutex> _lock(_mutex[stripe]);
+    bool result = _shard[stripe].Expire(key, deadline);
+    if (result) {
+        _version[stripe].value.fetch_add(1, std::memory_order_release);
+    }
+    return result;
+}
+
+bool StripedLRU::GetExpire(const std::string &key, int64_t &deadline) {
+    std::size_t stripe = hash(key) % _stripe_count;
+    std::lock_guard<std::mutex> _lock(_mutex[stripe]);
+    return _shard[stripe].GetExpire(key, deadline);
+}
+
+void StripedLRU::Flush(int64_t at) { _clock->flush(at); }
+
+void StripedLRU::sample(replica &r, const std::string &key) {
+    r.seed ^= r.seed << 13;
+    r.seed ^= r.seed >> 17;
+    r.seed ^= r.seed << 5;
+    if ((r.seed & (kSampleRate - 1)) != 0) {
+        return;
+    }
+
+    // Sketch is shared by all threads, never wait for it on the read path - it is fine
+    // to lose some samples
+    std::unique_lock<std::mutex> _lock(_hot_mutex, std::try_to_lock);
+    if (!_lock.owns_lock()) {
+        return;
+    }
+
+    _top.Add(key);
+    if (++_samples >= kHotRefresh) {
+        _samples = 0;
+        refresh_hot_keys();
+    }
+}
+
+// Must be called under _hot_mutex
+void StripedLRU::refresh_hot_keys() {
+    std::unordered_set<std::string> hot;
+    for (auto &top : _top.Top(kHotKeys)) {
+        if (top.second * kHotShare >= _top.total()) {
+            hot.insert(top.first);
+        }
+    }
+
+    if (hot != _hot) {
+        _hot.swap(hot);
+        _hot_generation.fetch_add(1, std::memory_order_release);
+    }
+}
+
+// Parses stripe index of the scan cursor, only plain decimal digits up to max are accepted
+static bool parse_stripe(const std::string &text, uint64_t max, uint64_t &stripe) {
+    if (text.empty() || text.size() > 20 || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+
+    char *end = nullptr;
+    errno = 0;
+    unsigned long long number = std::strtoull(text.c_str(), &end, 10);
+    if (errno == ERANGE || *end != '\0' || number > max) {
+        return false;
+    }
+    stripe = number;
+    return true;
+}
+
+bool StripedLRU::Scan(std::string &cursor, std::size_t count, std::vector<std::string> &keys) {
+    // Cursor is "<stripe>:<stripe cursor>", stripes are walked one by one so that only one
+    // of them is locked at a time
+    assert(count > 0);
+    uint64_t stripe = 0;
+    std::string inner;
+    if (!cursor.empty()) {
+        std::size_t sep = cursor.find(':');
+        if (sep == std::string::npos || !parse_stripe(cursor.substr(0, sep), _stripe_count - 1, stripe)) {
+            return false;
+        }
+        inner = cursor.substr(sep + 1);
+    }
+
+    std::size_t start = keys.size();
+    while (stripe < _stripe_count && keys.size() - start < count) {
+        {
+            std::lock_guard<std::mutex> _lock(_mutex[stripe]);
+            if (!_shard[stripe].Scan(inner, count - (keys.size() - start), keys)) {
+                return false;
+            }
+        }
+
+        // Stripe has stopped short of its end, either page is full or it has visited enough
+        if (!inner.empty()) {
+            break;
+        }
+        stripe++;
+    }
+
+    if (stripe == _stripe_count) {
+        cursor.clear();
+    } else {
+        cursor = std::to_string(stripe) + ":" + inner;
+    }
+    return true;
+}
+
+void StripedLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    // Counters are read without stripe locks, so numbers might be slightly off between each
+    // other but nobody waits for statistics
+    StorageStats total;
+    for (auto &shard : _shard) {
+        shard.Collect(total);
+    }
+
+    uint64_t replica_hits = 0;
+    _replicas.for_each([&replica_hits](replica &r) { replica_hits += r.hits.load(std::memory_order_relaxed); });
+    total.cmd_get += replica_hits;
+    total.get_hits += replica_hits;
+
+    total.Append(stats);
+    stats.emplace_back("hot_replica_hits", std::to_string(replica_hits));
+
+    std::vector<std::pair<std::string, uint64_t>> top;
+    {
+        std::lock_guard<std::mutex> _lock(_hot_mutex);
+        for (auto &candidate : _top.Top(kHotKeys)) {
+            if (_hot.count(candidate.first) > 0) {
+                top.push_back(candidate);
+            }
+        }
+    }
+
+    // Estimated number of hits is scaled back from sampled
+    for (std::size_t i = 0; i < top.size(); i++) {
+        std::string prefix = "hot_keys:" + std::to_string(i);
+        stats.emplace_back(prefix + ":key", top[i].first);
+        stats.emplace_back(prefix + ":hits", std::to_string(top[i].second * kSampleRate));
+    }
 }
 
 std::unique_ptr<StripedLRU> StripedLRU::BuildStripedLRU(std::size_t memory_limit, std::size_t stripe_count) {
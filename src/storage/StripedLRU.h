@@ -3,17 +3,40 @@
 
 
 #include "SimpleLRU.h"
+#include "TopKeys.h"
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include <afina/concurrency/ThreadLocal.h>
+
 namespace Afina {
 namespace Backend {
 
 /**
  * # Map based implementation
- * That is NOT thread safe implementaiton!!
+ * Storage is split onto stripes, each one is a SimpleLRU under its own lock.
+ *
+ * Gets are sampled into a top-k sketch to find hot keys. Each thread keeps a read replica
+ * of hot entries so that reads of those keys don't touch the stripe lock. Every write
+ * to a stripe bumps its version which invalidates replicated entries of the stripe.
+ *
+ * All stripes share the same flush clock, so flush doesn't lock any of them.
  */
 class StripedLRU: public Afina::Storage {
 public:
+    // Max number of keys considered to be hot
+    static constexpr std::size_t kHotKeys = 16;
+
+    // Each thread samples one of kSampleRate gets into the sketch, must be power of 2
+    static constexpr uint32_t kSampleRate = 16;
+
+    // Hot key set is recalculated after that number of samples
+    static constexpr uint32_t kHotRefresh = 1024;
+
+    // Key is hot if it gets at least 1/kHotShare of the sampled traffic
+    static constexpr uint32_t kHotShare = 64;
 
 
     StripedLRU(std::size_t max_size, std::size_t stripe_count);
@@ -24,13 +47,22 @@ public:
 
 
     // Implements Afina::Storage interface
-    bool Put(const std::string &key, const std::string &value) override;
+    bool Put(const std::string &key, const std::string &value, int64_t deadline = 0) override;
 
     // Implements Afina::Storage interface
-    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+    bool PutIfAbsent(const std::string &key, const std::string &value, int64_t deadline = 0) override;
 
     // Implements Afina::Storage interface
-    bool Set(const std::string &key, const std::string &value) override;
+    bool Set(const std::string &key, const std::string &value, int64_t deadline = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Modify(const std::string &key, const std::function<bool(std::string &value, bool found)> &update) override;
 
     // Implements Afina::Storage interface
     bool Delete(const std::string &key) override;
@@ -38,12 +70,80 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
+    // Implements Afina::Storage interface
+    bool Expire(const std::string &key, int64_t deadline) override;
+
+    // Implements Afina::Storage interface
+    bool GetExpire(const std::string &key, int64_t &deadline) override;
+
+    // Implements Afina::Storage interface
+    void Flush(int64_t at) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(std::string &cursor, std::size_t count, std::vector<std::string> &keys) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
 private:
+    // Write counter of a stripe, padded to live on its own cache line
+    struct stripe_version {
+        std::atomic<uint64_t> value{0};
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    // Copy of hot entry made by some thread
+    struct replica_entry {
+        std::string value;
+        uint64_t version;
+
+        // Expiration time is checked by replica itself, time doesn't bump stripe version
+        int64_t deadline;
+
+        // Neither does flush, see FlushClock
+        uint32_t generation;
+    };
+
+    // Per thread read replica of hot entries
+    struct replica {
+        // Hot set generation entries below belongs to
+        uint64_t generation = 0;
+
+        // Copy of the hot set
+        std::unordered_set<std::string> hot;
+
+        // Replicated entries, subset of hot ones
+        std::unordered_map<std::string, replica_entry> entries;
+
+        // State of xorshift generator used for sampling, plain counter would alias with
+        // periodic access patterns
+        uint32_t seed = 2463534242;
+
+        // Gets served by replica, read by Stats concurrently
+        std::atomic<uint64_t> hits{0};
+    };
+
+    void sample(replica &r, const std::string &key);
+    void refresh_hot_keys();
+
     std::size_t _capacity = 0;
     std::size_t _stripe_count = 0;
     std::hash<std::string> hash;
     std::vector<std::mutex> _mutex;
     std::vector< SimpleLRU> _shard;
+    std::vector<stripe_version> _version;
+    std::shared_ptr<FlushClock> _clock;
+
+    // Protects sketch and hot key set
+    std::mutex _hot_mutex;
+    TopKeys _top;
+    uint32_t _samples = 0;
+    std::unordered_set<std::string> _hot;
+
+    // Bumped each time hot set changes, so that threads could notice it without locking
+    std::atomic<uint64_t> _hot_generation{0};
+
+    Concurrency::ThreadLocal<replica> _replicas;
 };
 
 } // namespace Backend
@@ -24,21 +24,39 @@ public:
 
 
     // see SimpleLRU.h
-    bool Put(const std::string &key, const std::string &value) override {
+    bool Put(const std::string &key, const std::string &value, int64_t deadline = 0) override {
         std::lock_guard<std::mutex> _lock(_mutex);
-        return SimpleLRU::Put(key, value);
+        return SimpleLRU::Put(key, value, deadline);
     }
 
     // see SimpleLRU.h
-    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+    bool PutIfAbsent(const std::string &key, const std::string &value, int64_t deadline = 0) override {
         std::lock_guard<std::mutex> _lock(_mutex);
-        return SimpleLRU::PutIfAbsent(key, value);
+        return SimpleLRU::PutIfAbsent(key, value, deadline);
     }
 
     // see SimpleLRU.h
-    bool Set(const std::string &key, const std::string &value) override {
+    bool Set(const std::string &key, const std::string &value, int64_t deadline = 0) override {
         std::lock_guard<std::mutex> _lock(_mutex);
-        return SimpleLRU::Set(key, value);
+        return SimpleLRU::Set(key, value, deadline);
+    }
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> _lock(_mutex);
+        return SimpleLRU::Append(key, value);
+    }
+
+    // see SimpleLRU.h
+    bool Prepend(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> _lock(_mutex);
+        return SimpleLRU::Prepend(key, value);
+    }
+
+    // see SimpleLRU.h
+    bool Modify(const std::string &key, const std::function<bool(std::string &value, bool found)> &update) override {
+        std::lock_guard<std::mutex> _lock(_mutex);
+        return SimpleLRU::Modify(key, update);
     }
 
     // see SimpleLRU.h
@@ -53,6 +71,30 @@ public:
         return SimpleLRU::Get(key, value);
     }
 
+    // see SimpleLRU.h
+    bool Expire(const std::string &key, int64_t deadline) override {
+        std::lock_guard<std::mutex> _lock(_mutex);
+        return SimpleLRU::Expire(key, deadline);
+    }
+
+    // see SimpleLRU.h
+    bool GetExpire(const std::string &key, int64_t &deadline) override {
+        std::lock_guard<std::mutex> _lock(_mutex);
+        return SimpleLRU::GetExpire(key, deadline);
+    }
+
+    // see SimpleLRU.h
+    void Flush(int64_t at) override {
+        std::lock_guard<std::mutex> _lock(_mutex);
+        SimpleLRU::Flush(at);
+    }
+
+    // see SimpleLRU.h
+    bool Scan(std::string &cursor, std::size_t count, std::vector<std::string> &keys) override {
+        std::lock_guard<std::mutex> _lock(_mutex);
+        return SimpleLRU::Scan(cursor, count, keys);
+    }
+
 private:
     std::mutex _mutex;
 };
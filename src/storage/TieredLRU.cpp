@@ -0,0 +1,559 @@
+#include "TieredLRU.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+// See TieredLRU.h
+TieredLRU::segment::~segment() { close(fd); }
+
+// See TieredLRU.h
+TieredLRU::TieredLRU(std::size_t memory_limit, const std::string &directory, std::size_t disk_limit,
+                     std::size_t min_value_size, std::size_t segment_size)
+    : _directory(directory), _disk_limit(disk_limit), _min_value_size(min_value_size), _segment_size(segment_size),
+      _memory(memory_limit), _clock(std::make_shared<FlushClock>()), _disk_size(0), _demotions(0), _promotions(0), _disk_hits(0), _disk_evictions(0),
+      _disk_expirations(0), _compactions(0), _running(false) {
+    _memory.set_eviction_callback(
+        [this](const std::string &key, const std::string &value, int64_t deadline) { demote(key, value, deadline); });
+    _memory.set_flush_clock(_clock);
+}
+
+// See TieredLRU.h
+TieredLRU::~TieredLRU() { Stop(); }
+
+// See TieredLRU.h
+void TieredLRU::Start() {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    if (_running) {
+        return;
+    }
+
+    if (!_active) {
+        _active = open_segment();
+    }
+    _running = true;
+    _compact_thread = std::thread(&TieredLRU::OnCompact, this);
+}
+
+// See TieredLRU.h
+void TieredLRU::Stop() {
+    {
+        std::lock_guard<std::mutex> _lock(_mutex);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+        _compact_cv.notify_all();
+    }
+    _compact_thread.join();
+}
+
+// See TieredLRU.h
+bool TieredLRU::Put(const std::string &key, const std::string &value, int64_t deadline) {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    if (!_memory.Put(key, value, deadline)) {
+        return false;
+    }
+    forget(key);
+    return true;
+}
+
+// See TieredLRU.h
+bool TieredLRU::PutIfAbsent(const std::string &key, const std::string &value, int64_t deadline) {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    if (find_disk(key) != _disk.end()) {
+        return false;
+    }
+    return _memory.PutIfAbsent(key, value, deadline);
+}
+
+// See TieredLRU.h
+bool TieredLRU::Set(const std::string &key, const std::string &value, int64_t deadline) {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    if (find_disk(key) == _disk.end()) {
+        return _memory.Set(key, value, deadline);
+    }
+
+    if (!_memory.Put(key, value, deadline)) {
+        return false;
+    }
+    forget(key);
+    return true;
+}
+
+// See TieredLRU.h
+bool TieredLRU::Append(const std::string &key, const std::string &value) { return concat(key, value, false); }
+
+// See TieredLRU.h
+bool TieredLRU::Prepend(const std::string &key, const std::string &value) { return concat(key, value, true); }
+
+// Joins value with the existing one in whatever tier it is. Demoted value is read without lock
+// just as Get does, and it is joined only if nobody has changed it meanwhile
+bool TieredLRU::concat(const std::string &key, const std::string &value, bool front) {
+    while (true) {
+        extent location;
+        {
+            std::lock_guard<std::mutex> _lock(_mutex);
+            if (front ? _memory.Prepend(key, value) : _memory.Append(key, value)) {
+                return true;
+            }
+
+            auto it = find_disk(key);
+            if (it == _disk.end()) {
+                return false;
+            }
+            location = it->second;
+        }
+
+        std::string joined;
+        if (!read(location, joined)) {
+            return false;
+        }
+        if (front) {
+            joined.insert(0, value);
+        } else {
+            joined.append(value);
+        }
+
+        std::lock_guard<std::mutex> _lock(_mutex);
+        auto it = find_disk(key);
+        if (it != _disk.end() && it->second.seg == location.seg && it->second.offset == location.offset) {
+            // Joined value goes to RAM, just like promoted one does
+            if (!_memory.Put(key, joined, it->second.deadline)) {
+                return false;
+            }
+            forget(key);
+            return true;
+        }
+    }
+}
+
+// See TieredLRU.h
+bool TieredLRU::Modify(const std::string &key, const std::function<bool(std::string &value, bool found)> &update) {
+    // Demoted value is read without lock as concat does, update is called once it is known
+    // that nobody has changed value meanwhile
+    while (true) {
+        extent location;
+        {
+            std::lock_guard<std::mutex> _lock(_mutex);
+            auto it = find_disk(key);
+            if (it == _disk.end()) {
+                return _memory.Modify(key, update);
+            }
+            location = it->second;
+        }
+
+        std::string value;
+        if (!read(location, value)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> _lock(_mutex);
+        auto it = find_disk(key);
+        if (it != _disk.end() && it->second.seg == location.seg && it->second.offset == location.offset) {
+            // Changed value goes to RAM, just like promoted one does
+            if (!update(value, true) || !_memory.Put(key, value, it->second.deadline)) {
+                return false;
+            }
+            forget(key);
+            return true;
+        }
+    }
+}
+
+// See TieredLRU.h
+bool TieredLRU::Delete(const std::string &key) {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    bool on_disk = find_disk(key) != _disk.end() && forget(key);
+    bool in_memory = _memory.Delete(key);
+    return on_disk || in_memory;
+}
+
+// See TieredLRU.h
+bool TieredLRU::Get(const std::string &key, std::string &value) {
+    extent location;
+    {
+        std::lock_guard<std::mutex> _lock(_mutex);
+        if (_memory.Get(key, value)) {
+            return true;
+        }
+
+        auto it = find_disk(key);
+        if (it == _disk.end()) {
+            return false;
+        }
+        location = it->second;
+    }
+
+    // Segment is kept alive by the extent even if it gets dropped meanwhile
+    std::string disk_value;
+    if (!read(location, disk_value)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> _lock(_mutex);
+    _disk_hits++;
+
+    // Promote value back to RAM unless it was changed, moved or flushed while we were reading
+    auto it = find_disk(key);
+    if (it != _disk.end() && it->second.seg == location.seg && it->second.offset == location.offset) {
+        if (_memory.Put(key, disk_value, it->second.deadline)) {
+            forget(key);
+            _promotions++;
+        }
+    }
+    value.swap(disk_value);
+    return true;
+}
+
+// See TieredLRU.h
+bool TieredLRU::Expire(const std::string &key, int64_t deadline) {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    if (_memory.Expire(key, deadline)) {
+        return true;
+    }
+
+    auto it = find_disk(key);
+    if (it == _disk.end()) {
+        return false;
+    }
+    it->second.deadline = deadline;
+    return true;
+}
+
+// See TieredLRU.h
+bool TieredLRU::GetExpire(const std::string &key, int64_t &deadline) {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    if (_memory.GetExpire(key, deadline)) {
+        return true;
+    }
+
+    auto it = find_disk(key);
+    if (it == _disk.end()) {
+        return false;
+    }
+    deadline = it->second.deadline;
+    return true;
+}
+
+// See TieredLRU.h
+void TieredLRU::Flush(int64_t at) { _clock->flush(at); }
+
+// See TieredLRU.h
+bool TieredLRU::Scan(std::string &cursor, std::size_t count, std::vector<std::string> &keys) {
+    // Both tiers are ordered by key and key lives only in one of them, so page is the first
+    // count keys of both tiers after the cursor. Cursor format is the same as SimpleLRU has
+    assert(count > 0);
+    if (!cursor.empty() && cursor[0] != '>') {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> _lock(_mutex);
+    std::string memory_cursor = cursor;
+    std::vector<std::string> found;
+    if (!_memory.Scan(memory_cursor, count, found)) {
+        return false;
+    }
+
+    // Disk index is walked with the same limit of visited entries as memory is
+    int64_t now = unix_now();
+    uint32_t generation = _clock->generation();
+    std::size_t visits = SimpleLRU::kScanVisits * count;
+    auto it = cursor.empty() ? _disk.begin() : _disk.upper_bound(cursor.substr(1));
+    for (std::size_t i = 0; i < count && it != _disk.end() && visits > 0; ++it, visits--) {
+        if (it->second.generation == generation && !is_expired(it->second.deadline, now)) {
+            found.push_back(it->first);
+            i++;
+        }
+    }
+
+    // Each tier is seen up to its own bound, keys past the nearest one are left for the next page
+    bool memory_done = memory_cursor.empty();
+    bool disk_done = it == _disk.end();
+    std::string bound = memory_done ? std::string() : memory_cursor.substr(1);
+    if (!disk_done && (memory_done || std::prev(it)->first < bound)) {
+        bound = std::prev(it)->first;
+    }
+
+    std::sort(found.begin(), found.end());
+    if (!memory_done || !disk_done) {
+        found.erase(std::upper_bound(found.begin(), found.end(), bound), found.end());
+    }
+
+    if (found.size() > count) {
+        found.resize(count);
+        cursor = ">" + found.back();
+    } else if (memory_done && disk_done) {
+        cursor.clear();
+    } else {
+        cursor = ">" + bound;
+    }
+    keys.insert(keys.end(), found.begin(), found.end());
+    return true;
+}
+
+// See TieredLRU.h
+void TieredLRU::Stats(std::vector<std::pair<std::string, std::string>> &stats) {
+    std::lock_guard<std::mutex> _lock(_mutex);
+    uint64_t live = _active ? _active->live : 0;
+    for (auto &seg : _sealed) {
+        live += seg->live;
+    }
+
+    // Flushed and expired extents are dropped lazily, they aren't items anymore though
+    uint64_t disk_items = 0;
+    int64_t now = unix_now();
+    for (auto &entry : _disk) {
+        if (_clock->is_live(entry.second.generation) && !is_expired(entry.second.deadline, now)) {
+            disk_items++;
+        }
+    }
+
+    // Demoted entries are still in the cache, disk hits are hits
+    StorageStats total;
+    _memory.Collect(total);
+    total.get_hits += _disk_hits;
+    total.get_misses -= _disk_hits;
+    total.cmd_set -= _promotions;
+    total.evictions = total.evictions - _demotions + _disk_evictions;
+    total.expirations += _disk_expirations;
+    total.curr_items += disk_items;
+    total.Append(stats);
+
+    stats.emplace_back("tier_memory_bytes", std::to_string(_memory.get_size()));
+    stats.emplace_back("tier_disk_items", std::to_string(disk_items));
+    stats.emplace_back("tier_disk_bytes", std::to_string(_disk_size));
+    stats.emplace_back("tier_disk_live_bytes", std::to_string(live));
+    stats.emplace_back("tier_disk_segments", std::to_string(_sealed.size() + (_active ? 1 : 0)));
+    stats.emplace_back("tier_demotions", std::to_string(_demotions));
+    stats.emplace_back("tier_promotions", std::to_string(_promotions));
+    stats.emplace_back("tier_disk_hits", std::to_string(_disk_hits));
+    stats.emplace_back("tier_disk_evictions", std::to_string(_disk_evictions));
+    stats.emplace_back("tier_compactions", std::to_string(_compactions));
+}
+
+std::shared_ptr<TieredLRU::segment> TieredLRU::open_segment() {
+    std::string path = _directory + "/afina-tier-XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to create segment in " + _directory + ": " + std::string(strerror(errno)));
+    }
+    unlink(path.c_str());
+    return std::make_shared<segment>(fd);
+}
+
+// Called by SimpleLRU under _mutex
+void TieredLRU::demote(const std::string &key, const std::string &value, int64_t deadline) {
+    if (!_active || value.size() < _min_value_size || is_expired(deadline, unix_now())) {
+        return;
+    }
+
+    extent location;
+    location.deadline = deadline;
+    location.generation = _clock->generation();
+    if (append(value, location)) {
+        _disk[key] = location;
+        _active->summary.emplace_back(key, location.offset);
+        _demotions++;
+    }
+}
+
+// Must be called under _mutex. Expired or flushed value is dropped, so it is never returned
+std::map<std::string, TieredLRU::extent>::iterator TieredLRU::find_disk(const std::string &key) {
+    auto it = _disk.find(key);
+    if (it != _disk.end() && !_clock->is_live(it->second.generation)) {
+        forget(key);
+        return _disk.end();
+    } else if (it != _disk.end() && is_expired(it->second.deadline, unix_now())) {
+        forget(key);
+        _disk_expirations++;
+        return _disk.end();
+    }
+    return it;
+}
+
+// Must be called under _mutex
+bool TieredLRU::forget(const std::string &key) {
+    auto it = _disk.find(key);
+    if (it == _disk.end()) {
+        return false;
+    }
+
+    std::shared_ptr<segment> seg = it->second.seg;
+    seg->live -= it->second.size;
+    _disk.erase(it);
+    if (seg != _active && seg->live * 2 < seg->size) {
+        _compact_cv.notify_one();
+    }
+    return true;
+}
+
+// Must be called under _mutex. Note that it could drop old segments to get free space
+bool TieredLRU::append(const std::string &value, extent &location) {
+    if (value.size() > _disk_limit || value.size() > UINT32_MAX) {
+        return false;
+    }
+
+    while (_disk_size + value.size() > _disk_limit || _active->size + value.size() > _segment_size) {
+        if (_active->size + value.size() > _segment_size || _sealed.empty()) {
+            if (_active->size == 0) {
+                return false;
+            }
+
+            try {
+                std::shared_ptr<segment> next = open_segment();
+                _sealed.push_back(_active);
+                _active = next;
+            } catch (std::runtime_error &) {
+                return false;
+            }
+            continue;
+        }
+        drop_oldest();
+    }
+
+    std::size_t done = 0;
+    while (done < value.size()) {
+        ssize_t n = pwrite(_active->fd, value.data() + done, value.size() - done, _active->size + done);
+        if (n <= 0) {
+            if (n == -1 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        done += n;
+    }
+
+    location.seg = _active;
+    location.offset = _active->size;
+    location.size = value.size();
+
+    _active->size += value.size();
+    _active->live += value.size();
+    _disk_size += value.size();
+    return true;
+}
+
+// Must be called under _mutex
+void TieredLRU::drop_oldest() {
+    std::shared_ptr<segment> seg = _sealed.front();
+    _sealed.erase(_sealed.begin());
+
+    for (auto &entry : seg->summary) {
+        auto it = _disk.find(entry.first);
+        if (it != _disk.end() && it->second.seg == seg && it->second.offset == entry.second) {
+            _disk.erase(it);
+            _disk_evictions++;
+        }
+    }
+    _disk_size -= seg->size;
+}
+
+// Reads value without any locks
+bool TieredLRU::read(const extent &location, std::string &value) {
+    value.resize(location.size);
+    std::size_t done = 0;
+    while (done < location.size) {
+        ssize_t n = pread(location.seg->fd, &value[done], location.size - done, location.offset + done);
+        if (n <= 0) {
+            if (n == -1 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+// Moves live values out of sealed segment, so that it could be dropped. Sealed segment summary
+// never changes so it is safe to walk it without lock, the rest requires lock
+void TieredLRU::compact(std::shared_ptr<segment> seg) {
+    for (auto &entry : seg->summary) {
+        extent location;
+        {
+            std::lock_guard<std::mutex> _lock(_mutex);
+            if (!_running) {
+                return;
+            }
+
+            // Flushed and expired values are reclaimed right here
+            auto it = find_disk(entry.first);
+            if (it == _disk.end() || it->second.seg != seg || it->second.offset != entry.second) {
+                continue;
+            }
+            location = it->second;
+        }
+
+        std::string value;
+        if (!read(location, value)) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> _lock(_mutex);
+        extent moved;
+        if (!append(value, moved)) {
+            continue;
+        }
+        _active->summary.emplace_back(entry.first, moved.offset);
+
+        // Value might have been changed or dropped while it was copied
+        auto it = _disk.find(entry.first);
+        if (it != _disk.end() && it->second.seg == seg && it->second.offset == entry.second) {
+            seg->live -= it->second.size;
+            moved.deadline = it->second.deadline;
+            moved.generation = it->second.generation;
+            it->second = moved;
+        } else {
+            moved.seg->live -= moved.size;
+        }
+    }
+
+    std::lock_guard<std::mutex> _lock(_mutex);
+    auto pos = std::find(_sealed.begin(), _sealed.end(), seg);
+    if (pos == _sealed.end()) {
+        // Dropped already to free space
+        return;
+    }
+
+    // Whatever wasn't moved is lost, that is fine for the cache
+    std::rotate(_sealed.begin(), pos, pos + 1);
+    drop_oldest();
+    _compactions++;
+}
+
+// Background thread body
+void TieredLRU::OnCompact() {
+    std::unique_lock<std::mutex> _lock(_mutex);
+    while (_running) {
+        std::shared_ptr<segment> victim;
+        for (auto &seg : _sealed) {
+            if (seg->live * 2 < seg->size) {
+                victim = seg;
+                break;
+            }
+        }
+
+        if (!victim) {
+            _compact_cv.wait(_lock);
+            continue;
+        }
+
+        _lock.unlock();
+        compact(victim);
+        _lock.lock();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,178 @@
+#ifndef AFINA_STORAGE_TIERED_LRU_H
+#define AFINA_STORAGE_TIERED_LRU_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Two tier storage: RAM and local disk
+ * Hot entries live in SimpleLRU. Large values evicted from it are demoted to append-only
+ * segment files on local disk instead of being dropped, only their location stays in
+ * memory. Once demoted value gets read it is promoted back to RAM.
+ *
+ * Disk reads are done without holding storage lock, so a slow disk doesn't stop other
+ * clients. Segments are sealed once they grow over the segment size. Background thread
+ * compacts sealed segments when most of their data is overwritten, and the oldest segments
+ * are dropped once disk usage goes over the limit.
+ *
+ * Segment files are unlinked right after creation, so nothing is left on disk after restart
+ * or crash. Nothing gets demoted until storage is started.
+ *
+ * Both tiers share the flush clock. Flushed values are dropped from disk index once somebody
+ * looks them up or compaction runs into them.
+ */
+class TieredLRU : public Afina::Storage {
+public:
+    TieredLRU(std::size_t memory_limit, const std::string &directory, std::size_t disk_limit,
+              std::size_t min_value_size = 4096, std::size_t segment_size = 64 * 1024 * 1024);
+    ~TieredLRU();
+
+    // Implements Afina::Storage interface
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, int64_t deadline = 0) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, int64_t deadline = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, int64_t deadline = 0) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Modify(const std::string &key, const std::function<bool(std::string &value, bool found)> &update) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Expire(const std::string &key, int64_t deadline) override;
+
+    // Implements Afina::Storage interface
+    bool GetExpire(const std::string &key, int64_t &deadline) override;
+
+    // Implements Afina::Storage interface
+    void Flush(int64_t at) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(std::string &cursor, std::size_t count, std::vector<std::string> &keys) override;
+
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::string>> &stats) override;
+
+private:
+    // Append-only file with demoted values
+    struct segment {
+        segment(int f) : fd(f), size(0), live(0) {}
+        ~segment();
+
+        int fd;
+
+        // Bytes written, i.e offset of the next value
+        uint64_t size;
+
+        // Bytes still referenced from the index
+        uint64_t live;
+
+        // Keys written into this segment with their offsets, might be stale already
+        std::vector<std::pair<std::string, uint64_t>> summary;
+    };
+
+    // Location of demoted value
+    struct extent {
+        std::shared_ptr<segment> seg;
+        uint64_t offset;
+        uint32_t size;
+
+        // Expiration time of the value, 0 if never
+        int64_t deadline = 0;
+
+        // Flush generation value was written in, see FlushClock
+        uint32_t generation = 0;
+    };
+
+    std::shared_ptr<segment> open_segment();
+    void demote(const std::string &key, const std::string &value, int64_t deadline);
+    std::map<std::string, extent>::iterator find_disk(const std::string &key);
+    bool forget(const std::string &key);
+    bool concat(const std::string &key, const std::string &value, bool front);
+    bool append(const std::string &value, extent &location);
+    void drop_oldest();
+    bool read(const extent &e, std::string &value);
+    void compact(std::shared_ptr<segment> seg);
+    void OnCompact();
+
+    // Directory to create segments in
+    std::string _directory;
+
+    // Max number of bytes in all segments
+    std::size_t _disk_limit;
+
+    // Values smaller than that are not worth to be demoted
+    std::size_t _min_value_size;
+
+    // Segment gets sealed after it grows over that size
+    std::size_t _segment_size;
+
+    // Protects everything below
+    std::mutex _mutex;
+
+    // RAM tier
+    SimpleLRU _memory;
+
+    // Shared by both tiers
+    std::shared_ptr<FlushClock> _clock;
+
+    // Index of demoted values
+    std::map<std::string, extent> _disk;
+
+    // Segment new values are appended to
+    std::shared_ptr<segment> _active;
+
+    // Sealed segments, the oldest first
+    std::vector<std::shared_ptr<segment>> _sealed;
+
+    // Sum of sizes of all segments
+    uint64_t _disk_size;
+
+    // Counters for statistics
+    uint64_t _demotions;
+    uint64_t _promotions;
+    uint64_t _disk_hits;
+    uint64_t _disk_evictions;
+    uint64_t _disk_expirations;
+    uint64_t _compactions;
+
+    // Compaction thread and its wakeup
+    bool _running;
+    std::condition_variable _compact_cv;
+    std::thread _compact_thread;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TIERED_LRU_H
@@ -0,0 +1,67 @@
+#include "TopKeys.h"
+
+#include <algorithm>
+
+namespace Afina {
+namespace Backend {
+
+// See TopKeys.h
+void TopKeys::Add(const std::string &key) {
+    if (++_hits >= _window) {
+        decay();
+    }
+    _total++;
+
+    auto it = _counters.find(key);
+    if (it != _counters.end()) {
+        it->second++;
+        return;
+    }
+
+    if (_counters.size() < _capacity) {
+        _counters.emplace(key, 1);
+        return;
+    }
+
+    // Replace the coldest key, new one inherits its counter as possible error
+    auto victim = _counters.begin();
+    for (auto cur = _counters.begin(); cur != _counters.end(); ++cur) {
+        if (cur->second < victim->second) {
+            victim = cur;
+        }
+    }
+
+    uint64_t counter = victim->second + 1;
+    _counters.erase(victim);
+    _counters.emplace(key, counter);
+}
+
+// See TopKeys.h
+std::vector<std::pair<std::string, uint64_t>> TopKeys::Top(std::size_t n) const {
+    std::vector<std::pair<std::string, uint64_t>> result(_counters.begin(), _counters.end());
+    auto hotter = [](const std::pair<std::string, uint64_t> &a, const std::pair<std::string, uint64_t> &b) {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+    };
+
+    n = std::min(n, result.size());
+    std::partial_sort(result.begin(), result.begin() + n, result.end(), hotter);
+    result.resize(n);
+    return result;
+}
+
+void TopKeys::decay() {
+    _hits = 0;
+    _total = 0;
+    for (auto it = _counters.begin(); it != _counters.end();) {
+        it->second /= 2;
+        if (it->second == 0) {
+            it = _counters.erase(it);
+        } else {
+            _total += it->second;
+            ++it;
+        }
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
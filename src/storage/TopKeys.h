@@ -0,0 +1,67 @@
+#ifndef AFINA_STORAGE_TOP_KEYS_H
+#define AFINA_STORAGE_TOP_KEYS_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Streaming top-k estimation
+ * Space-Saving sketch: tracks at most capacity keys, once it is full new key replaces
+ * the one with the smallest counter and inherits that counter. Any key which gets more
+ * than 1/capacity of all hits is guaranteed to be tracked, counters overestimate real
+ * number of hits by at most the smallest counter.
+ *
+ * Counters are halved after every window of hits so that sketch follows changes in the
+ * traffic instead of remembering keys which were hot long ago.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class TopKeys {
+public:
+    TopKeys(std::size_t capacity = 64, uint64_t window = 64 * 1024)
+        : _capacity(capacity), _window(window), _hits(0), _total(0) {}
+
+    /**
+     * Register one more hit of the given key
+     */
+    void Add(const std::string &key);
+
+    /**
+     * Returns up to n keys having the largest counters, sorted from the hottest one
+     */
+    std::vector<std::pair<std::string, uint64_t>> Top(std::size_t n) const;
+
+    /**
+     * Sum of all counters, i.e number of hits seen in the current window
+     */
+    inline uint64_t total() const { return _total; }
+
+private:
+    void decay();
+
+    // Maximum number of keys to track
+    std::size_t _capacity;
+
+    // Number of hits after which all counters are halved
+    uint64_t _window;
+
+    // Number of hits since last decay
+    uint64_t _hits;
+
+    // Sum of all counters
+    uint64_t _total;
+
+    // Estimated number of hits by key
+    std::unordered_map<std::string, uint64_t> _counters;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TOP_KEYS_H
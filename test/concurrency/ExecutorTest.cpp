@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+
+#include <afina/concurrency/Executor.h>
+
+using namespace Afina::Concurrency;
+
+TEST(ExecutorTest, RunsEverything) {
+    std::atomic<int> done(0);
+    Executor executor("test", 4);
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(executor.Execute([&done](int step) { done += step; }, 1));
+    }
+
+    // Tasks enqueued before stop are still completed
+    executor.Stop(true);
+    EXPECT_EQ(1000, done.load());
+    EXPECT_FALSE(executor.Execute([&done] { done++; }));
+}
+
+TEST(ExecutorTest, TaskError) {
+    std::atomic<int> done(0);
+    Executor executor("test", 1);
+    ASSERT_TRUE(executor.Execute([] { throw std::runtime_error("failed"); }));
+    ASSERT_TRUE(executor.Execute([&done] { done++; }));
+
+    executor.Stop(true);
+    EXPECT_EQ(1, done.load());
+}
+
+TEST(ExecutorTest, NoThreads) { EXPECT_THROW(Executor("test", 0), std::runtime_error); }
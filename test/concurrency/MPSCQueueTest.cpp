@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/MPSCQueue.h>
+
+using namespace Afina::Concurrency;
+
+TEST(MPSCQueueTest, Bounded) {
+    EXPECT_THROW(MPSCQueue<int>(3), std::runtime_error);
+
+    MPSCQueue<int> queue(4);
+    int value;
+    EXPECT_FALSE(queue.pop(value));
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(queue.push(i));
+    }
+    EXPECT_FALSE(queue.push(4));
+
+    // Freed cell could be used again right away
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(0, value);
+    ASSERT_TRUE(queue.push(4));
+    for (int i = 1; i <= 4; i++) {
+        ASSERT_TRUE(queue.pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(MPSCQueueTest, ManyProducers) {
+    const int producers = 4, items = 100000;
+    MPSCQueue<int> queue(64);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p, items] {
+            for (int i = 0; i < items; i++) {
+                while (!queue.push(p * items + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Values of each producer come out in the order they were pushed
+    std::vector<int> last(producers, -1);
+    for (int n = 0; n < producers * items;) {
+        int value;
+        if (!queue.pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        int p = value / items;
+        ASSERT_LT(last[p], value % items);
+        last[p] = value % items;
+        n++;
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (int p = 0; p < producers; p++) {
+        EXPECT_EQ(items - 1, last[p]);
+    }
+}
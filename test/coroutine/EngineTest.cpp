@@ -2,6 +2,8 @@
 
 #include <iostream>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include <afina/coroutine/Engine.h>
 
@@ -62,3 +64,73 @@ TEST(CoroutineTest, Printer) {
     engine.start(_printer, engine, result);
     ASSERT_STREQ("A1 B1 A2 B2 A3 B3 END", result.c_str());
 }
+
+void _counter(Afina::Coroutine::Engine &pe, std::stringstream &out, char name) {
+    for (int i = 0; i < 3; i++) {
+        out << name << i << " ";
+        pe.yield();
+    }
+}
+
+void _round_robin(Afina::Coroutine::Engine &pe, std::stringstream &out) {
+    pe.run(_counter, pe, out, 'A');
+    pe.run(_counter, pe, out, 'B');
+    pe.run(_counter, pe, out, 'C');
+
+    // Main routine waits for the rest to complete
+    while (out.str().size() < 27) {
+        pe.yield();
+    }
+}
+
+TEST(CoroutineTest, YieldRoundRobin) {
+    Afina::Coroutine::Engine engine;
+
+    // Stacks of routines are copied on switch, so whatever they share lives outside of them
+    std::stringstream out;
+    engine.start(_round_robin, engine, out);
+
+    std::string result = out.str();
+    ASSERT_EQ(27, result.size());
+    for (char name : {'A', 'B', 'C'}) {
+        std::size_t pos = 0;
+        for (int i = 0; i < 3; i++) {
+            pos = result.find(name + std::to_string(i), pos);
+            ASSERT_NE(std::string::npos, pos) << result;
+        }
+    }
+}
+
+void _sleeper(Afina::Coroutine::Engine &pe, std::stringstream &out) {
+    out << "sleep ";
+    pe.block();
+    out << "wake ";
+}
+
+void _waker(Afina::Coroutine::Engine &pe, std::stringstream &out, std::vector<void *> &blocked) {
+    void *sleeper = pe.run(_sleeper, pe, out);
+    blocked.push_back(sleeper);
+    pe.sched(sleeper);
+
+    // Blocked routine gives control back and is never scheduled until unblocked
+    out << "main ";
+    pe.sched(sleeper);
+}
+
+TEST(CoroutineTest, BlockUnblock) {
+    std::vector<void *> blocked;
+    int unblocks = 0;
+    Afina::Coroutine::Engine engine([&](Afina::Coroutine::Engine &pe) {
+        // Called once nothing else could run
+        unblocks++;
+        for (auto routine : blocked) {
+            pe.unblock(routine);
+        }
+        blocked.clear();
+    });
+
+    std::stringstream out;
+    engine.start(_waker, engine, out, blocked);
+    ASSERT_EQ(1, unblocks);
+    ASSERT_EQ("sleep main wake ", out.str());
+}
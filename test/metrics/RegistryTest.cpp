@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/metrics/Registry.h>
+
+using namespace Afina::Metrics;
+
+// Value of the metric as rendered, empty if there is no such metric
+static std::string value(const std::string &group, const std::string &name) {
+    Registry::Values values;
+    Registry::Instance().Render(group, values);
+    for (auto &value : values) {
+        if (value.first == name) {
+            return value.second;
+        }
+    }
+    return "";
+}
+
+TEST(RegistryTest, CounterStripes) {
+    auto counter = Registry::Instance().GetCounter("test_counter");
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([counter] {
+            for (int j = 0; j < 10000; j++) {
+                counter->inc();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(80000, counter->get());
+    EXPECT_EQ("80000", value("", "test_counter"));
+}
+
+TEST(RegistryTest, SharedByName) {
+    auto gauge = Registry::Instance().GetGauge("test_gauge");
+    Registry::Instance().GetGauge("test_gauge")->add(5);
+    gauge->dec();
+    EXPECT_EQ(4, gauge->get());
+    EXPECT_EQ("4", value("", "test_gauge"));
+
+    // Name can't be taken by the metric of another kind
+    EXPECT_THROW(Registry::Instance().GetCounter("test_gauge"), std::runtime_error);
+}
+
+TEST(RegistryTest, Collectors) {
+    int owner = 0;
+    Registry::Instance().AddCollector("test", &owner, [](Registry::Values &values) {
+        values.emplace_back("collected", "1");
+    });
+
+    // Metrics belong to the general group only
+    Registry::Instance().GetCounter("test_group_counter");
+    EXPECT_EQ("1", value("test", "collected"));
+    EXPECT_EQ("", value("test", "test_group_counter"));
+    EXPECT_EQ("", value("", "collected"));
+
+    Registry::Instance().RemoveCollectors(&owner);
+    EXPECT_EQ("", value("test", "collected"));
+}
@@ -0,0 +1,178 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <afina/logging/Config.h>
+#include <afina/network/Server.h>
+
+#include <logging/ServiceImpl.h>
+#include <network/mt_coroutine/ServerImpl.h>
+#include <network/mt_nonblocking/ServerImpl.h>
+#include <network/uring/ServerImpl.h>
+#include <storage/StripedLRU.h>
+
+// Compares epoll based mt_nonblocking server with the io_uring and coroutine ones side by side:
+// the same number of workers serve the same clients, each client sends batches of pipelined gets
+// and waits for all the answers. Batch of one shows the cost of the round trip, where epoll server
+// pays for epoll_wait, read and write of every request. Not registered as a test, run
+// runNetworkBenchmark manually on a quiet machine
+
+namespace {
+
+const std::string kValue(32, 'x');
+const std::string kGet = "get bench\r\n";
+const std::string kAnswer = "VALUE bench 0 " + std::to_string(kValue.size()) + "\r\n" + kValue + "\r\nEND\r\n";
+
+int connect_to(uint16_t port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        close(sock);
+        throw std::runtime_error("Failed to connect: " + std::string(strerror(errno)));
+    }
+
+    int opts = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opts, sizeof(opts));
+    return sock;
+}
+
+void send_all(int sock, const std::string &data) {
+    for (std::size_t sent = 0; sent < data.size();) {
+        ssize_t n = send(sock, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            throw std::runtime_error("Failed to send request");
+        }
+        sent += n;
+    }
+}
+
+void recv_exactly(int sock, std::string &buffer, std::size_t size) {
+    buffer.resize(size);
+    for (std::size_t got = 0; got < size;) {
+        ssize_t n = recv(sock, &buffer[got], size - got, 0);
+        if (n <= 0) {
+            throw std::runtime_error("Connection closed by server");
+        }
+        got += n;
+    }
+}
+
+// Runs clients against the server on the port for a while, returns requests served
+uint64_t load(uint16_t port, std::size_t clients, std::size_t batch, std::chrono::milliseconds duration) {
+    std::string requests;
+    std::string answers;
+    for (std::size_t i = 0; i < batch; i++) {
+        requests += kGet;
+        answers += kAnswer;
+    }
+
+    std::atomic<bool> running(true);
+    std::atomic<uint64_t> served(0);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < clients; i++) {
+        threads.emplace_back([&]() {
+            int sock = connect_to(port);
+            std::string buffer;
+            uint64_t done = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                send_all(sock, requests);
+                recv_exactly(sock, buffer, answers.size());
+                if (buffer != answers) {
+                    throw std::runtime_error("Unexpected answer");
+                }
+                done += batch;
+            }
+            close(sock);
+            served += done;
+        });
+    }
+
+    std::this_thread::sleep_for(duration);
+    running = false;
+    for (auto &t : threads) {
+        t.join();
+    }
+    return served;
+}
+
+double cpu_seconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+void bench(const char *title, uint16_t port, std::size_t clients, std::size_t batch) {
+    const std::chrono::seconds duration(2);
+    double cpu = cpu_seconds();
+    uint64_t served = load(port, clients, batch, duration);
+    cpu = cpu_seconds() - cpu;
+
+    // CPU time includes clients, they are the same for both servers
+    std::cout << title << ", " << clients << " clients, batch " << batch << ": "
+              << static_cast<uint64_t>(served / std::chrono::duration<double>(duration).count())
+              << " requests/sec, " << cpu * 1e6 / served << " cpu us/request" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    const uint32_t workers = 2;
+
+    auto config = std::make_shared<Afina::Logging::Config>();
+    Afina::Logging::Appender &console = config->appenders["console"];
+    console.type = Afina::Logging::Appender::Type::STDOUT;
+    Afina::Logging::Logger &logger = config->loggers["root"];
+    logger.level = Afina::Logging::Logger::Level::ERROR;
+    logger.appenders.push_back("console");
+    auto logging = std::make_shared<Afina::Logging::ServiceImpl>(config);
+    logging->Start();
+
+    std::shared_ptr<Afina::Storage> storage = Afina::Backend::StripedLRU::BuildStripedLRU(64 * 1024 * 1024, 4);
+    storage->Put("bench", kValue);
+
+    Afina::Network::MTnonblock::ServerImpl epoll(storage, logging);
+    epoll.Start(18080, 0, workers);
+    Afina::Network::Uring::ServerImpl uring(storage, logging);
+    uring.Start(18081, 0, workers);
+    Afina::Network::MTcoroutine::ServerImpl coroutine(storage, logging);
+    coroutine.Start(18082, 0, workers);
+
+    for (std::size_t batch : {std::size_t(1), std::size_t(32)}) {
+        for (std::size_t clients : {std::size_t(4), std::size_t(64)}) {
+            bench("mt_nonblock", 18080, clients, batch);
+            bench("uring", 18081, clients, batch);
+            bench("mt_coroutine", 18082, clients, batch);
+        }
+    }
+
+    epoll.Stop();
+    epoll.Join();
+    uring.Stop();
+    uring.Join();
+    coroutine.Stop();
+    coroutine.Join();
+    logging->Stop();
+    return 0;
+}
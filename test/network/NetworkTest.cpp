@@ -0,0 +1,362 @@
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <afina/logging/Config.h>
+#include <afina/network/Server.h>
+
+#include <logging/ServiceImpl.h>
+#include <network/mt_coroutine/ServerImpl.h>
+#include <network/mt_nonblocking/ServerImpl.h>
+#include <network/st_nonblocking/ServerImpl.h>
+#include <network/uring/ServerImpl.h>
+#include <storage/StripedLRU.h>
+
+using namespace Afina;
+
+// Each server is started on the loopback against real sockets: clients pipeline commands, stop
+// reading for a while and stay connected while the server is stopped
+
+namespace {
+
+// Loggers are registered globally, so all tests share one service
+std::shared_ptr<Logging::Service> logging() {
+    static std::shared_ptr<Logging::Service> service;
+    if (service) {
+        return service;
+    }
+
+    auto config = std::make_shared<Logging::Config>();
+    Logging::Appender &console = config->appenders["console"];
+    console.type = Logging::Appender::Type::STDOUT;
+    Logging::Logger &logger = config->loggers["root"];
+    logger.level = Logging::Logger::Level::ERROR;
+    logger.appenders.push_back("console");
+
+    service = std::make_shared<Logging::ServiceImpl>(config);
+    service->Start();
+    return service;
+}
+
+// Socket with a timeout isn't restarted after a signal, client just tries once again
+bool interrupted(ssize_t n) { return n == -1 && errno == EINTR; }
+
+// Port nobody listens on. Socket holding it is bound but never listens, so servers could bind
+// the same port with SO_REUSEPORT and it is closed once they do
+int reserve_port(uint16_t &port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    int opts = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &opts, sizeof(opts));
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    socklen_t size = sizeof(addr);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+        getsockname(sock, (struct sockaddr *)&addr, &size) == -1) {
+        throw std::runtime_error("Failed to reserve port: " + std::string(strerror(errno)));
+    }
+    port = ntohs(addr.sin_port);
+    return sock;
+}
+
+int connect_to(uint16_t port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        close(sock);
+        throw std::runtime_error("Failed to connect: " + std::string(strerror(errno)));
+    }
+
+    // Broken server fails the test rather than hangs it
+    struct timeval timeout = {10, 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return sock;
+}
+
+void send_all(int sock, const std::string &data) {
+    for (std::size_t sent = 0; sent < data.size();) {
+        ssize_t n = send(sock, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (interrupted(n)) {
+            continue;
+        } else if (n <= 0) {
+            throw std::runtime_error("Failed to send request");
+        }
+        sent += n;
+    }
+}
+
+std::string recv_exactly(int sock, std::size_t size) {
+    std::string buffer(size, '\0');
+    for (std::size_t got = 0; got < size;) {
+        ssize_t n = recv(sock, &buffer[got], size - got, 0);
+        if (interrupted(n)) {
+            continue;
+        } else if (n <= 0) {
+            throw std::runtime_error("Connection closed by server");
+        }
+        got += n;
+    }
+    return buffer;
+}
+
+// True if server has closed connection, whatever it has sent before is skipped
+bool closed_by_server(int sock) {
+    char buffer[4096];
+    while (true) {
+        ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+        if (interrupted(n)) {
+            continue;
+        } else if (n == 0 || (n == -1 && errno == ECONNRESET)) {
+            return true;
+        } else if (n == -1) {
+            return false;
+        }
+    }
+}
+
+// Several clients pipeline sets and gets of their own keys
+void check_pipeline(uint16_t port, std::size_t clients) {
+    std::vector<int> socks;
+    for (std::size_t i = 0; i < clients; i++) {
+        socks.push_back(connect_to(port));
+    }
+
+    for (int round = 0; round < 10; round++) {
+        std::vector<std::string> answers;
+        for (std::size_t i = 0; i < clients; i++) {
+            std::string key = "key" + std::to_string(i);
+            std::string value = std::to_string(round) + std::string(i * 100, 'v');
+            std::string size = std::to_string(value.size());
+            std::string requests;
+            std::string answer;
+            for (int j = 0; j < 20; j++) {
+                requests += "set " + key + " 0 0 " + size + "\r\n" + value + "\r\nget " + key + "\r\n";
+                answer += "STORED\r\nVALUE " + key + " 0 " + size + "\r\n" + value + "\r\nEND\r\n";
+            }
+            send_all(socks[i], requests);
+            answers.push_back(answer);
+        }
+
+        for (std::size_t i = 0; i < clients; i++) {
+            ASSERT_EQ(answers[i], recv_exactly(socks[i], answers[i].size()));
+        }
+    }
+
+    for (int sock : socks) {
+        close(sock);
+    }
+}
+
+// Client asks for much more than server is ready to queue and reads it only afterwards
+void check_backpressure(uint16_t port) {
+    int sock = connect_to(port);
+    std::string value(100 * 1024, 'b');
+    std::string header = "VALUE big 0 " + std::to_string(value.size()) + "\r\n";
+    send_all(sock, "set big 0 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\n");
+    ASSERT_EQ("STORED\r\n", recv_exactly(sock, 8));
+
+    std::string requests;
+    for (int i = 0; i < 100; i++) {
+        requests += "get big\r\n";
+    }
+    send_all(sock, requests);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(header + value + "\r\nEND\r\n", recv_exactly(sock, header.size() + value.size() + 7));
+    }
+
+    // Output is read right away now, each read of requests goes over the output limit: server
+    // stops reading, sends everything and has to go on with requests left in the socket without
+    // a new event for them
+    std::string mid(4 * 1024, 'm');
+    send_all(sock, "set mid 0 0 " + std::to_string(mid.size()) + "\r\n" + mid + "\r\n");
+    ASSERT_EQ("STORED\r\n", recv_exactly(sock, 8));
+
+    requests.clear();
+    for (int i = 0; i < 1000; i++) {
+        requests += "get mid\r\n";
+    }
+    send_all(sock, requests);
+
+    std::string answer = "VALUE mid 0 " + std::to_string(mid.size()) + "\r\n" + mid + "\r\nEND\r\n";
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_EQ(answer, recv_exactly(sock, answer.size()));
+    }
+    close(sock);
+}
+
+// Multiget too large to be run by event loop goes to the thread pool, command after it waits
+// for the pool to finish
+void check_slow(uint16_t port) {
+    int sock = connect_to(port);
+    send_all(sock, "set slow 0 0 4\r\nslow\r\n");
+    ASSERT_EQ("STORED\r\n", recv_exactly(sock, 8));
+
+    std::string request = "get";
+    std::string answer;
+    for (int i = 0; i < 64; i++) {
+        request += " slow";
+        answer += "VALUE slow 0 4\r\nslow\r\n";
+    }
+    send_all(sock, request + "\r\nget slow\r\n");
+    answer += "END\r\nVALUE slow 0 4\r\nslow\r\nEND\r\n";
+    ASSERT_EQ(answer, recv_exactly(sock, answer.size()));
+    close(sock);
+}
+
+// Idle clients, clients in the middle of the command and client waiting for the output don't
+// stop server from stopping, all of them get disconnected
+void check_stop(Network::Server &server, uint16_t port, std::size_t clients) {
+    std::vector<int> socks;
+    for (std::size_t i = 0; i < clients; i++) {
+        socks.push_back(connect_to(port));
+        if (i % 3 == 1) {
+            send_all(socks.back(), "set half 0 0 10\r\nhal");
+        } else if (i % 3 == 2) {
+            send_all(socks.back(), "get big\r\nget big\r\nget big\r\nget big\r\nget big\r\n");
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    server.Stop();
+    server.Join();
+    for (int sock : socks) {
+        EXPECT_TRUE(closed_by_server(sock));
+        close(sock);
+    }
+}
+
+// Clients keep connecting while server stops: whether connection is still queued to the
+// acceptor, handed over to the worker or served already, it gets closed
+void check_storm(Network::Server &server, uint16_t port) {
+    std::vector<int> socks;
+    std::thread clients([&socks, port] {
+        for (int i = 0; i < 1000; i++) {
+            try {
+                socks.push_back(connect_to(port));
+            } catch (std::runtime_error &) {
+                // Server doesn't listen anymore
+                break;
+            }
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    server.Stop();
+    server.Join();
+    clients.join();
+    for (int sock : socks) {
+        EXPECT_TRUE(closed_by_server(sock));
+        close(sock);
+    }
+}
+
+bool uring_supported() {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int ring = syscall(__NR_io_uring_setup, 1, &params);
+    if (ring == -1) {
+        return false;
+    }
+    close(ring);
+    return true;
+}
+
+} // namespace
+
+TEST(NetworkTest, MTcoroutine) {
+    auto storage = Backend::StripedLRU::BuildStripedLRU(64 * 1024 * 1024, 4);
+    Network::MTcoroutine::ServerImpl server(std::move(storage), logging());
+    uint16_t port;
+    int reserved = reserve_port(port);
+    server.Start(port, 0, 2);
+    close(reserved);
+
+    check_pipeline(port, 8);
+    check_backpressure(port);
+    check_stop(server, port, 12);
+}
+
+TEST(NetworkTest, STnonblock) {
+    auto storage = Backend::StripedLRU::BuildStripedLRU(64 * 1024 * 1024, 4);
+    Network::STnonblock::ServerImpl server(std::move(storage), logging());
+
+    // Server listens without SO_REUSEPORT, so port is given up before it starts
+    uint16_t port;
+    close(reserve_port(port));
+    server.Start(port, 0, 1);
+
+    check_pipeline(port, 4);
+    check_slow(port);
+    check_backpressure(port);
+    server.Stop();
+    server.Join();
+}
+
+TEST(NetworkTest, MTnonblock) {
+    auto storage = Backend::StripedLRU::BuildStripedLRU(64 * 1024 * 1024, 4);
+    Network::MTnonblock::ServerImpl server(std::move(storage), logging());
+    uint16_t port;
+    int reserved = reserve_port(port);
+    server.Start(port, 0, 2);
+    close(reserved);
+
+    check_pipeline(port, 8);
+    check_slow(port);
+    check_backpressure(port);
+    check_stop(server, port, 12);
+}
+
+TEST(NetworkTest, MTnonblockAcceptors) {
+    auto storage = Backend::StripedLRU::BuildStripedLRU(64 * 1024 * 1024, 4);
+    Network::MTnonblock::ServerImpl server(std::move(storage), logging());
+    uint16_t port;
+    int reserved = reserve_port(port);
+    server.Start(port, 2, 4);
+    close(reserved);
+
+    check_pipeline(port, 64);
+    check_storm(server, port);
+}
+
+TEST(NetworkTest, Uring) {
+    if (!uring_supported()) {
+        std::cout << "io_uring isn't available, test is skipped" << std::endl;
+        return;
+    }
+
+    auto storage = Backend::StripedLRU::BuildStripedLRU(64 * 1024 * 1024, 4);
+    Network::Uring::ServerImpl server(std::move(storage), logging());
+    uint16_t port;
+    int reserved = reserve_port(port);
+    server.Start(port, 0, 2);
+    close(reserved);
+
+    check_pipeline(port, 8);
+    check_backpressure(port);
+    check_stop(server, port, 12);
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include <endian.h>
+
+#include <protocol/BinaryParser.h>
+#include <storage/SimpleLRU.h>
+
+using namespace Afina;
+using Protocol::BinaryParser;
+
+// Builds request packet
+static std::string request(uint8_t opcode, const std::string &key, const std::string &value = "",
+                           const std::string &extras = "", uint32_t opaque = 0) {
+    char header[BinaryParser::kHeaderSize];
+    std::memset(header, 0, sizeof(header));
+    header[0] = static_cast<char>(BinaryParser::kRequestMagic);
+    header[1] = static_cast<char>(opcode);
+    uint16_t key_length = htobe16(key.size());
+    std::memcpy(header + 2, &key_length, 2);
+    header[4] = static_cast<char>(extras.size());
+    uint32_t body = htobe32(extras.size() + key.size() + value.size());
+    std::memcpy(header + 8, &body, 4);
+    std::memcpy(header + 12, &opaque, 4);
+    return std::string(header, sizeof(header)) + extras + key + value;
+}
+
+// Decoded response packet
+struct Response {
+    uint8_t opcode;
+    uint16_t status;
+    uint32_t opaque;
+    std::string extras;
+    std::string key;
+    std::string value;
+};
+
+// Takes the first response packet out of the output
+static Response response(std::string &out) {
+    Response r;
+    EXPECT_GE(out.size(), BinaryParser::kHeaderSize);
+    EXPECT_EQ(BinaryParser::kResponseMagic, static_cast<uint8_t>(out[0]));
+
+    uint16_t key_length, status;
+    uint32_t body;
+    r.opcode = out[1];
+    std::memcpy(&key_length, &out[2], 2);
+    std::memcpy(&status, &out[6], 2);
+    std::memcpy(&body, &out[8], 4);
+    std::memcpy(&r.opaque, &out[12], 4);
+    key_length = be16toh(key_length);
+    r.status = be16toh(status);
+    body = be32toh(body);
+
+    uint8_t extras_length = out[4];
+    r.extras = out.substr(BinaryParser::kHeaderSize, extras_length);
+    r.key = out.substr(BinaryParser::kHeaderSize + extras_length, key_length);
+    r.value = out.substr(BinaryParser::kHeaderSize + extras_length + key_length, body - extras_length - key_length);
+    out.erase(0, BinaryParser::kHeaderSize + body);
+    return r;
+}
+
+// Parses and executes all packets of the input
+static std::string run(BinaryParser &parser, Storage &storage, const std::string &input) {
+    std::string out;
+    for (size_t offset = 0; offset < input.size();) {
+        size_t parsed = 0;
+        if (parser.Parse(input.data() + offset, input.size() - offset, parsed)) {
+            parser.Execute(storage, out);
+            parser.Reset();
+        }
+        offset += parsed;
+    }
+    return out;
+}
+
+TEST(BinaryParserTest, SetGet) {
+    Backend::SimpleLRU storage;
+    BinaryParser parser;
+
+    std::string out = run(parser, storage, request(BinaryParser::oSet, "foo", "bar", std::string(8, '\0'), 42));
+    Response set = response(out);
+    ASSERT_EQ(BinaryParser::oSet, set.opcode);
+    ASSERT_EQ(BinaryParser::sOk, set.status);
+    ASSERT_EQ(42, set.opaque);
+    ASSERT_TRUE(out.empty());
+
+    out = run(parser, storage, request(BinaryParser::oGetK, "foo"));
+    Response get = response(out);
+    ASSERT_EQ(BinaryParser::sOk, get.status);
+    ASSERT_EQ(4, get.extras.size());
+    ASSERT_EQ("foo", get.key);
+    ASSERT_EQ("bar", get.value);
+
+    out = run(parser, storage, request(BinaryParser::oGet, "none"));
+    ASSERT_EQ(BinaryParser::sNotFound, response(out).status);
+}
+
+// Exptime beyond int32 is far in the future rather than in the past
+TEST(BinaryParserTest, LargeExptime) {
+    Backend::SimpleLRU storage;
+    BinaryParser parser;
+
+    std::string extras(8, '\0');
+    uint32_t exptime = htobe32(0xFFFFFFFF);
+    std::memcpy(&extras[4], &exptime, 4);
+    std::string out = run(parser, storage, request(BinaryParser::oSet, "foo", "bar", extras));
+    ASSERT_EQ(BinaryParser::sOk, response(out).status);
+
+    out = run(parser, storage, request(BinaryParser::oTouch, "foo", "", extras.substr(4)));
+    ASSERT_EQ(BinaryParser::sOk, response(out).status);
+
+    out = run(parser, storage, request(BinaryParser::oGet, "foo"));
+    Response get = response(out);
+    ASSERT_EQ(BinaryParser::sOk, get.status);
+    ASSERT_EQ("bar", get.value);
+}
+
+// Quiet commands answer nothing but errors, noop finishes the batch
+TEST(BinaryParserTest, QuietPipeline) {
+    Backend::SimpleLRU storage;
+    BinaryParser parser;
+
+    std::string input = request(BinaryParser::oSetQ, "a", "1", std::string(8, '\0')) +
+                        request(BinaryParser::oAddQ, "a", "2", std::string(8, '\0')) +
+                        request(BinaryParser::oAppendQ, "a", "x") + request(BinaryParser::oGetQ, "none") +
+                        request(BinaryParser::oGetKQ, "a") + request(BinaryParser::oNoop, "");
+
+    // Split input by small chunks to check buffering
+    std::string out;
+    for (size_t offset = 0; offset < input.size(); offset += 7) {
+        out += run(parser, storage, input.substr(offset, 7));
+    }
+
+    Response add = response(out);
+    ASSERT_EQ(BinaryParser::oAddQ, add.opcode);
+    ASSERT_EQ(BinaryParser::sExists, add.status);
+
+    Response get = response(out);
+    ASSERT_EQ(BinaryParser::oGetKQ, get.opcode);
+    ASSERT_EQ("a", get.key);
+    ASSERT_EQ("1x", get.value);
+
+    ASSERT_EQ(BinaryParser::oNoop, response(out).opcode);
+    ASSERT_TRUE(out.empty());
+}
+
+TEST(BinaryParserTest, Errors) {
+    Backend::SimpleLRU storage;
+    BinaryParser parser;
+
+    std::string out = run(parser, storage, request(0x42, "a"));
+    ASSERT_EQ(BinaryParser::sUnknownCommand, response(out).status);
+
+    out = run(parser, storage, request(BinaryParser::oSet, "a", "1"));
+    ASSERT_EQ(BinaryParser::sInvalid, response(out).status);
+
+    out = run(parser, storage, request(BinaryParser::oReplace, "a", "1", std::string(8, '\0')));
+    ASSERT_EQ(BinaryParser::sNotFound, response(out).status);
+
+    out = run(parser, storage, request(BinaryParser::oQuit, ""));
+    ASSERT_EQ(BinaryParser::sOk, response(out).status);
+    ASSERT_TRUE(parser.Quit());
+
+    size_t parsed;
+    ASSERT_THROW(BinaryParser().Parse("get foo\r\n..............", 24, parsed), std::runtime_error);
+}
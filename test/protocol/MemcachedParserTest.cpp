@@ -4,11 +4,19 @@
 #include <string>
 
 #include <afina/execute/Add.h>
+#include <afina/execute/Delete.h>
+#include <afina/execute/FlushAll.h>
+#include <afina/execute/Gat.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/MetaSet.h>
+#include <afina/execute/Scan.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
+#include <afina/execute/Touch.h>
 
+#include <protocol/CommandSlot.h>
 #include <protocol/Parser.h>
+#include <storage/SimpleLRU.h>
 
 using namespace Afina;
 
@@ -98,3 +106,305 @@ TEST(MemcachedParserTest, Stats) {
     Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
     ASSERT_FALSE(tmp == nullptr);
 }
+
+// Verify scan command with explicit page size
+TEST(MemcachedParserTest, Scan) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("scan 1:>key 50\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(16, consumed);
+    ASSERT_EQ("scan", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0, value_size);
+
+    Execute::Scan *tmp = reinterpret_cast<Execute::Scan *>(cmd.get());
+    ASSERT_EQ("1:>key", tmp->cursor());
+    ASSERT_EQ(50, tmp->count());
+}
+
+// Verify command split onto many reads, one byte each
+TEST(MemcachedParserTest, SplitInput) {
+    Protocol::Parser parser;
+    std::string input = "get key_longer_than_the_simd_block_for_sure   other\r\n";
+
+    size_t total = 0;
+    bool cmd_avail = false;
+    for (size_t i = 0; i < input.size() && !cmd_avail; i++) {
+        size_t consumed = 0;
+        cmd_avail = parser.Parse(&input[i], 1, consumed);
+        ASSERT_EQ(1, consumed);
+        total += consumed;
+    }
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(input.size(), total);
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+
+    Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd.get());
+    std::vector<std::string> keys = tmp->keys();
+    ASSERT_EQ(2, keys.size());
+    ASSERT_EQ("key_longer_than_the_simd_block_for_sure", keys[0]);
+    ASSERT_EQ("other", keys[1]);
+}
+
+// Verify that only the first command gets consumed from pipelined input
+TEST(MemcachedParserTest, Pipelined) {
+    Protocol::Parser parser;
+    std::string input = "get a\r\nset b 4294967295 -1 3\r\nxyz\r\n";
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse(input, consumed));
+    ASSERT_EQ(7, consumed);
+    ASSERT_EQ("get", parser.Name());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse(input.substr(consumed), consumed));
+    ASSERT_EQ(23, consumed);
+    ASSERT_EQ("set", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_EQ(3, value_size);
+}
+
+// Parses single line, returns error reported for it
+static std::string error_of(const std::string &input) {
+    Protocol::Parser parser;
+    size_t consumed = 0;
+    EXPECT_TRUE(parser.Parse(input, consumed));
+    EXPECT_EQ(input.size(), consumed);
+    return parser.Error() != nullptr ? parser.Error() : "";
+}
+
+TEST(MemcachedParserTest, Errors) {
+    ASSERT_EQ("ERROR", error_of("foo bar\r\n"));
+    ASSERT_EQ("ERROR", error_of("\r\n"));
+    ASSERT_EQ("CLIENT_ERROR bad command line format", error_of("get\r\n"));
+    ASSERT_EQ("CLIENT_ERROR bad command line termination", error_of("get key\n"));
+    ASSERT_EQ("CLIENT_ERROR bad command line format", error_of("set key 0 0\r\n"));
+    ASSERT_EQ("CLIENT_ERROR bad command line format", error_of("set key 0 0 1 2 3\r\n"));
+    ASSERT_EQ("CLIENT_ERROR invalid flags", error_of("set key 4294967296 0 1\r\n"));
+    ASSERT_EQ("CLIENT_ERROR invalid exptime", error_of("set key 0 1x 1\r\n"));
+    ASSERT_EQ("CLIENT_ERROR invalid scan count", error_of("scan 0 x\r\n"));
+    ASSERT_EQ("CLIENT_ERROR invalid scan count", error_of("scan 0 0\r\n"));
+    ASSERT_EQ("CLIENT_ERROR bad command line format", error_of("delete\r\n"));
+    ASSERT_EQ("CLIENT_ERROR bad command line format", error_of("delete a b\r\n"));
+    ASSERT_EQ("CLIENT_ERROR bad command line format", error_of("touch key\r\n"));
+    ASSERT_EQ("CLIENT_ERROR invalid exptime", error_of("touch key noreply\r\n"));
+    ASSERT_EQ("CLIENT_ERROR invalid exptime", error_of("gat key a\r\n"));
+    ASSERT_EQ("CLIENT_ERROR bad command line format", error_of("gat 10\r\n"));
+    ASSERT_EQ("CLIENT_ERROR bad command line format", error_of("flush_all x\r\n"));
+    ASSERT_EQ("", error_of("get key\r\n"));
+
+    // Invalid command can't be built
+    Protocol::Parser parser;
+    size_t consumed = 0, body_size = 0;
+    ASSERT_TRUE(parser.Parse("set key x 0 1\r\n", consumed));
+    ASSERT_FALSE(parser.Build(body_size));
+}
+
+// Verify that parser gets back in sync after an invalid line
+TEST(MemcachedParserTest, Resync) {
+    Protocol::Parser parser;
+    std::string input = "bogus command\r\nget key\r\n";
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse(input.data(), input.size(), consumed));
+    ASSERT_EQ(15, consumed);
+    ASSERT_STREQ("ERROR", parser.Error());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse(input.data() + consumed, input.size() - consumed, consumed));
+    ASSERT_EQ(nullptr, parser.Error());
+    ASSERT_EQ("get", parser.Name());
+
+    // Too long line is dropped as it arrives and reported once it ends
+    parser.Reset();
+    std::string garbage(Protocol::Parser::kMaxLine, 'g');
+    ASSERT_FALSE(parser.Parse(garbage.data(), garbage.size(), consumed));
+    ASSERT_FALSE(parser.Parse(garbage.data(), garbage.size(), consumed));
+    ASSERT_EQ(garbage.size(), consumed);
+    ASSERT_TRUE(parser.Parse(input.data(), input.size(), consumed));
+    ASSERT_EQ(15, consumed);
+    ASSERT_STREQ("CLIENT_ERROR line is too long", parser.Error());
+}
+
+TEST(MemcachedParserTest, NoReply) {
+    Protocol::Parser parser;
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("set key 0 0 5 noreply\r\n", consumed));
+    EXPECT_TRUE(parser.NoReply());
+    EXPECT_EQ(Protocol::Parser::Op::Set, parser.Code());
+
+    size_t body_size = 0;
+    auto command = parser.Build(body_size);
+    ASSERT_TRUE(command);
+    EXPECT_EQ(5, body_size);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("add key 0 0 5\r\n", consumed));
+    EXPECT_FALSE(parser.NoReply());
+
+    ASSERT_EQ("CLIENT_ERROR bad command line format", error_of("set key 0 0 5 yesreply\r\n"));
+    ASSERT_EQ("CLIENT_ERROR bad command line format", error_of("set key 0 0 5 noreply noreply\r\n"));
+}
+
+// Verify arguments of the commands which don't have data block
+TEST(MemcachedParserTest, KeyCommands) {
+    Protocol::Parser parser;
+    Protocol::CommandSlot slot;
+    size_t consumed = 0, body_size = 0;
+
+    ASSERT_TRUE(parser.Parse("delete key noreply\r\n", consumed));
+    ASSERT_EQ(Protocol::Parser::Op::Delete, parser.Code());
+    ASSERT_TRUE(parser.NoReply());
+    auto *del = reinterpret_cast<Execute::Delete *>(parser.Build(slot, body_size));
+    ASSERT_EQ("key", del->key());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("touch key -1\r\n", consumed));
+    ASSERT_FALSE(parser.NoReply());
+    auto *touch = reinterpret_cast<Execute::Touch *>(parser.Build(slot, body_size));
+    ASSERT_EQ("key", touch->key());
+    ASSERT_EQ(-1, touch->expire());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("gats 100 a b\r\n", consumed));
+    auto *gat = reinterpret_cast<Execute::Gat *>(parser.Build(slot, body_size));
+    ASSERT_EQ(2, gat->keys().size());
+    ASSERT_EQ("a", gat->keys()[0]);
+    ASSERT_EQ(100, gat->expire());
+    ASSERT_TRUE(gat->cas());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("flush_all 10 noreply\r\n", consumed));
+    ASSERT_TRUE(parser.NoReply());
+    auto flush = parser.Build(body_size);
+    ASSERT_EQ(10, reinterpret_cast<Execute::FlushAll *>(flush.get())->delay());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("flush_all\r\n", consumed));
+    ASSERT_EQ(0, reinterpret_cast<Execute::FlushAll *>(parser.Build(slot, body_size))->delay());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("replace key 0 0 3\r\n", consumed));
+    ASSERT_TRUE(parser.HasBody());
+    ASSERT_TRUE(parser.Build(body_size));
+    ASSERT_EQ(3, body_size);
+}
+
+// Verify that keys point right into the input unless command line was split
+TEST(MemcachedParserTest, ZeroCopyKeys) {
+    Protocol::Parser parser;
+    std::string input = "get first second\r\n";
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse(input.data(), input.size(), consumed));
+    ASSERT_EQ(2, parser.Keys().size());
+    ASSERT_EQ(input.data() + 4, parser.Keys()[0].data);
+    ASSERT_TRUE(parser.Keys()[1] == "second");
+
+    parser.Reset();
+    ASSERT_FALSE(parser.Parse(input.data(), 8, consumed));
+    ASSERT_TRUE(parser.Parse(input.data() + 8, input.size() - 8, consumed));
+    ASSERT_EQ(2, parser.Keys().size());
+    ASSERT_TRUE(parser.Keys()[0] == "first");
+    ASSERT_TRUE(parser.Keys()[1] == "second");
+    ASSERT_TRUE(parser.Keys()[0].data < input.data() || parser.Keys()[0].data >= input.data() + input.size());
+}
+
+// Verify that commands built into the slot reuse the same objects
+TEST(MemcachedParserTest, CommandSlot) {
+    Protocol::Parser parser;
+    Protocol::CommandSlot slot;
+    ASSERT_TRUE(slot.Current() == nullptr);
+
+    size_t consumed = 0;
+    size_t value_size = 0;
+    ASSERT_TRUE(parser.Parse("set some_rather_long_key_name 3 0 5\r\n", consumed));
+    ASSERT_EQ(Protocol::Parser::Op::Set, parser.Code());
+    Execute::Command *first = parser.Build(slot, value_size);
+    ASSERT_EQ(first, slot.Current());
+    ASSERT_EQ(5, value_size);
+
+    Execute::Set *set = reinterpret_cast<Execute::Set *>(first);
+    ASSERT_EQ("some_rather_long_key_name", set->key());
+    ASSERT_EQ(3, set->flags());
+    const char *key_memory = set->key().data();
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("get a b\r\n", consumed));
+    ASSERT_EQ(Protocol::Parser::Op::Get, parser.Code());
+    Execute::Get *get = reinterpret_cast<Execute::Get *>(parser.Build(slot, value_size));
+    ASSERT_EQ(2, get->keys().size());
+    ASSERT_EQ("b", get->keys()[1]);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("set other_rather_long_key_name 0 0 1\r\n", consumed));
+    ASSERT_EQ(first, parser.Build(slot, value_size));
+    ASSERT_EQ("other_rather_long_key_name", set->key());
+    ASSERT_EQ(key_memory, set->key().data());
+}
+
+// Verify meta commands parsing and execution
+TEST(MemcachedParserTest, MetaCommands) {
+    Backend::SimpleLRU storage;
+    Protocol::Parser parser;
+    Protocol::CommandSlot slot;
+    size_t consumed = 0;
+    size_t value_size = 0;
+    std::string out;
+
+    ASSERT_TRUE(parser.Parse("ms foo 3 MS T10 F7 q Oxyz\r\nbar\r\n", consumed));
+    ASSERT_EQ(Protocol::Parser::Op::MetaSet, parser.Code());
+    ASSERT_EQ(27, consumed);
+    Execute::MetaSet *set = reinterpret_cast<Execute::MetaSet *>(parser.Build(slot, value_size));
+    ASSERT_EQ(3, value_size);
+    ASSERT_EQ("foo", set->key());
+    ASSERT_EQ(7, set->flags().client_flags);
+    ASSERT_EQ(10, set->flags().ttl);
+    ASSERT_EQ("xyz", set->flags().opaque);
+    ASSERT_TRUE(set->flags().has('q'));
+    ASSERT_FALSE(set->flags().has('k'));
+
+    // Quiet success has no answer at all
+    slot.Execute(storage, "bar", out);
+    ASSERT_EQ("", out);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("mg foo s v k\r\n", consumed));
+    parser.Build(slot, value_size);
+    slot.Execute(storage, "", out);
+    ASSERT_EQ("VA 3 s3 kfoo\r\nbar", out);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("md none O1\r\n", consumed));
+    parser.Build(slot, value_size);
+    slot.Execute(storage, "", out);
+    ASSERT_EQ("NF O1", out);
+
+    // Quiet delete answers nothing even if there was no such key
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("md none q\r\n", consumed));
+    parser.Build(slot, value_size);
+    slot.Execute(storage, "", out);
+    ASSERT_EQ("", out);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("mn\r\n", consumed));
+    parser.Build(slot, value_size);
+    slot.Execute(storage, "", out);
+    ASSERT_EQ("MN", out);
+
+    ASSERT_EQ("CLIENT_ERROR invalid flag", error_of("mg foo x\r\n"));
+    ASSERT_EQ("CLIENT_ERROR invalid mode switch", error_of("ms foo 1 MX\r\n"));
+    ASSERT_EQ("CLIENT_ERROR bad command line format", error_of("ms foo\r\n"));
+    ASSERT_EQ("CLIENT_ERROR bad command line format", error_of("mn foo\r\n"));
+}
@@ -0,0 +1,278 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <afina/execute/Command.h>
+
+#include <protocol/CommandSlot.h>
+#include <protocol/Parser.h>
+
+// Measures how many commands per second parser could get out of pipelined input. Current parser
+// is compared with the byte by byte state machine it replaced. Not registered as a test, run
+// runProtocolBenchmark manually on a quiet machine
+
+namespace {
+
+// State machine which was used by Protocol::Parser before, kept here as a baseline
+class LegacyParser {
+public:
+    LegacyParser() { Reset(); }
+
+    bool Parse(const char *input, const size_t size, size_t &parsed);
+
+    void Reset() {
+        state = State::sName;
+        name.clear();
+        keys.clear();
+        curKey.clear();
+        parse_complete = false;
+        flags = 0;
+        bytes = 0;
+        exprtime = 0;
+    }
+
+    uint32_t Bytes() const { return bytes; }
+
+private:
+    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+
+    State state;
+    std::string name;
+    std::vector<std::string> keys;
+    uint32_t flags;
+    int32_t exprtime;
+    uint32_t bytes;
+    bool negative;
+    std::string curKey;
+    bool parse_complete;
+};
+
+bool LegacyParser::Parse(const char *input, const size_t size, size_t &parsed) {
+    size_t pos;
+    parsed = 0;
+
+    for (pos = 0; pos < size && !parse_complete; pos++) {
+        char c = input[pos];
+
+        switch (state) {
+        case State::sName: {
+            if (c == ' ' || c == '\r') {
+                if (name == "set" || name == "add" || name == "append" || name == "prepend") {
+                    state = State::spKey;
+                } else if (name == "get" || name == "gets" || name == "scan") {
+                    state = State::sgKey;
+                } else if (name == "stats") {
+                    state = State::sLF;
+                    continue;
+                } else {
+                    throw std::runtime_error("Unknown command name: " + name);
+                }
+            } else {
+                name.push_back(c);
+            }
+            break;
+        }
+
+        case State::spKey: {
+            if (c == ' ') {
+                state = State::spFlags;
+                keys.push_back(curKey);
+            } else {
+                curKey.push_back(c);
+            }
+            break;
+        }
+
+        case State::sgKey: {
+            if (c == '\r') {
+                keys.push_back(curKey);
+
+                if (keys.size() == 0) {
+                    throw std::runtime_error("Client provides no key to retrive");
+                }
+
+                curKey.clear();
+                state = State::sLF;
+            } else if (c == ' ') {
+                state = State::sgKey;
+                keys.push_back(curKey);
+                curKey.clear();
+            } else {
+                curKey.push_back(c);
+            }
+            break;
+        }
+
+        case State::spFlags: {
+            if (c == ' ') {
+                negative = false;
+                state = State::spExprTimeStart;
+            } else if (c >= '0' && c <= '9') {
+                uint32_t f = (flags * 10) + (c - '0');
+                if (f < flags) {
+                    // Overflow
+                    throw std::runtime_error("Flags field overflow");
+                }
+                flags = f;
+            }
+            break;
+        }
+
+        case State::spExprTimeStart: {
+            if (c == '-') {
+                negative = true;
+                state = State::spExprTime;
+            } else if (c >= '0' && c <= '9') {
+                exprtime = (c - '0');
+                state = State::spExprTime;
+            }
+            break;
+        }
+
+        case State::spExprTime: {
+            if (c == ' ') {
+                state = State::spBytes;
+            } else if (c >= '0' && c <= '9') {
+                int32_t et = exprtime;
+                if (negative) {
+                    et -= (c - '0');
+                    if (et > exprtime) {
+                        throw std::runtime_error("Expire time field overflow");
+                    }
+                } else {
+                    et += (c - '0');
+                    if (et < exprtime) {
+                        throw std::runtime_error("Expire time field overflow");
+                    }
+                }
+                exprtime = et;
+            }
+            break;
+        }
+
+        case State::spBytes: {
+            if (c == '\r') {
+                state = State::sLF;
+            } else if (c >= '0' && c <= '9') {
+                uint32_t b = (bytes * 10) + (c - '0');
+                if (b < bytes) {
+                    // Overflow
+                    throw std::runtime_error("Bytes field overflow");
+                }
+                bytes = b;
+            }
+            break;
+        }
+
+        case State::sLF: {
+            if (c == '\n') {
+                parse_complete = true;
+            } else {
+                std::stringstream err;
+                err << "Invalid char " << (int)c << " at position " << (parsed + pos) << ", \\n expected";
+                throw std::runtime_error(err.str());
+            }
+            break;
+        }
+
+        default:
+            throw std::runtime_error("Unknown state");
+        }
+    }
+
+    parsed += pos;
+    return parse_complete;
+}
+
+
+// Pipelined mix of retrieval and storage commands, values are included
+std::string make_input(std::size_t commands) {
+    std::string input;
+    for (std::size_t i = 0; i < commands; i++) {
+        std::string key = "user:session:" + std::to_string(i * 7919 % 100000);
+        switch (i % 4) {
+        case 0:
+            input += "set " + key + " 0 0 16\r\n0123456789abcdef\r\n";
+            break;
+        case 1:
+            input += "get " + key + " " + key + ":profile " + key + ":settings\r\n";
+            break;
+        default:
+            input += "get " + key + "\r\n";
+            break;
+        }
+    }
+    return input;
+}
+
+// Feeds input into parser by chunks of the given size, the way network layer does
+template <typename P, typename B> std::size_t run(const std::string &input, std::size_t chunk, B body_size) {
+    P parser;
+    std::size_t commands = 0;
+    std::size_t body = 0;
+    for (std::size_t offset = 0; offset < input.size();) {
+        std::size_t size = std::min(chunk, input.size() - offset);
+        const char *data = input.data() + offset;
+        offset += size;
+
+        while (size > 0) {
+            if (body > 0) {
+                std::size_t skip = std::min(body, size);
+                body -= skip;
+                data += skip;
+                size -= skip;
+                continue;
+            }
+
+            std::size_t parsed = 0;
+            if (parser.Parse(data, size, parsed)) {
+                body = body_size(parser);
+                body = body > 0 ? body + 2 : 0;
+                commands++;
+                parser.Reset();
+            }
+            data += parsed;
+            size -= parsed;
+        }
+    }
+    return commands;
+}
+
+template <typename P, typename B>
+void bench(const char *title, const std::string &input, std::size_t chunk, std::size_t expected, B body_size) {
+    const int rounds = 20;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        if (run<P>(input, chunk, body_size) != expected) {
+            throw std::runtime_error("Parser lost commands");
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << title << ", chunk " << chunk << ": " << static_cast<uint64_t>(expected * rounds / elapsed.count())
+              << " commands/sec" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    const std::size_t commands = 200000;
+    std::string input = make_input(commands);
+
+    auto legacy_body = [](const LegacyParser &p) -> std::size_t { return p.Bytes(); };
+    Afina::Protocol::CommandSlot slot;
+    auto parser_body = [&slot](const Afina::Protocol::Parser &p) -> std::size_t {
+        std::size_t body_size = 0;
+        p.Build(slot, body_size);
+        return body_size;
+    };
+
+    for (std::size_t chunk : {std::size_t(4096), std::size_t(64 * 1024)}) {
+        bench<LegacyParser>("legacy", input, chunk, commands, legacy_body);
+        bench<Afina::Protocol::Parser>("parser", input, chunk, commands, parser_body);
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <protocol/RespParser.h>
+#include <storage/SimpleLRU.h>
+
+using namespace Afina;
+using Protocol::RespParser;
+
+// Encodes request as an array of bulk strings
+static std::string request(const std::vector<std::string> &args) {
+    std::string out = "*" + std::to_string(args.size()) + "\r\n";
+    for (auto &arg : args) {
+        out += "$" + std::to_string(arg.size()) + "\r\n" + arg + "\r\n";
+    }
+    return out;
+}
+
+// Parses and executes all requests of the input, pushing it by the given pieces
+static std::string run(RespParser &parser, Storage &storage, const std::string &input, size_t piece = 0) {
+    std::string out;
+    if (piece == 0) {
+        piece = input.size();
+    }
+
+    for (size_t offset = 0; offset < input.size();) {
+        size_t size = std::min(piece, input.size() - offset);
+        while (size > 0) {
+            size_t parsed = 0;
+            if (parser.Parse(input.data() + offset, size, parsed)) {
+                parser.Execute(storage, out);
+                parser.Reset();
+            }
+            offset += parsed;
+            size -= parsed;
+        }
+    }
+    return out;
+}
+
+TEST(RespParserTest, SetGet) {
+    Backend::SimpleLRU storage;
+    RespParser parser;
+
+    std::string input = request({"SET", "key", "value"}) + request({"get", "key"}) + request({"GET", "none"}) +
+                        request({"MGET", "key", "none"}) + request({"DEL", "key", "none"}) + request({"GET", "key"});
+    EXPECT_EQ("+OK\r\n$5\r\nvalue\r\n$-1\r\n*2\r\n$5\r\nvalue\r\n$-1\r\n:1\r\n$-1\r\n", run(parser, storage, input));
+}
+
+TEST(RespParserTest, SplitInput) {
+    Backend::SimpleLRU storage(64 * 1024);
+    RespParser parser;
+
+    // Value is binary safe and arrives by pieces of various size
+    std::string value(10000, 'x');
+    value[100] = '\r';
+    value[101] = '\n';
+    std::string input = request({"SET", "key", value}) + request({"GET", "key"}) + "PING\r\n";
+    std::string expected = "+OK\r\n$10000\r\n" + value + "\r\n+PONG\r\n";
+    for (size_t piece : {1, 7, 4096}) {
+        EXPECT_EQ(expected, run(parser, storage, input, piece));
+    }
+}
+
+TEST(RespParserTest, Options) {
+    Backend::SimpleLRU storage;
+    RespParser parser;
+
+    EXPECT_EQ("$-1\r\n+OK\r\n$-1\r\n", run(parser, storage,
+                                           request({"SET", "a", "1", "XX"}) + request({"SET", "a", "1", "NX"}) +
+                                               request({"SET", "a", "2", "NX"})));
+
+    int64_t deadline = 0;
+    EXPECT_EQ("+OK\r\n", run(parser, storage, request({"SET", "a", "1", "EX", "100"})));
+    EXPECT_TRUE(storage.GetExpire("a", deadline));
+    EXPECT_NE(0, deadline);
+
+    EXPECT_EQ(":1\r\n:0\r\n:1\r\n$-1\r\n",
+              run(parser, storage,
+                  request({"EXPIRE", "a", "10"}) + request({"EXPIRE", "b", "10"}) + request({"EXPIRE", "a", "0"}) +
+                      request({"GET", "a"})));
+
+    EXPECT_EQ("-ERR syntax error\r\n-ERR invalid expire time in 'set' command\r\n",
+              run(parser, storage, request({"SET", "a", "1", "NX", "XX"}) + request({"SET", "a", "1", "PX", "0"})));
+}
+
+TEST(RespParserTest, Incr) {
+    Backend::SimpleLRU storage;
+    RespParser parser;
+
+    EXPECT_EQ(":1\r\n:2\r\n", run(parser, storage, request({"INCR", "n"}) + request({"incr", "n"})));
+
+    // TTL is kept
+    int64_t deadline = 0;
+    EXPECT_TRUE(storage.Expire("n", 4000000000));
+    EXPECT_EQ(":3\r\n", run(parser, storage, request({"INCR", "n"})));
+    EXPECT_TRUE(storage.GetExpire("n", deadline));
+    EXPECT_EQ(4000000000, deadline);
+
+    EXPECT_TRUE(storage.Put("s", "abc"));
+    EXPECT_TRUE(storage.Put("m", "9223372036854775807"));
+    EXPECT_EQ("-ERR value is not an integer or out of range\r\n-ERR increment or decrement would overflow\r\n",
+              run(parser, storage, request({"INCR", "s"}) + request({"INCR", "m"})));
+}
+
+TEST(RespParserTest, Errors) {
+    Backend::SimpleLRU storage;
+    RespParser parser;
+
+    EXPECT_EQ("-ERR unknown command 'FOO'\r\n-ERR wrong number of arguments for 'get' command\r\n",
+              run(parser, storage, request({"FOO"}) + request({"get", "a", "b"})));
+
+    // Empty requests are ignored
+    EXPECT_EQ("+PONG\r\n", run(parser, storage, "\r\n*0\r\nping\r\n"));
+
+    for (std::string bad : {"*x\r\n", "*1\r\n+OK\r\n", "*1\r\n$3\r\nabcd\r\n", "*1\n$1\r\na\r\n"}) {
+        RespParser fresh;
+        EXPECT_THROW(run(fresh, storage, bad), std::runtime_error) << bad;
+    }
+}
+
+TEST(RespParserTest, Quit) {
+    Backend::SimpleLRU storage;
+    RespParser parser;
+
+    EXPECT_EQ("+OK\r\n", run(parser, storage, request({"QUIT"})));
+    EXPECT_TRUE(parser.Quit());
+}
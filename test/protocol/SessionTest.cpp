@@ -0,0 +1,295 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <protocol/BinaryParser.h>
+#include <protocol/Session.h>
+#include <storage/SimpleLRU.h>
+
+using namespace Afina;
+using Protocol::Session;
+
+// Takes all queued output of the session without any socket
+static std::string drain(Session &session) {
+    std::string out;
+    struct iovec iov[Session::kMaxIov];
+    while (session.HasOutput()) {
+        std::size_t n = session.Gather(iov, Session::kMaxIov);
+        std::size_t size = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            out.append(static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+            size += iov[i].iov_len;
+        }
+        session.Consume(size);
+    }
+    return out;
+}
+
+static bool process(Session &session, const std::string &input) {
+    return session.Process(input.data(), input.size());
+}
+
+TEST(SessionTest, Pipelined) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+
+    ASSERT_TRUE(process(session, "set a 0 0 1\r\nA\r\nset b 0 0 2\r\nBB\r\nget a b\r\nget c\r\n"));
+    EXPECT_EQ(std::string("STORED\r\nSTORED\r\nVALUE a 0 1\r\nA\r\nVALUE b 0 2\r\nBB\r\nEND\r\nEND\r\n"),
+              drain(session));
+    EXPECT_FALSE(session.HasOutput());
+    EXPECT_EQ(0, session.OutputSize());
+}
+
+TEST(SessionTest, SplitInput) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+
+    std::string input = "set key 0 0 5\r\nvalue\r\nget key\r\n";
+    for (char c : input) {
+        ASSERT_TRUE(session.Process(&c, 1));
+    }
+    EXPECT_EQ(std::string("STORED\r\nVALUE key 0 5\r\nvalue\r\nEND\r\n"), drain(session));
+}
+
+TEST(SessionTest, EmptyBody) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+
+    // Empty data block still has its \r\n which must not be taken for the next command
+    ASSERT_TRUE(process(session, "set key 0 0 0\r\n\r\nget key\r\nms m 0\r\n\r\nmn\r\n"));
+    EXPECT_EQ(std::string("STORED\r\nVALUE key 0 0\r\n\r\nEND\r\nHD\r\nMN\r\n"), drain(session));
+}
+
+TEST(SessionTest, QuietCommands) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+
+    ASSERT_TRUE(process(session, "ms a 1 q\r\nA\r\nmg b v q\r\nmn\r\n"));
+    EXPECT_EQ(std::string("MN\r\n"), drain(session));
+}
+
+TEST(SessionTest, LargeResponse) {
+    Session session(std::make_shared<Backend::SimpleLRU>(4 * Session::kChunkSize));
+
+    std::string value(2 * Session::kChunkSize, 'x');
+    std::string input = "set big 0 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+    ASSERT_TRUE(process(session, input + "get big\r\nmn\r\n"));
+
+    // Value keeps its own buffer, small responses around it are coalesced
+    struct iovec iov[Session::kMaxIov];
+    EXPECT_EQ(3, session.Gather(iov, Session::kMaxIov));
+
+    // Partial write continues right where it stopped
+    std::string expected =
+        "STORED\r\nVALUE big 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\nEND\r\n" + "MN\r\n";
+    EXPECT_EQ(expected.size(), session.OutputSize());
+    session.Consume(3);
+    EXPECT_EQ(expected.substr(3), drain(session));
+}
+
+TEST(SessionTest, GatherValues) {
+    Session session(std::make_shared<Backend::SimpleLRU>(4 * Session::kChunkSize));
+
+    std::string a(Session::kMinZeroCopy, 'a'), b(Session::kMinZeroCopy - 1, 'b'), c(Session::kMinZeroCopy + 1, 'c');
+    std::string input;
+    for (auto *value : {&a, &b, &c}) {
+        input += "set " + value->substr(0, 1) + " 0 0 " + std::to_string(value->size()) + "\r\n" + *value + "\r\n";
+    }
+    ASSERT_TRUE(process(session, input));
+    drain(session);
+
+    // Values a and c are entries of their own, the small one is copied along with item lines
+    ASSERT_TRUE(process(session, "gets a b c\r\n"));
+    struct iovec iov[Session::kMaxIov];
+    ASSERT_EQ(5, session.Gather(iov, Session::kMaxIov));
+    EXPECT_EQ(a.size(), iov[1].iov_len);
+    EXPECT_EQ(c.size(), iov[3].iov_len);
+
+    std::string expected = "VALUE a 0 " + std::to_string(a.size()) + " 0\r\n" + a + "\r\n" + "VALUE b 0 " +
+                           std::to_string(b.size()) + " 0\r\n" + b + "\r\n" + "VALUE c 0 " +
+                           std::to_string(c.size()) + " 0\r\n" + c + "\r\nEND\r\n";
+    EXPECT_EQ(expected.size(), session.OutputSize());
+    EXPECT_EQ(expected, drain(session));
+
+    // Chunks are reused, but sealed one doesn't take anything more
+    ASSERT_TRUE(process(session, "get c\r\nget a\r\n"));
+    EXPECT_EQ("VALUE c 0 " + std::to_string(c.size()) + "\r\n" + c + "\r\nEND\r\nVALUE a 0 " +
+                  std::to_string(a.size()) + "\r\n" + a + "\r\nEND\r\n",
+              drain(session));
+}
+
+TEST(SessionTest, DeferSlow) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+    session.SetDeferSlow(true);
+
+    std::string keys;
+    for (std::size_t i = 0; i < Session::kSlowKeys; i++) {
+        keys += " k" + std::to_string(i);
+    }
+
+    // Commands up to the slow one are answered, the rest waits along with it
+    ASSERT_TRUE(process(session, "set k1 0 0 1\r\nA\r\nget" + keys + "\r\nget k1\r\n"));
+    EXPECT_TRUE(session.Deferred());
+    EXPECT_EQ("STORED\r\n", drain(session));
+
+    ASSERT_TRUE(process(session, "scan 0 100\r\nget k1\r\n"));
+    EXPECT_TRUE(session.Deferred());
+    EXPECT_FALSE(session.HasOutput());
+
+    // Another slow command in the backlog is executed right away
+    session.Resume();
+    EXPECT_FALSE(session.Deferred());
+    EXPECT_EQ("VALUE k1 0 1\r\nA\r\nEND\r\nVALUE k1 0 1\r\nA\r\nEND\r\n"
+              "KEY k1\r\nCURSOR 0\r\nEND\r\nVALUE k1 0 1\r\nA\r\nEND\r\n",
+              drain(session));
+}
+
+TEST(SessionTest, Write) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+
+    int sockets[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+    ASSERT_TRUE(process(session, "set a 0 0 1\r\nA\r\nget a\r\n"));
+    EXPECT_TRUE(session.Write(sockets[0]));
+    EXPECT_FALSE(session.HasOutput());
+
+    char buffer[128];
+    ssize_t n = read(sockets[1], buffer, sizeof(buffer));
+    EXPECT_EQ(std::string("STORED\r\nVALUE a 0 1\r\nA\r\nEND\r\n"), std::string(buffer, n > 0 ? n : 0));
+
+    close(sockets[0]);
+    close(sockets[1]);
+}
+
+TEST(SessionTest, Seal) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+    ASSERT_TRUE(process(session, "set a 0 0 1\r\nA\r\n"));
+
+    // Output being sent stays where it is no matter how much is queued after it
+    struct iovec iov[Session::kMaxIov];
+    ASSERT_EQ(1, session.Gather(iov, Session::kMaxIov));
+    session.Seal();
+    std::string gets;
+    std::string values;
+    for (int i = 0; i < 10000; i++) {
+        gets.append("get a\r\n");
+        values.append("VALUE a 0 1\r\nA\r\nEND\r\n");
+    }
+    ASSERT_TRUE(process(session, gets));
+    EXPECT_EQ("STORED\r\n", std::string(static_cast<const char *>(iov[0].iov_base), iov[0].iov_len));
+
+    session.Consume(iov[0].iov_len);
+    EXPECT_EQ(values, drain(session));
+}
+
+TEST(SessionTest, BinaryQuit) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+
+    char noop[Protocol::BinaryParser::kHeaderSize] = {};
+    noop[0] = static_cast<char>(Protocol::BinaryParser::kRequestMagic);
+    noop[1] = Protocol::BinaryParser::oNoop;
+    char quit[Protocol::BinaryParser::kHeaderSize] = {};
+    quit[0] = static_cast<char>(Protocol::BinaryParser::kRequestMagic);
+    quit[1] = Protocol::BinaryParser::oQuitQ;
+
+    std::string input = std::string(noop, sizeof(noop)) + std::string(quit, sizeof(quit));
+    EXPECT_FALSE(process(session, input));
+    EXPECT_EQ(Protocol::BinaryParser::kHeaderSize, drain(session).size());
+}
+
+TEST(SessionTest, BinaryQuiet) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+
+    char getq[Protocol::BinaryParser::kHeaderSize + 1] = {};
+    getq[0] = static_cast<char>(Protocol::BinaryParser::kRequestMagic);
+    getq[1] = Protocol::BinaryParser::oGetQ;
+    getq[3] = 1;
+    getq[11] = 1;
+    getq[Protocol::BinaryParser::kHeaderSize] = 'k';
+
+    // Miss of the quiet get has no response at all
+    EXPECT_TRUE(process(session, std::string(getq, sizeof(getq))));
+    EXPECT_FALSE(session.HasOutput());
+
+    // Responses around quiet commands still share one chunk
+    char noop[Protocol::BinaryParser::kHeaderSize] = {};
+    noop[0] = static_cast<char>(Protocol::BinaryParser::kRequestMagic);
+    noop[1] = Protocol::BinaryParser::oNoop;
+    std::string input = std::string(noop, sizeof(noop)) + std::string(getq, sizeof(getq));
+    EXPECT_TRUE(process(session, input + input));
+
+    struct iovec iov[Session::kMaxIov];
+    ASSERT_EQ(1, session.Gather(iov, Session::kMaxIov));
+    EXPECT_EQ(2 * Protocol::BinaryParser::kHeaderSize, iov[0].iov_len);
+}
+
+TEST(SessionTest, NoReply) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+
+    ASSERT_TRUE(process(session, "set a 0 0 1 noreply\r\nA\r\nadd a 0 0 1 noreply\r\nB\r\nappend a 0 0 1 noreply\r\nC\r\n"
+                                 "get a\r\n"));
+    EXPECT_EQ(std::string("VALUE a 0 2\r\nAC\r\nEND\r\n"), drain(session));
+}
+
+TEST(SessionTest, CommandSet) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+
+    ASSERT_TRUE(process(session, "replace a 0 0 1\r\nA\r\nset a 0 0 1\r\nA\r\nreplace a 0 0 1\r\nB\r\n"
+                                 "prepend a 0 0 1\r\nC\r\nprepend b 0 0 1\r\nC\r\ngets a\r\n"
+                                 "delete a\r\ndelete a\r\nget a\r\n"));
+    EXPECT_EQ(std::string("NOT_STORED\r\nSTORED\r\nSTORED\r\nSTORED\r\nNOT_STORED\r\nVALUE a 0 2 0\r\nCB\r\nEND\r\n"
+                          "DELETED\r\nNOT_FOUND\r\nEND\r\n"),
+              drain(session));
+
+    // Negative exptime expires item right away
+    ASSERT_TRUE(process(session, "set a 0 0 1\r\nA\r\ntouch a 100\r\nmg a t\r\ntouch b 100\r\n"
+                                 "gat 0 a b\r\nmg a t\r\ngats -1 a\r\nget a\r\n"));
+    EXPECT_EQ(std::string("STORED\r\nTOUCHED\r\nHD t100\r\nNOT_FOUND\r\nVALUE a 0 1\r\nA\r\nEND\r\nHD t-1\r\n"
+                          "VALUE a 0 1 0\r\nA\r\nEND\r\nEND\r\n"),
+              drain(session));
+
+    ASSERT_TRUE(process(session, "set a 0 -1 1\r\nA\r\nset b 0 0 1\r\nB\r\nget a\r\nflush_all 100\r\nget b\r\n"
+                                 "flush_all\r\nget b\r\n"));
+    EXPECT_EQ(std::string("STORED\r\nSTORED\r\nEND\r\nOK\r\nVALUE b 0 1\r\nB\r\nEND\r\nOK\r\nEND\r\n"),
+              drain(session));
+}
+
+TEST(SessionTest, Stats) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+
+    ASSERT_TRUE(process(session, "set a 0 0 1\r\nA\r\nstats\r\n"));
+    std::string out = drain(session);
+    EXPECT_NE(std::string::npos, out.find("\r\nSTAT curr_connections "));
+    EXPECT_NE(std::string::npos, out.find("\r\nSTAT bytes_read "));
+    EXPECT_NE(std::string::npos, out.find("\r\nSTAT curr_items 1\r\n"));
+    EXPECT_EQ(0, out.compare(out.size() - 5, 5, "END\r\n"));
+
+    ASSERT_TRUE(process(session, "stats items\r\nstats bogus\r\nstats items slabs\r\n"));
+    EXPECT_EQ(std::string("STAT items:1:number 1\r\nSTAT items:1:evicted 0\r\nSTAT items:1:reclaimed 0\r\nEND\r\n"
+                          "CLIENT_ERROR bad command line format\r\nCLIENT_ERROR bad command line format\r\n"),
+              drain(session));
+}
+
+TEST(SessionTest, Resp) {
+    Session session(std::make_shared<Backend::SimpleLRU>(), Network::ProtocolType::Resp);
+
+    // Pipelined requests, the first byte doesn't pick protocol here
+    ASSERT_TRUE(process(session, "*3\r\n$3\r\nSET\r\n$1\r\na\r\n$1\r\nA\r\n*2\r\n$3\r\nGET\r\n$1\r\na\r\n"
+                                 "\x80\r\n"));
+    EXPECT_EQ(std::string("+OK\r\n$1\r\nA\r\n-ERR unknown command '\x80'\r\n"), drain(session));
+
+    ASSERT_FALSE(process(session, "QUIT\r\nPING\r\n"));
+    EXPECT_EQ(std::string("+OK\r\n"), drain(session));
+}
+
+TEST(SessionTest, Errors) {
+    Session session(std::make_shared<Backend::SimpleLRU>());
+
+    // Each bad line is answered and the next one is served as usual. Too long data block is
+    // cut at the declared size, so the rest of it is a line on its own
+    ASSERT_TRUE(process(session, "bogus\r\nset a 0 0 x\r\nset a 0 0 1\r\nAB\r\nset a 0 0 1\r\nA\r\nget a\r\n"));
+    EXPECT_EQ(std::string("ERROR\r\nCLIENT_ERROR invalid data length\r\nCLIENT_ERROR bad data chunk\r\n"
+                          "CLIENT_ERROR bad command line termination\r\nSTORED\r\nVALUE a 0 1\r\nA\r\nEND\r\n"),
+              drain(session));
+}
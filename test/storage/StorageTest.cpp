@@ -2,6 +2,9 @@
 #include <iomanip>
 #include <iostream>
 #include <set>
+#include <chrono>
+#include <ctime>
+#include <thread>
 #include <vector>
 
 #include <afina/execute/Add.h>
@@ -11,6 +14,8 @@
 #include <afina/execute/Set.h>
 
 #include "storage/SimpleLRU.h"
+#include "storage/StripedLRU.h"
+#include "storage/TieredLRU.h"
 
 using namespace Afina::Backend;
 using namespace Afina::Execute;
@@ -195,3 +200,533 @@ TEST(StorageTest, MaxTest) {
         EXPECT_FALSE(storage.Get(key, res));
     }
 }
+
+// Walks whole storage page by page, returns number of calls made
+static size_t scan_all(Afina::Storage &storage, size_t count, std::vector<std::string> &keys) {
+    size_t calls = 0;
+    std::string cursor;
+    do {
+        EXPECT_TRUE(storage.Scan(cursor, count, keys));
+        calls++;
+    } while (!cursor.empty());
+    return calls;
+}
+
+TEST(StorageTest, ScanAll) {
+    SimpleLRU storage;
+    for (long i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "val"));
+    }
+
+    std::vector<std::string> keys;
+    EXPECT_EQ(4, scan_all(storage, 3, keys));
+    EXPECT_EQ(10, keys.size());
+    EXPECT_EQ(10, std::set<std::string>(keys.begin(), keys.end()).size());
+}
+
+TEST(StorageTest, ScanConcurrentChanges) {
+    SimpleLRU storage;
+    for (long i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "val"));
+    }
+
+    std::string cursor;
+    std::vector<std::string> keys;
+    EXPECT_TRUE(storage.Scan(cursor, 5, keys));
+    EXPECT_FALSE(cursor.empty());
+
+    // Changes between pages doesn't affect keys that were not touched
+    EXPECT_TRUE(storage.Delete(keys.back()));
+    EXPECT_TRUE(storage.Put("KEY00", "val"));
+    EXPECT_TRUE(storage.Put("KEY99", "val"));
+    EXPECT_TRUE(storage.Delete("KEY9"));
+    while (!cursor.empty()) {
+        EXPECT_TRUE(storage.Scan(cursor, 5, keys));
+    }
+
+    std::set<std::string> seen(keys.begin(), keys.end());
+    EXPECT_EQ(keys.size(), seen.size());
+    for (long i = 0; i < 9; ++i) {
+        EXPECT_TRUE(seen.count("KEY" + std::to_string(i)));
+    }
+    EXPECT_TRUE(seen.count("KEY99"));
+}
+
+TEST(StorageTest, ScanAfterFlush) {
+    SimpleLRU storage(64 * 1024);
+    for (long i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "val"));
+    }
+    storage.Flush(0);
+    EXPECT_TRUE(storage.Put("ZKEY", "val"));
+
+    // Flushed entries are still in the index, each page visits only a few of them
+    std::string cursor;
+    std::vector<std::string> keys;
+    EXPECT_TRUE(storage.Scan(cursor, 10, keys));
+    EXPECT_TRUE(keys.empty());
+    EXPECT_FALSE(cursor.empty());
+
+    keys.clear();
+    EXPECT_EQ(26, scan_all(storage, 10, keys));
+    ASSERT_EQ(1, keys.size());
+    EXPECT_EQ("ZKEY", keys[0]);
+}
+
+TEST(StorageTest, ScanBadCursor) {
+    SimpleLRU storage;
+    std::string cursor = "KEY1";
+    std::vector<std::string> keys;
+    EXPECT_FALSE(storage.Scan(cursor, 5, keys));
+}
+
+TEST(StorageTest, StripedScan) {
+    auto storage = StripedLRU::BuildStripedLRU(4 * 1024 * 1024, 4);
+    for (long i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(storage->Put("KEY" + std::to_string(i), "val"));
+    }
+
+    std::vector<std::string> keys;
+    scan_all(*storage, 7, keys);
+    EXPECT_EQ(1000, keys.size());
+    EXPECT_EQ(1000, std::set<std::string>(keys.begin(), keys.end()).size());
+
+    std::string cursor = "4:>KEY1";
+    EXPECT_FALSE(storage->Scan(cursor, 5, keys));
+    cursor = "99999999999999999999999:x";
+    EXPECT_FALSE(storage->Scan(cursor, 5, keys));
+    cursor = ":>KEY1";
+    EXPECT_FALSE(storage->Scan(cursor, 5, keys));
+    cursor = "-1:>KEY1";
+    EXPECT_FALSE(storage->Scan(cursor, 5, keys));
+}
+
+static std::string find_stat(Afina::Storage &storage, const std::string &name) {
+    std::vector<std::pair<std::string, std::string>> stats;
+    storage.Stats(stats);
+    for (auto &stat : stats) {
+        if (stat.first == name) {
+            return stat.second;
+        }
+    }
+    return "";
+}
+
+TEST(StorageTest, Counters) {
+    SimpleLRU storage(20);
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY3", value));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    EXPECT_EQ("2", find_stat(storage, "cmd_get"));
+    EXPECT_EQ("1", find_stat(storage, "get_hits"));
+    EXPECT_EQ("1", find_stat(storage, "get_misses"));
+    EXPECT_EQ("3", find_stat(storage, "cmd_set"));
+    EXPECT_EQ("1", find_stat(storage, "evictions"));
+    EXPECT_EQ("0", find_stat(storage, "expirations"));
+    EXPECT_EQ("2", find_stat(storage, "curr_items"));
+    EXPECT_EQ("3", find_stat(storage, "total_items"));
+    EXPECT_EQ("16", find_stat(storage, "bytes"));
+    EXPECT_EQ("20", find_stat(storage, "limit_maxbytes"));
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_EQ("1", find_stat(storage, "curr_items"));
+    EXPECT_EQ("8", find_stat(storage, "bytes"));
+}
+
+TEST(StorageTest, StripedCounters) {
+    auto storage = StripedLRU::BuildStripedLRU(4 * 1024 * 1024, 4);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&storage, t]() {
+            std::string value;
+            for (int i = 0; i < 1000; ++i) {
+                std::string key = "KEY" + std::to_string(t * 1000 + i);
+                EXPECT_TRUE(storage->Put(key, "val"));
+                EXPECT_TRUE(storage->Get(key, value));
+                EXPECT_FALSE(storage->Get("NONE" + key, value));
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    EXPECT_EQ("8000", find_stat(*storage, "cmd_get"));
+    EXPECT_EQ("4000", find_stat(*storage, "get_hits"));
+    EXPECT_EQ("4000", find_stat(*storage, "get_misses"));
+    EXPECT_EQ("4000", find_stat(*storage, "cmd_set"));
+    EXPECT_EQ("4000", find_stat(*storage, "curr_items"));
+    EXPECT_EQ(std::to_string(4 * 1024 * 1024), find_stat(*storage, "limit_maxbytes"));
+}
+
+TEST(StorageTest, StripedHotKeys) {
+    auto storage = StripedLRU::BuildStripedLRU(4 * 1024 * 1024, 4);
+    for (long i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage->Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+    }
+
+    std::string value;
+    for (long i = 0; i < 100000; ++i) {
+        EXPECT_TRUE(storage->Get("HOT", value) || storage->Put("HOT", "hotval"));
+        EXPECT_TRUE(storage->Get("KEY" + std::to_string(i % 100), value));
+    }
+    EXPECT_EQ("HOT", find_stat(*storage, "hot_keys:0:key"));
+    EXPECT_NE("0", find_stat(*storage, "hot_replica_hits"));
+
+    // Writes from other threads invalidate replicated value
+    std::thread writer([&storage]() { EXPECT_TRUE(storage->Set("HOT", "newval")); });
+    writer.join();
+    EXPECT_TRUE(storage->Get("HOT", value));
+    EXPECT_EQ("newval", value);
+
+    std::thread deleter([&storage]() { EXPECT_TRUE(storage->Delete("HOT")); });
+    deleter.join();
+    EXPECT_FALSE(storage->Get("HOT", value));
+}
+
+TEST(StorageTest, TieredDemoteAndPromote) {
+    TieredLRU storage(64 * 1024, "/tmp", 16 * 1024 * 1024, 1024, 256 * 1024);
+    storage.Start();
+
+    for (long i = 0; i < 200; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(4000, 'a' + i % 26)));
+    }
+    EXPECT_NE("0", find_stat(storage, "tier_demotions"));
+
+    std::string value;
+    for (long i = 0; i < 200; ++i) {
+        EXPECT_TRUE(storage.Get("KEY" + std::to_string(i), value));
+        EXPECT_EQ(std::string(4000, 'a' + i % 26), value);
+    }
+    EXPECT_NE("0", find_stat(storage, "tier_promotions"));
+
+    // Demoted keys are still visible for the rest of operations
+    EXPECT_FALSE(storage.PutIfAbsent("KEY0", "val"));
+    EXPECT_TRUE(storage.Set("KEY1", "val"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val", value);
+    EXPECT_TRUE(storage.Delete("KEY2"));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+
+    std::vector<std::string> keys;
+    scan_all(storage, 7, keys);
+    EXPECT_EQ(199, keys.size());
+    EXPECT_EQ(199, std::set<std::string>(keys.begin(), keys.end()).size());
+    storage.Stop();
+}
+
+TEST(StorageTest, TieredCompaction) {
+    TieredLRU storage(16 * 1024, "/tmp", 1024 * 1024, 1024, 64 * 1024);
+    storage.Start();
+
+    // Keep overwriting the same keys, so that old segments become garbage
+    for (long round = 0; round < 20; ++round) {
+        for (long i = 0; i < 20; ++i) {
+            EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(2000, 'a' + round)));
+        }
+    }
+
+    for (int i = 0; i < 100 && find_stat(storage, "tier_compactions") == "0"; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_NE("0", find_stat(storage, "tier_compactions"));
+
+    std::string value;
+    for (long i = 0; i < 20; ++i) {
+        EXPECT_TRUE(storage.Get("KEY" + std::to_string(i), value));
+        EXPECT_EQ(std::string(2000, 'a' + 19), value);
+    }
+    storage.Stop();
+}
+
+TEST(StorageTest, Expiration) {
+    SimpleLRU storage(1024);
+    std::string value;
+    int64_t deadline = 0;
+    EXPECT_FALSE(storage.Expire("KEY1", 100));
+    EXPECT_FALSE(storage.GetExpire("KEY1", deadline));
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.GetExpire("KEY1", deadline));
+    EXPECT_EQ(0, deadline);
+
+    // Deadline far in the future, then in the past
+    EXPECT_TRUE(storage.Expire("KEY1", std::time(nullptr) + 1000));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Expire("KEY1", 1));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_EQ("1", find_stat(storage, "expirations"));
+    EXPECT_EQ("0", find_stat(storage, "curr_items"));
+
+    // Write makes association to live forever again
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Expire("KEY2", 1));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val3"));
+    EXPECT_TRUE(storage.GetExpire("KEY2", deadline));
+    EXPECT_EQ(0, deadline);
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("val3", value);
+
+    // Deadline is stored along with the value, append and prepend keep it
+    int64_t future = std::time(nullptr) + 1000;
+    EXPECT_TRUE(storage.Put("KEY2", "val2", future));
+    EXPECT_TRUE(storage.Append("KEY2", "+"));
+    EXPECT_TRUE(storage.Prepend("KEY2", "-"));
+    EXPECT_TRUE(storage.GetExpire("KEY2", deadline));
+    EXPECT_EQ(future, deadline);
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("-val2+", value);
+    EXPECT_FALSE(storage.Append("NONE", "+"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY5", "val5", 1));
+    EXPECT_FALSE(storage.Get("KEY5", value));
+
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+    storage.Flush(0);
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_FALSE(storage.Get("KEY3", value));
+    EXPECT_EQ("0", find_stat(storage, "curr_items"));
+    EXPECT_EQ("0", find_stat(storage, "bytes"));
+    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+}
+
+TEST(StorageTest, StripedExpiration) {
+    auto storage = StripedLRU::BuildStripedLRU(4 * 1024 * 1024, 4);
+    std::string value;
+    EXPECT_TRUE(storage->Put("HOT", "hotval"));
+    for (long i = 0; i < 100000; ++i) {
+        EXPECT_TRUE(storage->Get("HOT", value));
+    }
+
+    // Replica must not outlive the association
+    EXPECT_TRUE(storage->Expire("HOT", 1));
+    EXPECT_FALSE(storage->Get("HOT", value));
+
+    EXPECT_TRUE(storage->Put("KEY", "val"));
+    storage->Flush(0);
+    EXPECT_FALSE(storage->Get("KEY", value));
+    EXPECT_EQ("0", find_stat(*storage, "curr_items"));
+}
+
+TEST(StorageTest, TieredExpiration) {
+    TieredLRU storage(64 * 1024, "/tmp", 16 * 1024 * 1024, 1024, 256 * 1024);
+    storage.Start();
+
+    int64_t deadline = std::time(nullptr) + 1000;
+    for (long i = 0; i < 200; ++i) {
+        std::string key = "KEY" + std::to_string(i);
+        EXPECT_TRUE(storage.Put(key, std::string(4000, 'a')));
+        EXPECT_TRUE(storage.Expire(key, i % 2 ? deadline : 0));
+    }
+    EXPECT_NE("0", find_stat(storage, "tier_demotions"));
+
+    // Demoted keys keep their deadlines and could be expired on disk
+    int64_t found = -1;
+    EXPECT_TRUE(storage.GetExpire("KEY1", found));
+    EXPECT_EQ(deadline, found);
+    EXPECT_TRUE(storage.Expire("KEY2", 1));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_NE("0", find_stat(storage, "expirations"));
+
+    // Promotion brings deadline back to memory
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_TRUE(storage.GetExpire("KEY3", found));
+    EXPECT_EQ(deadline, found);
+
+    // Flushed extents are not counted even before they are dropped
+    EXPECT_NE("0", find_stat(storage, "tier_disk_items"));
+    storage.Flush(0);
+    EXPECT_EQ("0", find_stat(storage, "tier_disk_items"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY199", value));
+    storage.Stop();
+}
+
+TEST(StorageTest, StripedConcurrentAppend) {
+    auto storage = StripedLRU::BuildStripedLRU(4 * 1024 * 1024, 4);
+    EXPECT_TRUE(storage->Put("KEY", ""));
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&storage]() {
+            for (int j = 0; j < 1000; ++j) {
+                EXPECT_TRUE(storage->Append("KEY", "x"));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // None of the appends is lost
+    std::string value;
+    EXPECT_TRUE(storage->Get("KEY", value));
+    EXPECT_EQ(4000, value.size());
+}
+
+TEST(StorageTest, TieredAppend) {
+    TieredLRU storage(64 * 1024, "/tmp", 16 * 1024 * 1024, 1024, 256 * 1024);
+    storage.Start();
+
+    int64_t deadline = std::time(nullptr) + 1000;
+    for (long i = 0; i < 200; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(4000, 'a'), deadline));
+    }
+    EXPECT_NE("0", find_stat(storage, "tier_demotions"));
+
+    // Demoted value is joined and brought back to memory along with its deadline
+    std::string value;
+    EXPECT_TRUE(storage.Append("KEY0", "b"));
+    EXPECT_TRUE(storage.Prepend("KEY1", "b"));
+    EXPECT_TRUE(storage.Get("KEY0", value));
+    EXPECT_EQ(std::string(4000, 'a') + "b", value);
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("b" + std::string(4000, 'a'), value);
+
+    int64_t found = 0;
+    EXPECT_TRUE(storage.GetExpire("KEY0", found));
+    EXPECT_EQ(deadline, found);
+    EXPECT_FALSE(storage.Append("NONE", "b"));
+    storage.Stop();
+}
+
+TEST(StorageTest, StripedConcurrentModify) {
+    auto storage = StripedLRU::BuildStripedLRU(4 * 1024 * 1024, 4);
+    auto increment = [](std::string &value, bool found) {
+        value = std::to_string(found ? std::stol(value) + 1 : 1);
+        return true;
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&storage, &increment]() {
+            for (int j = 0; j < 1000; ++j) {
+                EXPECT_TRUE(storage->Modify("KEY", increment));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // None of the increments is lost
+    std::string value;
+    EXPECT_TRUE(storage->Get("KEY", value));
+    EXPECT_EQ("4000", value);
+
+    // Refused update leaves value untouched
+    EXPECT_FALSE(storage->Modify("KEY", [](std::string &value, bool found) {
+        value = "refused";
+        return false;
+    }));
+    EXPECT_TRUE(storage->Get("KEY", value));
+    EXPECT_EQ("4000", value);
+}
+
+TEST(StorageTest, TieredModify) {
+    TieredLRU storage(64 * 1024, "/tmp", 16 * 1024 * 1024, 1024, 256 * 1024);
+    storage.Start();
+
+    int64_t deadline = std::time(nullptr) + 1000;
+    for (long i = 0; i < 200; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(4000, 'a'), deadline));
+    }
+    EXPECT_NE("0", find_stat(storage, "tier_demotions"));
+
+    // Demoted value is changed and brought back to memory along with its deadline
+    std::string value;
+    EXPECT_TRUE(storage.Modify("KEY0", [](std::string &value, bool found) {
+        EXPECT_TRUE(found);
+        value += "b";
+        return true;
+    }));
+    EXPECT_TRUE(storage.Get("KEY0", value));
+    EXPECT_EQ(std::string(4000, 'a') + "b", value);
+
+    int64_t found = 0;
+    EXPECT_TRUE(storage.GetExpire("KEY0", found));
+    EXPECT_EQ(deadline, found);
+
+    // Missing key comes empty and lives forever
+    EXPECT_TRUE(storage.Modify("NONE", [](std::string &value, bool found) {
+        EXPECT_FALSE(found);
+        EXPECT_EQ("", value);
+        value = "b";
+        return true;
+    }));
+    EXPECT_TRUE(storage.GetExpire("NONE", found));
+    EXPECT_EQ(0, found);
+    storage.Stop();
+}
+
+TEST(StorageTest, TieredScan) {
+    TieredLRU storage(64 * 1024, "/tmp", 16 * 1024 * 1024, 1024, 256 * 1024);
+    storage.Start();
+
+    // Every other key is expired, both in memory and on disk since the older ones are demoted
+    std::set<std::string> live;
+    for (long i = 0; i < 200; ++i) {
+        std::string key = "KEY" + std::to_string(1000 + i);
+        EXPECT_TRUE(storage.Put(key, std::string(4000, 'a'), i % 2 ? 1 : 0));
+        if (i % 2 == 0) {
+            live.insert(key);
+        }
+    }
+    EXPECT_NE("0", find_stat(storage, "tier_demotions"));
+
+    std::vector<std::string> keys;
+    scan_all(storage, 3, keys);
+    EXPECT_EQ(live.size(), keys.size());
+    EXPECT_EQ(live, std::set<std::string>(keys.begin(), keys.end()));
+    storage.Stop();
+}
+
+TEST(StorageTest, LazyFlush) {
+    SimpleLRU storage(64);
+    std::vector<std::string> evicted;
+    storage.set_eviction_callback(
+        [&evicted](const std::string &key, const std::string &value, int64_t deadline) { evicted.push_back(key); });
+
+    std::string value;
+    for (long i = 0; i < 4; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(12, 'a')));
+    }
+
+    // Flushed entries are reclaimed by new ones, but that isn't an eviction
+    storage.Flush(0);
+    EXPECT_FALSE(storage.Get("KEY0", value));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val"));
+    for (long i = 10; i < 13; ++i) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(12, 'b')));
+    }
+    EXPECT_TRUE(evicted.empty());
+    EXPECT_EQ("0", find_stat(storage, "evictions"));
+
+    std::string cursor;
+    std::vector<std::string> keys;
+    EXPECT_TRUE(storage.Scan(cursor, 100, keys));
+    EXPECT_EQ(std::vector<std::string>({"KEY1", "KEY10", "KEY11", "KEY12"}), keys);
+
+    // Delayed flush takes everything existing at the given moment, including values written
+    // after the flush itself
+    storage.Flush(std::time(nullptr) + 1);
+    EXPECT_TRUE(storage.Get("KEY10", value));
+    EXPECT_TRUE(storage.Put("KEY13", "val"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_FALSE(storage.Get("KEY10", value));
+    EXPECT_FALSE(storage.Get("KEY13", value));
+
+    // Immediate flush cancels pending one
+    EXPECT_TRUE(storage.Put("KEY14", "val"));
+    storage.Flush(std::time(nullptr) + 1000);
+    storage.Flush(0);
+    EXPECT_TRUE(storage.Put("KEY15", "val"));
+    EXPECT_FALSE(storage.Get("KEY14", value));
+    EXPECT_TRUE(storage.Get("KEY15", value));
+}